@@ -0,0 +1,163 @@
+//Qt
+#include <QDebug>
+#include <QDateTime>
+
+#include "alertwriter.h"
+
+bool AlertWriter::open(const QString &fileName, bool withHistory)
+{
+    _withHistory = withHistory;
+
+    bool isOpen = false;
+    if (fileName == "-")
+    {
+        isOpen = _file.open(stdout, QIODevice::WriteOnly);
+    }
+    else
+    {
+        _file.setFileName(fileName);
+        isOpen = _file.open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+
+    if (!isOpen)
+    {
+        qDebug() << "Cannot open alert output:" << fileName << _file.errorString();
+
+        return false;
+    }
+
+    return true;
+}
+
+void AlertWriter::write(const QString &user, const QList<KLineData> &klines)
+{
+    const auto detectTime = QDateTime::currentDateTime().toString(Qt::ISODateWithMs);
+
+    _buffer.resize(0); //емкость буфера сохраняется
+
+    for (const auto& klineData: klines)
+    {
+        //история от новых свечей к старым: первая свеча - обнаруженная
+        const auto& kline = klineData.history.first();
+
+        _buffer.append("{\"User\":");
+        appendString(user);
+        _buffer.append(",\"DetectTime\":");
+        appendString(detectTime);
+        _buffer.append(",\"StockExchange\":");
+        appendString(klineData.stockExchangeID.name);
+        _buffer.append(",\"Delta\":");
+        appendDouble(klineData.delta);
+        _buffer.append(",\"Volume\":");
+        appendDouble(klineData.volume);
+        _buffer.append(",\"KLine\":");
+        appendKLine(kline);
+
+        if (_withHistory)
+        {
+            appendHistory("History", klineData.history);
+            appendHistory("ReviewHistory", klineData.reviewHistory);
+        }
+
+        _buffer.append("}\n");
+    }
+
+    _eventCount += klines.size();
+
+    if (_file.write(_buffer) != _buffer.size())
+    {
+        qDebug() << "Alert output error:" << _file.errorString();
+    }
+
+    _file.flush();
+}
+
+quint64 AlertWriter::eventCount() const
+{
+    return _eventCount;
+}
+
+void AlertWriter::appendKLine(const KLine &kline)
+{
+    _buffer.append("{\"Money\":");
+    appendString(kline.id.symbol);
+    _buffer.append(",\"Interval\":");
+    appendString(KLineTypeToString(kline.id.type));
+    _buffer.append(",\"OpenTime\":");
+    _buffer.append(QByteArray::number(kline.openTime.toMSecsSinceEpoch()));
+    _buffer.append(",\"CloseTime\":");
+    _buffer.append(QByteArray::number(kline.closeTime.toMSecsSinceEpoch()));
+    _buffer.append(",\"Open\":");
+    appendDouble(kline.open);
+    _buffer.append(",\"High\":");
+    appendDouble(kline.high);
+    _buffer.append(",\"Low\":");
+    appendDouble(kline.low);
+    _buffer.append(",\"Close\":");
+    appendDouble(kline.close);
+    _buffer.append(",\"Volume\":");
+    appendDouble(kline.volume);
+    _buffer.append(",\"QuoteAssetVolume\":");
+    appendDouble(kline.quoteAssetVolume);
+    _buffer.append('}');
+}
+
+void AlertWriter::appendHistory(const char *name, const KLines &history)
+{
+    _buffer.append(",\"");
+    _buffer.append(name);
+    _buffer.append("\":[");
+
+    for (qsizetype i = 0; i < history.size(); ++i)
+    {
+        if (i != 0)
+        {
+            _buffer.append(',');
+        }
+
+        appendKLine(history.at(i));
+    }
+
+    _buffer.append(']');
+}
+
+void AlertWriter::appendString(const QString &value)
+{
+    _buffer.append('"');
+
+    for (const auto ch: value.toUtf8())
+    {
+        switch (ch)
+        {
+        case '"': _buffer.append("\\\""); break;
+        case '\\': _buffer.append("\\\\"); break;
+        case '\n': _buffer.append("\\n"); break;
+        case '\r': _buffer.append("\\r"); break;
+        case '\t': _buffer.append("\\t"); break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20)
+            {
+                _buffer.append(QString("\\u%1").arg(static_cast<int>(ch), 4, 16, QChar('0')).toLatin1());
+            }
+            else
+            {
+                _buffer.append(ch);
+            }
+        }
+    }
+
+    _buffer.append('"');
+}
+
+void AlertWriter::appendDouble(double value)
+{
+    //JSON не допускает nan и inf
+    if (!qIsFinite(value))
+    {
+        _buffer.append("null");
+
+        return;
+    }
+
+    _buffer.append(QByteArray::number(value, 'g', 15));
+}
@@ -0,0 +1,39 @@
+#ifndef ALERTWRITER_H
+#define ALERTWRITER_H
+
+//Qt
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+
+#include "types.h"
+
+//Потоковая запись событий в формате JSON Lines: одна строка на событие.
+//События не накапливаются - память не зависит от количества записанных событий
+class AlertWriter
+{
+public:
+    AlertWriter() = default;
+
+    bool open(const QString& fileName, bool withHistory); //"-" - стандартный вывод
+    void write(const QString& user, const QList<KLineData>& klines); //записывает пакет событий и сбрасывает буфер
+
+    quint64 eventCount() const;
+
+private:
+    Q_DISABLE_COPY_MOVE(AlertWriter)
+
+    void appendKLine(const KLine& kline);
+    void appendHistory(const char *name, const KLines& history);
+    void appendString(const QString& value);
+    void appendDouble(double value);
+
+private:
+    QFile _file;
+    bool _withHistory = false; //записывать истории свечей целиком
+    QByteArray _buffer; //строки текущего пакета, память переиспользуется между пакетами
+    quint64 _eventCount = 0;
+};
+
+#endif // ALERTWRITER_H
@@ -0,0 +1,177 @@
+//Qt
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QFile>
+#include <QList>
+#include <QTimer>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include "session.h"
+#include "filter.h"
+#include "httpsquery.h"
+
+#include "alertwriter.h"
+
+static const int STATISTIC_INTERVAL = 60000; //ms
+
+//фильтр в формате экспорта клиента ({"Filter": [...]}) или массив правил
+static bool loadFilter(const QString& fileName, Filter& filter)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Cannot open filter:" << fileName << file.errorString();
+
+        return false;
+    }
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        qDebug() << "Error parsing filter:" << fileName << error.errorString();
+
+        return false;
+    }
+
+    filter.fromJSON(doc.isArray() ? doc.array() : doc.object()["Filter"].toArray());
+    if (filter.isError())
+    {
+        qDebug() << "Filter:" << filter.errorString();
+
+        return false;
+    }
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCoreApplication::setApplicationName("TradingCatAlertDaemon");
+    QCoreApplication::setOrganizationName("Cat software development");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Keeps TradingCat sessions alive and writes detection events as JSON lines");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("server", "Server URL.", "url", "https://tradingcat.ru"));
+    parser.addOption(QCommandLineOption("account", "Existing account as <user>:<password>. May be repeated.", "account"));
+    parser.addOption(QCommandLineOption("sessions", "Number of sessions with newly registered users.", "count", "0"));
+    parser.addOption(QCommandLineOption("filter", "Filter applied to every session after login (JSON export of the client).", "file"));
+    parser.addOption(QCommandLineOption("output", "Output file, '-' for stdout.", "file", "-"));
+    parser.addOption(QCommandLineOption("with-history", "Write full candle histories of each event."));
+    parser.addOption(QCommandLineOption("replay", "Take server answers from <file> recorded with the client --capture option.", "file"));
+    parser.addOption(QCommandLineOption("replay-speed", "Replay speed: 1 - real time, N - N times faster, 0 - as fast as possible.", "speed", "1"));
+    parser.process(a);
+
+    if (parser.isSet("replay") && !Common::HTTPSQuery::startReplay(parser.value("replay"), parser.value("replay-speed").toDouble()))
+    {
+        return 1;
+    }
+
+    Filter filter;
+    const auto isFilterSet = parser.isSet("filter");
+    if (isFilterSet && !loadFilter(parser.value("filter"), filter))
+    {
+        return 1;
+    }
+
+    AlertWriter writer;
+    if (!writer.open(parser.value("output"), parser.isSet("with-history")))
+    {
+        return 1;
+    }
+
+    //учетные записи: существующие и новые (пустой пользователь - регистрация)
+    QList<QPair<QString, QString>> accounts;
+    for (const auto& account: parser.values("account"))
+    {
+        const auto pos = account.indexOf(':');
+        if (pos <= 0)
+        {
+            qDebug() << "Account must be <user>:<password>:" << account;
+
+            return 1;
+        }
+
+        accounts.push_back({account.left(pos), account.mid(pos + 1)});
+    }
+
+    auto newSessionCount = parser.value("sessions").toInt();
+    if (accounts.isEmpty() && newSessionCount <= 0)
+    {
+        newSessionCount = 1;
+    }
+
+    for (int i = 0; i < newSessionCount; ++i)
+    {
+        accounts.push_back({QString(), QString()});
+    }
+
+    QList<Session*> sessions;
+    for (const auto& account: accounts)
+    {
+        auto session = new Session(parser.value("server"));
+
+        QObject::connect(session, &Session::credentialsChanged, session,
+            [](const QString& user, const QString& password)
+            {
+                //чтобы перезапуск продолжил с теми же пользователями
+                qDebug() << "NEW USER: use --account" << QString("%1:%2").arg(user).arg(password);
+            });
+
+        QObject::connect(session, &Session::loggedIn, session,
+            [session, isFilterSet, &filter]()
+            {
+                qDebug() << "Login successfully as:" << session->user();
+
+                if (isFilterSet)
+                {
+                    session->setFilter(filter);
+                    session->flushConfig();
+                }
+            });
+
+        QObject::connect(session, &Session::eventsReceived, session,
+            [session, &writer](const QList<KLineData>& klines)
+            {
+                writer.write(session->user(), klines);
+            });
+
+        QObject::connect(session, &Session::messagesReceived, session,
+            [session](const QStringList& messages)
+            {
+                for (const auto& message: messages)
+                {
+                    qDebug() << session->user() << "MESSAGE:" << message;
+                }
+            });
+
+        session->start(account.first, account.second);
+
+        sessions.push_back(session);
+    }
+
+    QTimer statisticTimer;
+    QObject::connect(&statisticTimer, &QTimer::timeout, &statisticTimer,
+        [&writer, &sessions]()
+        {
+            qsizetype onlineCount = 0;
+            for (const auto session: sessions)
+            {
+                onlineCount += session->isOnline() ? 1 : 0;
+            }
+
+            qDebug() << "Sessions online:" << onlineCount << "of" << sessions.size() << "Events written:" << writer.eventCount();
+        });
+    statisticTimer.start(STATISTIC_INTERVAL);
+
+    const auto result = a.exec();
+
+    qDeleteAll(sessions);
+
+    return result;
+}
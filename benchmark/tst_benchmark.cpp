@@ -0,0 +1,652 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QtTest>
+#include <QApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QTimer>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QXmlStreamReader>
+#include <QSysInfo>
+
+#include "Common/common.h"
+
+#include "types.h"
+#include "filter.h"
+#include "dataparser.h"
+#include "spikedetector.h"
+#include "klineindicators.h"
+#include "session.h"
+#include "klinechartview.h"
+#include "klinechartwidget.h"
+
+using namespace Common;
+
+static const QStringList STOCK_EXCHANGES = {"MEXC", "KUCOIN", "GATE", "BYBIT", "BINANCE"};
+static const qsizetype EVENT_HISTORY_SIZE = 60; //свечей в истории события ответа /data
+static const qsizetype INDICATOR_KLINE_COUNT = 2000000; //свечей в замере индикаторов
+static const qsizetype INDICATOR_RING_SIZE = 4096; //разных свечей в замере индикаторов, дальше они повторяются
+static const int FRAME_INTERVAL = 16; //ms кадр 60 Гц
+static const int BURST_TIMEOUT = 60000; //ms предельное время разбора пачки ответов
+static const QSize CHART_SIZE(1280, 600); //размер графиков в замерах отрисовки
+static const QList<KLineType> CATALOG_INTERVALS = {KLineType::MIN1, KLineType::MIN5, KLineType::MIN15, KLineType::MIN30, KLineType::MIN60,
+                                                   KLineType::HOUR4, KLineType::HOUR8, KLineType::DAY1, KLineType::WEEK1};
+
+Q_DECLARE_METATYPE(KLineIndicators::Type)
+
+//Замер времени горячих путей клиента на синтетических данных разного размера.
+//Запускается без сервера и без окна на экране (платформа offscreen)
+class ClientBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void stringToKLineType();
+
+    void deltaVolumeKLine_data();
+    void deltaVolumeKLine();
+
+    void filterFromJSON_data();
+    void filterFromJSON();
+    void filterToJSON_data();
+    void filterToJSON();
+
+    void parseData_data();
+    void parseData();
+
+    void spikeDetector_data();
+    void spikeDetector();
+
+    void indicators_data();
+    void indicators();
+
+    void frameTimeDataBurst_data();
+    void frameTimeDataBurst();
+
+    void parseKLines_data();
+    void parseKLines();
+
+    void chartView_data();
+    void chartView();
+
+    void longChart_data();
+    void longChart();
+
+private:
+    static KLines makeHistory(qsizetype size);
+    static QByteArray makeDataAnswer(qsizetype eventCount, qsizetype historySize);
+    static QByteArray makeKLinesAnswer(qsizetype moneyCount);
+    static QJsonArray makeFilter(qsizetype ruleCount);
+    static void addSizeRows(const QList<qsizetype>& sizes);
+};
+
+void ClientBenchmark::stringToKLineType()
+{
+    const QStringList types = {"1m", "5m", "15m", "30m", "60m", "4h", "8h", "1d", "1w", "bad"};
+
+    QBENCHMARK
+    {
+        volatile qint64 sum = 0;
+        for (const auto& type: types)
+        {
+            sum += static_cast<qint64>(::stringToKLineType(type));
+        }
+    }
+}
+
+void ClientBenchmark::deltaVolumeKLine_data()
+{
+    addSizeRows({100, 10000});
+}
+
+void ClientBenchmark::deltaVolumeKLine()
+{
+    QFETCH(qsizetype, size);
+
+    const auto history = makeHistory(size);
+
+    QBENCHMARK
+    {
+        volatile double sum = 0.0;
+        for (const auto& kline: history)
+        {
+            sum += deltaKLine(kline) + volumeKLine(kline);
+        }
+    }
+}
+
+void ClientBenchmark::filterFromJSON_data()
+{
+    addSizeRows({10, 100, 1000});
+}
+
+void ClientBenchmark::filterFromJSON()
+{
+    QFETCH(qsizetype, size);
+
+    const auto jsonFilter = makeFilter(size);
+
+    QBENCHMARK
+    {
+        Filter filter;
+        filter.fromJSON(jsonFilter);
+    }
+}
+
+void ClientBenchmark::filterToJSON_data()
+{
+    addSizeRows({10, 100, 1000});
+}
+
+void ClientBenchmark::filterToJSON()
+{
+    QFETCH(qsizetype, size);
+
+    const Filter filter(makeFilter(size));
+
+    QBENCHMARK
+    {
+        volatile auto count = filter.toJSON().count();
+    }
+}
+
+void ClientBenchmark::parseData_data()
+{
+    addSizeRows({1, 10, 100, 1000});
+}
+
+void ClientBenchmark::parseData()
+{
+    QFETCH(qsizetype, size);
+
+    const auto data = makeDataAnswer(size, EVENT_HISTORY_SIZE);
+
+    QBENCHMARK
+    {
+        const auto result = DataParser::parseData(data);
+        QCOMPARE(result.status, DataParser::Status::OK);
+    }
+}
+
+void ClientBenchmark::spikeDetector_data()
+{
+    addSizeRows({1000, 10000});
+}
+
+void ClientBenchmark::spikeDetector()
+{
+    //такт локального поиска: обновление последней свечи каждого инструмента и проверка порогов
+    QFETCH(qsizetype, size);
+
+    const auto kline = makeHistory(1).first();
+    const StockExchangeID stockExchangeID{"BINANCE"};
+
+    Filter::FilterDataList filterDataList;
+    KLines klines;
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        auto instrumentKLine = kline;
+        instrumentKLine.id.symbol = QString("MONEY%1USDT").arg(i);
+        klines.push_back(std::move(instrumentKLine));
+
+        Filter::FilterData filterData;
+        filterData.stockExchangeID = stockExchangeID;
+        filterData.klineID = klines.last().id;
+        filterData.delta = 5.0;
+        filterData.volume = 1000000.0;
+        filterDataList.push_back(std::move(filterData));
+    }
+
+    SpikeDetector spikeDetector;
+    spikeDetector.setFilter(filterDataList);
+
+    QBENCHMARK
+    {
+        for (const auto& instrumentKLine: klines)
+        {
+            spikeDetector.addKLine(stockExchangeID, instrumentKLine);
+        }
+
+        volatile auto count = spikeDetector.detect().size();
+    }
+}
+
+void ClientBenchmark::indicators_data()
+{
+    QTest::addColumn<KLineIndicators::Type>("type");
+
+    QTest::newRow("SMA") << KLineIndicators::Type::SMA;
+    QTest::newRow("EMA") << KLineIndicators::Type::EMA;
+    QTest::newRow("BOLLINGER") << KLineIndicators::Type::BOLLINGER;
+    QTest::newRow("VWAP") << KLineIndicators::Type::VWAP;
+    QTest::newRow("RSI") << KLineIndicators::Type::RSI;
+    QTest::newRow("ATR") << KLineIndicators::Type::ATR;
+}
+
+void ClientBenchmark::indicators()
+{
+    //пропускная способность инкрементального расчета. Стоимость добавления свечи не зависит
+    //от самой свечи - небольшой набор повторяется по кругу
+    QFETCH(KLineIndicators::Type, type);
+
+    auto klines = makeHistory(INDICATOR_RING_SIZE);
+    std::reverse(klines.begin(), klines.end());
+
+    QBENCHMARK
+    {
+        KLineIndicators indicators(type);
+        for (qsizetype i = 0; i < INDICATOR_KLINE_COUNT; ++i)
+        {
+            indicators.append(klines[i % klines.size()]);
+        }
+
+        //результат используется - компилятор не может выбросить расчет
+        QVERIFY(indicators.size() > INDICATOR_KLINE_COUNT - KLineIndicators::PERIOD);
+    }
+}
+
+void ClientBenchmark::frameTimeDataBurst_data()
+{
+    QTest::addColumn<qsizetype>("answerCount");
+    QTest::addColumn<qsizetype>("eventCount");
+
+    QTest::newRow("10x100") << qsizetype(10) << qsizetype(100);
+    QTest::newRow("50x100") << qsizetype(50) << qsizetype(100);
+    QTest::newRow("10x1000") << qsizetype(10) << qsizetype(1000);
+}
+
+void ClientBenchmark::frameTimeDataBurst()
+{
+    //пачка ответов /data приходит сразу. Результат - самый длинный промежуток между кадрами
+    //цикла событий, пока DataParser разбирает пачку (как в Session)
+    QFETCH(qsizetype, answerCount);
+    QFETCH(qsizetype, eventCount);
+
+    const auto data = makeDataAnswer(eventCount, EVENT_HISTORY_SIZE);
+
+    QObject context;
+    DataParser dataParser(&context);
+
+    QEventLoop loop;
+
+    QElapsedTimer frameTime;
+    qint64 maxFrameTime = 0;
+
+    QTimer frameTimer;
+    frameTimer.setTimerType(Qt::PreciseTimer);
+    frameTimer.setInterval(FRAME_INTERVAL);
+    QObject::connect(&frameTimer, &QTimer::timeout, &context,
+        [&frameTime, &maxFrameTime]()
+        {
+            maxFrameTime = std::max(maxFrameTime, frameTime.restart());
+        });
+
+    QTimer::singleShot(BURST_TIMEOUT, &loop, &QEventLoop::quit);
+
+    //кадры считаются с постановки пачки: без рабочего потока разбор идет прямо в parse()
+    frameTime.start();
+    frameTimer.start();
+
+    qsizetype parsedCount = 0;
+    qsizetype klineCount = 0;
+    for (qsizetype i = 0; i < answerCount; ++i)
+    {
+        dataParser.parse(data,
+            [&](DataParser::Result&& result)
+            {
+                klineCount += result.klines.size();
+
+                if (++parsedCount == answerCount)
+                {
+                    loop.quit();
+                }
+            });
+    }
+
+    if (parsedCount < answerCount)
+    {
+        loop.exec();
+    }
+
+    frameTimer.stop();
+
+    //промежуток после последнего кадра тоже занят разбором
+    maxFrameTime = std::max(maxFrameTime, frameTime.elapsed());
+
+    QCOMPARE(parsedCount, answerCount);
+    QCOMPARE(klineCount, answerCount * eventCount);
+
+    QTest::setBenchmarkResult(maxFrameTime, QTest::WalltimeMilliseconds);
+}
+
+void ClientBenchmark::parseKLines_data()
+{
+    addSizeRows({10, 100, 1000});
+}
+
+void ClientBenchmark::parseKLines()
+{
+    //ответ /klines: монет на каждой бирже по каждому интервалу. Тот же разбор, что в Session::parseKLines(), без сигнала
+    QFETCH(qsizetype, size);
+
+    const auto data = makeKLinesAnswer(size);
+
+    Session session("http://localhost");
+
+    QBENCHMARK
+    {
+        const auto json = QJsonDocument::fromJson(data).object();
+        session.applyCatalog(json["KLines"].toArray());
+    }
+
+    QCOMPARE(session.catalog().size(), STOCK_EXCHANGES.size());
+}
+
+void ClientBenchmark::chartView_data()
+{
+    QTest::addColumn<qsizetype>("size");
+    QTest::addColumn<KLineIndicators::Type>("type");
+
+    //до 1000 свечей история рисуется QtCharts, длинные истории - KLineChartWidget
+    for (const qsizetype size: {60, 500, 999})
+    {
+        QTest::newRow(QByteArray::number(size).constData()) << size << KLineIndicators::Type::NONE;
+    }
+
+    QTest::newRow("500 BOLLINGER") << qsizetype(500) << KLineIndicators::Type::BOLLINGER;
+}
+
+void ClientBenchmark::chartView()
+{
+    //смена события на графике: заполнение серий и осей и отрисовка кадра
+    QFETCH(qsizetype, size);
+    QFETCH(KLineIndicators::Type, type);
+
+    //две истории по очереди - наборы свечей обновляются на месте, как при переключении событий
+    const QList<KLines> histories = {makeHistory(size), makeHistory(size - 1)};
+
+    QList<KLineIndicators> indicators;
+    for (const auto& history: histories)
+    {
+        indicators.push_back(KLineIndicators::make(type, history));
+    }
+
+    KLineChartView chartView(0.7, 0.5, true);
+    chartView.setAttribute(Qt::WA_DontShowOnScreen);
+    chartView.resize(CHART_SIZE);
+    chartView.show();
+
+    qsizetype index = 0;
+    QBENCHMARK
+    {
+        chartView.setKLines("BINANCE BTCUSDT", histories[index], type != KLineIndicators::Type::NONE ? &indicators[index] : nullptr);
+        const auto image = chartView.toImage();
+        QVERIFY(!image.isNull());
+
+        index = 1 - index;
+    }
+}
+
+void ClientBenchmark::longChart_data()
+{
+    addSizeRows({5000, 100000, 1000000});
+}
+
+void ClientBenchmark::longChart()
+{
+    //длинная история: стоимость отрисовки зависит от ширины графика, а не от количества свечей
+    QFETCH(qsizetype, size);
+
+    const auto history = makeHistory(size);
+
+    QBENCHMARK
+    {
+        const auto image = KLineChartWidget::render(history, "BINANCE BTCUSDT", CHART_SIZE);
+        QVERIFY(!image.isNull());
+    }
+}
+
+KLines ClientBenchmark::makeHistory(qsizetype size)
+{
+    const auto interval = static_cast<qint64>(KLineType::MIN1);
+    const auto now = QDateTime::currentMSecsSinceEpoch() / interval * interval;
+
+    KLines result;
+    result.reserve(size);
+
+    //от новых свечей к старым, как в ответе сервера
+    double price = 100.0;
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        KLine kline;
+        kline.id.symbol = "BTCUSDT";
+        kline.id.type = KLineType::MIN1;
+        kline.openTime = QDateTime::fromMSecsSinceEpoch(now - i * interval);
+        kline.closeTime = QDateTime::fromMSecsSinceEpoch(now - i * interval + interval - 1);
+        kline.open = price;
+        kline.close = price * (i % 2 == 0 ? 1.01 : 0.99);
+        kline.high = std::max(kline.open, kline.close) * 1.005;
+        kline.low = std::min(kline.open, kline.close) * 0.995;
+        kline.volume = 1000.0 + i % 100;
+        kline.quoteAssetVolume = kline.volume * price;
+
+        price = kline.close;
+
+        result.push_back(std::move(kline));
+    }
+
+    return result;
+}
+
+QByteArray ClientBenchmark::makeDataAnswer(qsizetype eventCount, qsizetype historySize)
+{
+    const auto history = makeHistory(historySize);
+
+    QJsonArray jsonHistory;
+    for (const auto& kline: history)
+    {
+        QJsonObject jsonKLine;
+        jsonKLine.insert("Money", kline.id.symbol);
+        jsonKLine.insert("Interval", KLineTypeToString(kline.id.type));
+        jsonKLine.insert("OpenTime", kline.openTime.toString(DATETIME_FORMAT));
+        jsonKLine.insert("CloseTime", kline.closeTime.toString(DATETIME_FORMAT));
+        jsonKLine.insert("Open", kline.open);
+        jsonKLine.insert("Close", kline.close);
+        jsonKLine.insert("High", kline.high);
+        jsonKLine.insert("Low", kline.low);
+        jsonKLine.insert("Volume", kline.volume);
+        jsonKLine.insert("QuoteAssetVolume", kline.quoteAssetVolume);
+
+        jsonHistory.push_back(jsonKLine);
+    }
+
+    QJsonObject event;
+    event.insert("StockExchange", "MEXC");
+    event.insert("Delta", deltaKLine(history.first()));
+    event.insert("Volume", volumeKLine(history.first()));
+    event.insert("History", jsonHistory);
+    event.insert("ReviewHistory", jsonHistory);
+
+    QJsonArray events;
+    for (qsizetype i = 0; i < eventCount; ++i)
+    {
+        events.push_back(event);
+    }
+
+    QJsonObject json;
+    json.insert("Result", "OK");
+    json.insert("DetectKLines", events);
+
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+QByteArray ClientBenchmark::makeKLinesAnswer(qsizetype moneyCount)
+{
+    QJsonArray klines;
+
+    for (const auto& stockExchange: STOCK_EXCHANGES)
+    {
+        for (qsizetype money = 0; money < moneyCount; ++money)
+        {
+            for (const auto interval: CATALOG_INTERVALS)
+            {
+                QJsonObject kline;
+                kline.insert("StockExchange", stockExchange);
+                kline.insert("Money", QString("COIN%1USDT").arg(money));
+                kline.insert("Interval", KLineTypeToString(interval));
+
+                klines.push_back(kline);
+            }
+        }
+    }
+
+    QJsonObject json;
+    json.insert("Result", "OK");
+    json.insert("KLines", klines);
+
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+QJsonArray ClientBenchmark::makeFilter(qsizetype ruleCount)
+{
+    QJsonArray result;
+
+    for (qsizetype i = 0; i < ruleCount; ++i)
+    {
+        QJsonObject rule;
+        rule.insert("StockExchange", STOCK_EXCHANGES.at(i % STOCK_EXCHANGES.size()));
+        rule.insert("Money", QString("COIN%1USDT").arg(i));
+        rule.insert("Interval", "1m");
+        rule.insert("Delta", 2.0 + i % 10);
+        rule.insert("Volume", 500.0 + i);
+
+        result.push_back(rule);
+    }
+
+    return result;
+}
+
+void ClientBenchmark::addSizeRows(const QList<qsizetype> &sizes)
+{
+    QTest::addColumn<qsizetype>("size");
+
+    for (const auto size: sizes)
+    {
+        QTest::newRow(QByteArray::number(size).constData()) << size;
+    }
+}
+
+//переводит результаты замеров из XML QtTest в JSON для сравнения запусков
+static bool writeJSON(const QString& XMLFileName, const QString& JSONFileName)
+{
+    QFile XMLFile(XMLFileName);
+    if (!XMLFile.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Cannot read benchmark results:" << XMLFileName << XMLFile.errorString();
+
+        return false;
+    }
+
+    QJsonArray results;
+    QString testFunction;
+
+    QXmlStreamReader XML(&XMLFile);
+    while (!XML.atEnd())
+    {
+        if (XML.readNext() != QXmlStreamReader::StartElement)
+        {
+            continue;
+        }
+
+        const auto attributes = XML.attributes();
+        if (XML.name() == QLatin1String("TestFunction"))
+        {
+            testFunction = attributes.value("name").toString();
+        }
+        else if (XML.name() == QLatin1String("BenchmarkResult"))
+        {
+            QJsonObject result;
+            result.insert("Name", testFunction);
+            result.insert("Tag", attributes.value("tag").toString());
+            result.insert("Metric", attributes.value("metric").toString());
+            result.insert("Value", attributes.value("value").toDouble());
+            result.insert("Iterations", attributes.value("iterations").toInt());
+
+            results.push_back(result);
+        }
+    }
+
+    if (XML.hasError())
+    {
+        qDebug() << "Cannot parse benchmark results:" << XMLFileName << XML.errorString();
+
+        return false;
+    }
+
+    QJsonObject json;
+    json.insert("Date", QDateTime::currentDateTime().toString(Qt::ISODate));
+    json.insert("Qt", QString(qVersion()));
+    json.insert("CPU", QSysInfo::currentCpuArchitecture());
+    json.insert("OS", QSysInfo::prettyProductName());
+    json.insert("Results", results);
+
+    QFile JSONFile(JSONFileName);
+    if (!JSONFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot write benchmark results:" << JSONFileName << JSONFile.errorString();
+
+        return false;
+    }
+
+    JSONFile.write(QJsonDocument(json).toJson(QJsonDocument::Indented));
+
+    return true;
+}
+
+int main(int argc, char *argv[])
+{
+    //окно не нужно. Платформу нужно выбрать до создания QApplication
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication app(argc, argv);
+
+    //--json <file> - результаты в JSON, остальные аргументы передаются QtTest
+    QStringList arguments = app.arguments();
+    QString JSONFileName;
+
+    const auto JSONIndex = arguments.indexOf("--json");
+    if (JSONIndex > 0 && JSONIndex + 1 < arguments.size())
+    {
+        JSONFileName = arguments.at(JSONIndex + 1);
+        arguments.remove(JSONIndex, 2);
+    }
+
+    QTemporaryDir XMLDir;
+    const auto XMLFileName = XMLDir.filePath("results.xml");
+    if (!JSONFileName.isEmpty())
+    {
+        arguments << "-o" << QString("%1,xml").arg(XMLFileName) << "-o" << "-,txt";
+    }
+
+    ClientBenchmark benchmark;
+
+    const auto result = QTest::qExec(&benchmark, arguments);
+
+    if (!JSONFileName.isEmpty() && !writeJSON(XMLFileName, JSONFileName))
+    {
+        return 1;
+    }
+
+    return result;
+}
+
+#include "tst_benchmark.moc"
@@ -0,0 +1,140 @@
+//Qt
+#include <QDebug>
+#include <QDir>
+#include <QStandardPaths>
+
+#include "configstorage.h"
+
+#ifdef __EMSCRIPTEN__
+using namespace emscripten;
+#endif
+
+static const QString CONFIG_FILE_NAME = "TraidingCatBot.ini";
+
+#ifdef __EMSCRIPTEN__
+//IDBFS монтируется в /offline, содержимое подгружается из IndexedDB браузера
+EM_ASYNC_JS(void, mountOfflineFS, (), {
+    try { FS.mkdir('/offline'); } catch (err) {}
+    FS.mount(IDBFS, {}, '/offline');
+    await new Promise((resolve) => FS.syncfs(true, resolve));
+});
+
+//localStorage.setItem() бросает исключение JS (QuotaExceededError при переполнении), которое
+//не перехватывается в C++ - без try/catch оно прерывает приложение. Возвращает false при ошибке
+EM_JS(bool, setLocalStorageItem, (const char* key, const char* value), {
+    try
+    {
+        window.localStorage.setItem(UTF8ToString(key), UTF8ToString(value));
+
+        return true;
+    }
+    catch (err)
+    {
+        console.warn("localStorage.setItem: " + err.name + ": " + err.message);
+
+        return false;
+    }
+});
+#endif
+
+ConfigStorage *ConfigStorage::make()
+{
+#if defined(__EMSCRIPTEN__) && !defined(TRADINGCAT_OFFLINE_CONFIG)
+    return new LocalStorageConfigStorage();
+#else
+    return new FileConfigStorage(offlineDir() + "/" + CONFIG_FILE_NAME);
+#endif
+}
+
+QString ConfigStorage::offlineDir()
+{
+#ifdef __EMSCRIPTEN__
+    static bool isMounted = false;
+    if (!isMounted)
+    {
+        mountOfflineFS();
+        isMounted = true;
+    }
+
+    return QStringLiteral("/offline");
+#else
+    //каталог данных пользователя, а не текущий каталог процесса: он может быть недоступен для записи
+    //или меняться от запуска к запуску. Имя приложения задается в main() до первого вызова
+    static const QString dirName = []()
+    {
+        const auto result = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+        if (!QDir().mkpath(result))
+        {
+            qDebug() << "Cannot create directory" << result;
+        }
+
+        return result;
+    }();
+
+    return dirName;
+#endif
+}
+
+void ConfigStorage::syncOfflineDir()
+{
+#ifdef __EMSCRIPTEN__
+    //сбрасываем IDBFS в IndexedDB
+    MAIN_THREAD_EM_ASM(FS.syncfs(false, function(err) {}););
+#endif
+}
+
+#ifdef __EMSCRIPTEN__
+LocalStorageConfigStorage::LocalStorageConfigStorage()
+{
+    _localStorage = val::global("window")["localStorage"];
+}
+
+QString LocalStorageConfigStorage::load(const QString &key)
+{
+    const std::string keyString = key.toStdString();
+    const emscripten::val value = _localStorage.call<val>("getItem", keyString);
+    if (value.isNull())
+    {
+        return "";
+    }
+
+    return QString::fromStdString(value.as<std::string>());
+}
+
+void LocalStorageConfigStorage::save(const Values &values)
+{
+    for (auto values_it = values.begin(); values_it != values.end(); ++values_it)
+    {
+        const std::string keyString = values_it.key().toStdString();
+        const std::string valueString = values_it.value().toStdString();
+
+        //значение не записано - остальные значения все равно пробуем записать
+        if (!setLocalStorageItem(keyString.c_str(), valueString.c_str()))
+        {
+            qDebug() << "Cannot save local config value" << values_it.key() << "(" << valueString.size() << "bytes): localStorage quota exceeded or storage disabled";
+        }
+    }
+}
+#endif
+
+FileConfigStorage::FileConfigStorage(const QString &fileName)
+    : _settings(fileName, QSettings::IniFormat)
+{
+}
+
+QString FileConfigStorage::load(const QString &key)
+{
+    return _settings.value(key).toString();
+}
+
+void FileConfigStorage::save(const Values &values)
+{
+    for (auto values_it = values.begin(); values_it != values.end(); ++values_it)
+    {
+        _settings.setValue(values_it.key(), values_it.value());
+    }
+
+    _settings.sync();
+
+    syncOfflineDir();
+}
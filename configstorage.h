@@ -0,0 +1,60 @@
+#ifndef CONFIGSTORAGE_H
+#define CONFIGSTORAGE_H
+
+#include <QString>
+#include <QHash>
+#include <QSettings>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#include <emscripten/val.h>
+#endif
+
+//Хранилище локальных настроек
+class ConfigStorage
+{
+public:
+    using Values = QHash<QString, QString>;
+
+public:
+    virtual ~ConfigStorage() = default;
+
+    virtual QString load(const QString& key) = 0;
+    virtual void save(const Values& values) = 0; //сохраняет все значения за один раз
+
+    static ConfigStorage* make(); //хранилище для текущей сборки
+
+    //каталог постоянных данных: AppDataLocation, в WASM сборке - IDBFS /offline, монтируемая при первом вызове
+    static QString offlineDir();
+    static void syncOfflineDir(); //WASM: записывает изменения каталога в IndexedDB
+};
+
+#ifdef __EMSCRIPTEN__
+//window.localStorage браузера
+class LocalStorageConfigStorage final : public ConfigStorage
+{
+public:
+    LocalStorageConfigStorage();
+
+    QString load(const QString& key) override;
+    void save(const Values& values) override;
+
+private:
+    emscripten::val _localStorage;
+};
+#endif
+
+//Файл настроек. В WASM сборке файл лежит в IDBFS
+class FileConfigStorage final : public ConfigStorage
+{
+public:
+    explicit FileConfigStorage(const QString& fileName);
+
+    QString load(const QString& key) override;
+    void save(const Values& values) override;
+
+private:
+    QSettings _settings;
+};
+
+#endif // CONFIGSTORAGE_H
@@ -0,0 +1,200 @@
+//Qt
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonParseError>
+
+#include "Common/common.h"
+
+#include "tracer.h"
+
+#include "dataparser.h"
+
+using namespace Common;
+
+//в однопоточной сборке WASM (TRADINGCAT_WASM_THREADS=OFF или Qt без потоков) рабочих потоков нет - разбираем сразу
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define DATAPARSER_USE_THREADS
+#endif
+
+DataParser::DataParser(QObject *context, QThreadPool *pool /* = nullptr */)
+    : _state(std::make_shared<State>())
+    , _pool(pool != nullptr ? pool : &_ownPool)
+{
+    Q_CHECK_PTR(context);
+
+    _state->context = context;
+
+    //ответы должны обрабатываться в порядке поступления
+    _ownPool.setMaxThreadCount(1);
+}
+
+DataParser::~DataParser()
+{
+    //задачи не ждем: еще не начатые пропускают разбор, выполняющиеся не передают результат.
+    //Мьютекс дожидается только задачи, которая прямо сейчас ставит результат в очередь context
+    QMutexLocker<QMutex> locker(&_state->mutex);
+
+    _state->isCanceled = true;
+}
+
+void DataParser::parse(const QByteArray &data, const ResultCallback &callback)
+{
+    ++_state->inProgressCount;
+
+#ifdef DATAPARSER_USE_THREADS
+    _pool->start(
+        [state = _state, data, callback]()
+        {
+            {
+                QMutexLocker<QMutex> locker(&state->mutex);
+
+                if (state->isCanceled)
+                {
+                    return;
+                }
+            }
+
+            auto result = std::make_shared<Result>(parseData(data));
+
+            QMutexLocker<QMutex> locker(&state->mutex);
+
+            if (state->isCanceled)
+            {
+                return;
+            }
+
+            QMetaObject::invokeMethod(state->context,
+                [state, result, callback]()
+                {
+                    //разборщик удален, а получатель еще жив
+                    if (state->isCanceled)
+                    {
+                        return;
+                    }
+
+                    --state->inProgressCount;
+
+                    callback(std::move(*result));
+                },
+                Qt::QueuedConnection);
+        });
+#else
+    auto result = parseData(data);
+
+    --_state->inProgressCount;
+
+    callback(std::move(result));
+#endif
+}
+
+qsizetype DataParser::inProgressCount() const
+{
+    return _state->inProgressCount;
+}
+
+DataParser::Result DataParser::parseData(const QByteArray &data)
+{
+    TRACE_SPAN("DataParser::parseData");
+
+    Result result;
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        result.status = Status::PARSE_ERROR;
+        result.message = error.errorString();
+
+        return result;
+    }
+
+    const auto json = doc.object();
+    const auto resultString = json["Result"].toString();
+    result.message = json["Message"].toString();
+
+    if (resultString == "LOGOUT")
+    {
+        result.status = Status::LOGOUT;
+
+        return result;
+    }
+    else if (resultString != "OK")
+    {
+        result.status = Status::SERVER_ERROR;
+
+        return result;
+    }
+
+    result.status = Status::OK;
+
+    const auto jsonKLineList = json["DetectKLines"].toArray();
+    result.klines.reserve(jsonKLineList.count());
+    for (int i = 0; i < jsonKLineList.count(); ++i)
+    {
+        KLineData klineData;
+        if (parseKLine(jsonKLineList.at(i).toObject(), klineData))
+        {
+            result.klines.emplaceBack(std::move(klineData));
+        }
+    }
+
+    if (json.contains("UserMessages"))
+    {
+        const auto messages = json["UserMessages"].toArray();
+        for (int i = 0; i < messages.count(); ++i)
+        {
+            const auto message = messages.at(i).toObject();
+            if (message["Level"].toString() == "INFO")
+            {
+                result.infoMessages.push_back(message["Message"].toString());
+            }
+        }
+    }
+
+    return result;
+}
+
+bool DataParser::parseKLine(const QJsonObject &jsonKLine, KLineData &klineData)
+{
+    klineData.stockExchangeID.name = jsonKLine["StockExchange"].toString();
+    klineData.delta = jsonKLine["Delta"].toDouble();
+    klineData.volume = jsonKLine["Volume"].toDouble();
+    klineData.history = parseHistory(jsonKLine["History"].toArray());
+
+    if (klineData.history.isEmpty())
+    {
+        qDebug() << "DATA: Event without history:" << jsonKLine;
+
+        return false;
+    }
+
+    klineData.reviewHistory = parseHistory(jsonKLine["ReviewHistory"].toArray());
+
+    return true;
+}
+
+KLines DataParser::parseHistory(const QJsonArray &history)
+{
+    KLines result;
+    result.reserve(history.count());
+
+    for (int i = 0; i < history.count(); ++i)
+    {
+        const auto jsonKLine = history.at(i).toObject();
+        KLine tmp;
+        tmp.id.symbol = jsonKLine["Money"].toString();
+        tmp.id.type = stringToKLineType(jsonKLine["Interval"].toString());
+        tmp.openTime = QDateTime::fromString(jsonKLine["OpenTime"].toString(), DATETIME_FORMAT);
+        tmp.closeTime = QDateTime::fromString(jsonKLine["CloseTime"].toString(), DATETIME_FORMAT);
+        tmp.open = jsonKLine["Open"].toDouble();
+        tmp.close = jsonKLine["Close"].toDouble();
+        tmp.high = jsonKLine["High"].toDouble();
+        tmp.low = jsonKLine["Low"].toDouble();
+        tmp.volume = jsonKLine["Volume"].toDouble();
+        tmp.quoteAssetVolume = jsonKLine["QuoteAssetVolume"].toDouble();
+
+        result.emplaceBack(std::move(tmp));
+    }
+
+    return result;
+}
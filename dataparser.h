@@ -0,0 +1,78 @@
+#ifndef DATAPARSER_H
+#define DATAPARSER_H
+
+//STL
+#include <functional>
+#include <memory>
+
+//Qt
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include <QList>
+#include <QThreadPool>
+#include <QMutex>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "types.h"
+
+//Разбор ответов /data вне GUI потока.
+//Рабочий поток превращает байты ответа в готовые KLineData, GUI поток получает только результат
+class DataParser
+{
+public:
+    enum class Status: quint8
+    {
+        OK = 0,
+        LOGOUT = 1,
+        SERVER_ERROR = 2,
+        PARSE_ERROR = 3
+    };
+
+    struct Result
+    {
+        Status status = Status::PARSE_ERROR;
+        QString message;
+        QList<KLineData> klines;
+        QStringList infoMessages;
+    };
+
+    using ResultCallback = std::function<void(Result&& result)>;
+
+public:
+    //pool - общий пул нескольких разборщиков (много сеансов в одном процессе), nullptr - свой пул из одного потока.
+    //В общем пуле порядок ответов не гарантируется: следующий ответ передается только после callback предыдущего
+    explicit DataParser(QObject *context, QThreadPool *pool = nullptr);
+    ~DataParser();
+
+    //разбирает data в рабочем потоке и вызывает callback в потоке context через очередь событий
+    void parse(const QByteArray& data, const ResultCallback& callback);
+    qsizetype inProgressCount() const; //количество ответов в разборе
+
+    static Result parseData(const QByteArray& data);
+
+private:
+    Q_DISABLE_COPY_MOVE(DataParser)
+
+    static bool parseKLine(const QJsonObject& jsonKLine, KLineData& klineData);
+    static KLines parseHistory(const QJsonArray& history);
+
+private:
+    //общие данные разборщика и его задач: задача в общем пуле может закончиться после удаления разборщика
+    struct State
+    {
+        QObject *context = nullptr; //получатель результатов (живет в GUI потоке)
+        QMutex mutex; //удерживается, пока задача передает результат в context
+        bool isCanceled = false; //разборщик удален - задачи не разбирают данные и не вызывают callback
+        qsizetype inProgressCount = 0; //только в потоке context
+    };
+
+private:
+    std::shared_ptr<State> _state;
+    QThreadPool _ownPool;
+    QThreadPool *_pool = nullptr; //_ownPool или общий пул
+};
+
+#endif // DATAPARSER_H
@@ -0,0 +1,384 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QDataStream>
+
+#include "configstorage.h"
+
+#include "eventlog.h"
+
+//в однопоточной сборке WASM рабочих потоков нет - пишем сразу
+#if !defined(__EMSCRIPTEN__) || defined(__EMSCRIPTEN_PTHREADS__)
+#define EVENTLOG_USE_THREADS
+#endif
+
+static const QString LOG_FILE_NAME = "events.log";
+static const QString INDEX_FILE_NAME = "events.idx";
+static const QString NEW_FILE_SUFFIX = ".new"; //файлы, собираемые при сжатии
+static const QString ROTATED_FILE_SUFFIX = ".1"; //предыдущее поколение журнала
+static const quint32 RECORD_MAGIC = 0x54434531; //"TCE1" - начало записи, версия формата 1
+static const qint64 RECORD_HEADER_SIZE = 4 + 4 + 2; //magic + размер данных + CRC16
+static const qint64 INDEX_ENTRY_SIZE = 8 + 4; //смещение + размер
+static const QDataStream::Version DATA_STREAM_VERSION = QDataStream::Qt_6_0; //формат журнала не зависит от версии Qt сборки
+static const qint64 MAX_LOG_SIZE = 16 * 1024 * 1024; //при превышении журнал сжимается
+static const qsizetype KEEP_EVENT_COUNT = 1000; //количество событий, остающихся после сжатия
+static const int FLUSH_DELAY = 2000; //ms задержка записи буфера после последнего события
+
+static void writeHistory(QDataStream& stream, const KLines& history)
+{
+    //все свечи истории одного интервала одной монеты - KLineID пишем один раз
+    stream << (history.isEmpty() ? QString() : history.first().id.symbol)
+           << static_cast<qint64>(history.isEmpty() ? KLineType::UNKNOW : history.first().id.type)
+           << static_cast<quint32>(history.size());
+
+    for (const auto& kline: history)
+    {
+        stream << kline.openTime.toMSecsSinceEpoch()
+               << kline.open << kline.high << kline.low << kline.close << kline.volume
+               << kline.closeTime.toMSecsSinceEpoch()
+               << kline.quoteAssetVolume;
+    }
+}
+
+static bool readHistory(QDataStream& stream, qint64 dataSize, KLines& history)
+{
+    QString symbol;
+    qint64 type = 0;
+    quint32 count = 0;
+    stream >> symbol >> type >> count;
+
+    //защита от испорченной записи: свеча занимает не меньше 8 чисел по 8 байт
+    if (stream.status() != QDataStream::Ok || static_cast<qint64>(count) * 8 * 8 > dataSize)
+    {
+        return false;
+    }
+
+    history.clear();
+    history.reserve(count);
+
+    for (quint32 i = 0; i < count; ++i)
+    {
+        KLine kline;
+        kline.id.symbol = symbol;
+        kline.id.type = static_cast<KLineType>(type);
+
+        qint64 openTime = 0;
+        qint64 closeTime = 0;
+        stream >> openTime
+               >> kline.open >> kline.high >> kline.low >> kline.close >> kline.volume
+               >> closeTime
+               >> kline.quoteAssetVolume;
+
+        kline.openTime = QDateTime::fromMSecsSinceEpoch(openTime);
+        kline.closeTime = QDateTime::fromMSecsSinceEpoch(closeTime);
+
+        history.push_back(std::move(kline));
+    }
+
+    return stream.status() == QDataStream::Ok;
+}
+
+EventLog::EventLog(QObject *context)
+    : _context(context)
+    , _dirName(ConfigStorage::offlineDir())
+{
+    Q_CHECK_PTR(_context);
+
+    //записи должны попадать в файл в порядке поступления
+    _pool.setMaxThreadCount(1);
+
+    _flushTimer.setSingleShot(true);
+    _flushTimer.setInterval(FLUSH_DELAY);
+    QObject::connect(&_flushTimer, &QTimer::timeout, [this](){ flush(); });
+}
+
+EventLog::~EventLog()
+{
+    flush();
+
+    _pool.waitForDone();
+
+    ConfigStorage::syncOfflineDir();
+}
+
+void EventLog::append(const KLineData &klineData)
+{
+    _records.push_back(makeRecord(klineData));
+
+    if (!_flushTimer.isActive())
+    {
+        _flushTimer.start();
+    }
+}
+
+void EventLog::flush()
+{
+    _flushTimer.stop();
+
+    if (_records.isEmpty())
+    {
+        return;
+    }
+
+    QList<QByteArray> records;
+    records.swap(_records);
+
+#ifdef EVENTLOG_USE_THREADS
+    _pool.start(
+        [dirName = _dirName, records, context = _context]()
+        {
+            writeRecords(dirName, records);
+
+            //FS.syncfs можно вызывать только из основного потока
+            QMetaObject::invokeMethod(context, [](){ ConfigStorage::syncOfflineDir(); }, Qt::QueuedConnection);
+        });
+#else
+    writeRecords(_dirName, records);
+
+    ConfigStorage::syncOfflineDir();
+#endif
+}
+
+QList<KLineData*> EventLog::restore(qsizetype count) const
+{
+    QList<KLineData*> result;
+
+    const auto index = readIndex(_dirName + "/" + INDEX_FILE_NAME, count);
+    if (index.isEmpty())
+    {
+        return result;
+    }
+
+    QFile logFile(_dirName + "/" + LOG_FILE_NAME);
+    if (!logFile.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Cannot open event log:" << logFile.fileName() << logFile.errorString();
+
+        return result;
+    }
+
+    const auto logSize = logFile.size();
+
+    result.reserve(index.size());
+    for (const auto& entry: index)
+    {
+        //запись за концом файла - журнал не был дописан до конца
+        if (entry.offset + entry.size > static_cast<quint64>(logSize) || !logFile.seek(entry.offset))
+        {
+            qDebug() << "Event log record out of range. Offset:" << entry.offset << "Size:" << entry.size;
+
+            continue;
+        }
+
+        auto klineData = new KLineData;
+        if (!parseRecord(logFile.read(entry.size), *klineData) || klineData->history.isEmpty())
+        {
+            qDebug() << "Event log record is corrupted. Offset:" << entry.offset;
+
+            delete klineData;
+
+            continue;
+        }
+
+        result.push_back(klineData);
+    }
+
+    return result;
+}
+
+QByteArray EventLog::makeRecord(const KLineData &klineData)
+{
+    QByteArray data;
+    QDataStream dataStream(&data, QIODevice::WriteOnly);
+    dataStream.setVersion(DATA_STREAM_VERSION);
+    dataStream << klineData.stockExchangeID.name << klineData.delta << klineData.volume;
+    writeHistory(dataStream, klineData.history);
+    writeHistory(dataStream, klineData.reviewHistory);
+
+    QByteArray record;
+    record.reserve(RECORD_HEADER_SIZE + data.size());
+
+    QDataStream recordStream(&record, QIODevice::WriteOnly);
+    recordStream.setVersion(DATA_STREAM_VERSION);
+    recordStream << RECORD_MAGIC << static_cast<quint32>(data.size()) << qChecksum(data);
+    recordStream.writeRawData(data.constData(), data.size());
+
+    return record;
+}
+
+bool EventLog::parseRecord(const QByteArray &record, KLineData &klineData)
+{
+    if (record.size() < RECORD_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    quint32 magic = 0;
+    quint32 dataSize = 0;
+    quint16 checksum = 0;
+
+    QDataStream recordStream(record);
+    recordStream.setVersion(DATA_STREAM_VERSION);
+    recordStream >> magic >> dataSize >> checksum;
+
+    if (magic != RECORD_MAGIC || static_cast<qint64>(dataSize) != record.size() - RECORD_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    const auto data = QByteArrayView(record).sliced(RECORD_HEADER_SIZE);
+    if (qChecksum(data) != checksum)
+    {
+        return false;
+    }
+
+    QDataStream dataStream(data.toByteArray());
+    dataStream.setVersion(DATA_STREAM_VERSION);
+    dataStream >> klineData.stockExchangeID.name >> klineData.delta >> klineData.volume;
+
+    return dataStream.status() == QDataStream::Ok
+           && readHistory(dataStream, dataSize, klineData.history)
+           && readHistory(dataStream, dataSize, klineData.reviewHistory);
+}
+
+void EventLog::writeRecords(const QString &dirName, const QList<QByteArray> &records)
+{
+    QDir().mkpath(dirName);
+
+    QFile logFile(dirName + "/" + LOG_FILE_NAME);
+    if (!logFile.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qDebug() << "Cannot open event log:" << logFile.fileName() << logFile.errorString();
+
+        return;
+    }
+
+    QByteArray indexData;
+    QDataStream indexStream(&indexData, QIODevice::WriteOnly);
+    indexStream.setVersion(DATA_STREAM_VERSION);
+
+    auto offset = static_cast<quint64>(logFile.size());
+    for (const auto& record: records)
+    {
+        if (logFile.write(record) != record.size())
+        {
+            qDebug() << "Error write event log:" << logFile.errorString();
+
+            break;
+        }
+
+        indexStream << offset << static_cast<quint32>(record.size());
+        offset += record.size();
+    }
+
+    //индекс пишется после данных: при сбое индекс не ссылается на недописанные записи
+    logFile.close();
+
+    QFile indexFile(dirName + "/" + INDEX_FILE_NAME);
+    if (!indexFile.open(QIODevice::WriteOnly | QIODevice::Append))
+    {
+        qDebug() << "Cannot open event log index:" << indexFile.fileName() << indexFile.errorString();
+
+        return;
+    }
+
+    indexFile.write(indexData);
+    indexFile.close();
+
+    if (static_cast<qint64>(offset) > MAX_LOG_SIZE)
+    {
+        compact(dirName);
+    }
+}
+
+QList<EventLog::IndexEntry> EventLog::readIndex(const QString &fileName, qsizetype count)
+{
+    QList<IndexEntry> result;
+
+    QFile indexFile(fileName);
+    if (!indexFile.open(QIODevice::ReadOnly))
+    {
+        return result;
+    }
+
+    //недописанная последняя запись индекса отбрасывается
+    const auto entryCount = indexFile.size() / INDEX_ENTRY_SIZE;
+    const auto first = std::max<qint64>(0, entryCount - count);
+    if (!indexFile.seek(first * INDEX_ENTRY_SIZE))
+    {
+        return result;
+    }
+
+    QDataStream indexStream(indexFile.read((entryCount - first) * INDEX_ENTRY_SIZE));
+    indexStream.setVersion(DATA_STREAM_VERSION);
+
+    result.reserve(entryCount - first);
+    for (auto i = first; i < entryCount; ++i)
+    {
+        IndexEntry entry;
+        indexStream >> entry.offset >> entry.size;
+        result.push_back(entry);
+    }
+
+    return result;
+}
+
+void EventLog::compact(const QString &dirName)
+{
+    const auto logFileName = dirName + "/" + LOG_FILE_NAME;
+    const auto indexFileName = dirName + "/" + INDEX_FILE_NAME;
+
+    const auto index = readIndex(indexFileName, KEEP_EVENT_COUNT);
+
+    QFile logFile(logFileName);
+    QFile newLogFile(logFileName + NEW_FILE_SUFFIX);
+    QFile newIndexFile(indexFileName + NEW_FILE_SUFFIX);
+    if (!logFile.open(QIODevice::ReadOnly)
+        || !newLogFile.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || !newIndexFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot compact event log:" << logFile.errorString() << newLogFile.errorString() << newIndexFile.errorString();
+
+        return;
+    }
+
+    QDataStream indexStream(&newIndexFile);
+    indexStream.setVersion(DATA_STREAM_VERSION);
+
+    quint64 offset = 0;
+    for (const auto& entry: index)
+    {
+        if (!logFile.seek(entry.offset))
+        {
+            continue;
+        }
+
+        const auto record = logFile.read(entry.size);
+        if (record.size() != entry.size)
+        {
+            continue;
+        }
+
+        newLogFile.write(record);
+        indexStream << offset << entry.size;
+        offset += entry.size;
+    }
+
+    logFile.close();
+    newLogFile.close();
+    newIndexFile.close();
+
+    //ротация: текущие файлы становятся предыдущим поколением, сжатые - текущими
+    for (const auto& fileName: {logFileName, indexFileName})
+    {
+        QFile::remove(fileName + ROTATED_FILE_SUFFIX);
+        QFile::rename(fileName, fileName + ROTATED_FILE_SUFFIX);
+        QFile::rename(fileName + NEW_FILE_SUFFIX, fileName);
+    }
+
+    qDebug() << "Event log compacted. Events:" << index.size() << "Size:" << offset;
+}
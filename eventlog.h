@@ -0,0 +1,53 @@
+#ifndef EVENTLOG_H
+#define EVENTLOG_H
+
+//Qt
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+#include <QList>
+#include <QThreadPool>
+#include <QTimer>
+
+#include "types.h"
+
+//Журнал событий в постоянном хранилище (IDBFS в WASM сборке).
+//События дописываются в конец двоичного файла, индекс хранит смещения записей,
+//поэтому при запуске читаются только последние записи без разбора JSON.
+//Запись, сжатие и ротация файлов выполняются в рабочем потоке
+class EventLog
+{
+public:
+    explicit EventLog(QObject *context);
+    ~EventLog();
+
+    void append(const KLineData& klineData); //добавляет событие в буфер записи
+    void flush(); //записывает буфер в файл
+
+    //читает последние count событий в порядке добавления. Владение передается вызывающему
+    QList<KLineData*> restore(qsizetype count) const;
+
+private:
+    Q_DISABLE_COPY_MOVE(EventLog)
+
+    struct IndexEntry
+    {
+        quint64 offset = 0; //смещение записи в журнале
+        quint32 size = 0;   //размер записи вместе с заголовком
+    };
+
+    static QByteArray makeRecord(const KLineData& klineData);
+    static bool parseRecord(const QByteArray& record, KLineData& klineData);
+    static void writeRecords(const QString& dirName, const QList<QByteArray>& records);
+    static QList<IndexEntry> readIndex(const QString& fileName, qsizetype count);
+    static void compact(const QString& dirName);
+
+private:
+    QObject *_context = nullptr; //поток, в котором вызывается синхронизация IDBFS
+    const QString _dirName;
+    QList<QByteArray> _records; //записи, ожидающие записи в файл
+    QTimer _flushTimer;
+    QThreadPool _pool;
+};
+
+#endif // EVENTLOG_H
@@ -1,3 +1,9 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QHash>
+#include <QStringView>
 #include <QJsonObject>
 #include <QJsonDocument>
 #include <QJsonArray>
@@ -5,6 +11,49 @@
 
 #include "filter.h"
 
+static QJsonObject filterDataToJSON(const Filter::FilterData& filterData)
+{
+    QJsonObject kline;
+
+    kline.insert("StockExchange", filterData.stockExchangeID.name);
+    kline.insert("Money", filterData.klineID.symbol);
+    kline.insert("Interval", KLineTypeToString(filterData.klineID.type));
+    kline.insert("Delta", filterData.delta);
+    kline.insert("Volume", filterData.volume);
+
+    return kline;
+}
+
+static QJsonArray filterDataListToJSON(const Filter::FilterDataList& filterDataList)
+{
+    QJsonArray json;
+    for (const auto& filterData: filterDataList)
+    {
+        json.push_back(filterDataToJSON(filterData));
+    }
+
+    return json;
+}
+
+static std::optional<QHash<Filter::FilterID, Filter::FilterData>> makeFilterIndex(const Filter::FilterDataList& filterDataList)
+{
+    QHash<Filter::FilterID, Filter::FilterData> result;
+    result.reserve(filterDataList.size());
+
+    for (const auto& filterData: filterDataList)
+    {
+        const Filter::FilterID id{filterData.stockExchangeID, filterData.klineID};
+        if (result.contains(id))
+        {
+            return std::nullopt;
+        }
+
+        result.insert(id, filterData);
+    }
+
+    return result;
+}
+
 
 Filter::Filter(const QJsonArray &JSONFilter)
 {
@@ -20,8 +69,17 @@ void Filter::fromJSON(const QJsonArray &JSONFilter)
 {
     clear();
 
+    _filterData.reserve(JSONFilter.count());
+
     for (int i = 0; i < JSONFilter.count(); ++i)
     {
+        if (!JSONFilter.at(i).isObject())
+        {
+            addError(QString("Filter rule #%1 is not an object").arg(i));
+
+            continue;
+        }
+
         const auto kline = JSONFilter.at(i).toObject();
 
         FilterData filterData;
@@ -31,27 +89,86 @@ void Filter::fromJSON(const QJsonArray &JSONFilter)
         filterData.delta = kline["Delta"].toDouble();
         filterData.volume = kline["Volume"].toDouble();
 
+        if (filterData.stockExchangeID.name.isEmpty() || filterData.klineID.symbol.isEmpty() || filterData.klineID.type == KLineType::UNKNOW)
+        {
+            addError(QString("Filter rule #%1 is incorrect: %2")
+                         .arg(i)
+                         .arg(QString(QJsonDocument(kline).toJson(QJsonDocument::Compact))));
+
+            continue;
+        }
+
         addFilter(filterData);
     }
 }
 
 QJsonArray Filter::toJSON() const
 {
-    QJsonArray json;
-    for (const auto& filterData: _filterData)
+    return filterDataListToJSON(_filterData);
+}
+
+void Filter::fromCSV(const QString &CSVFilter)
+{
+    clear();
+
+    const auto lines = QStringView(CSVFilter).split(u'\n');
+    _filterData.reserve(lines.size());
+
+    for (qsizetype lineNumber = 0; lineNumber < lines.size(); ++lineNumber)
     {
-        QJsonObject kline;
+        const auto line = lines.at(lineNumber).trimmed();
+        if (line.isEmpty() || line.startsWith(u"StockExchange"))
+        {
+            continue;
+        }
+
+        const auto fields = line.split(u',');
+        if (fields.size() != 5)
+        {
+            addError(QString("Line %1: expected 5 fields, got %2").arg(lineNumber + 1).arg(fields.size()));
+
+            continue;
+        }
 
-        kline.insert("StockExchange", filterData.stockExchangeID.name);
-        kline.insert("Money", filterData.klineID.symbol);
-        kline.insert("Interval", KLineTypeToString(filterData.klineID.type));
-        kline.insert("Delta", filterData.delta);
-        kline.insert("Volume", filterData.volume);
+        bool isDeltaOk = false;
+        bool isVolumeOk = false;
+
+        FilterData filterData;
+        filterData.stockExchangeID.name = fields.at(0).trimmed().toString();
+        filterData.klineID.symbol = fields.at(1).trimmed().toString();
+        filterData.klineID.type = stringToKLineType(fields.at(2).trimmed().toString());
+        filterData.delta = fields.at(3).trimmed().toDouble(&isDeltaOk);
+        filterData.volume = fields.at(4).trimmed().toDouble(&isVolumeOk);
 
-        json.push_back(kline);
+        if (filterData.stockExchangeID.name.isEmpty() || filterData.klineID.symbol.isEmpty() || filterData.klineID.type == KLineType::UNKNOW
+            || !isDeltaOk || !isVolumeOk)
+        {
+            addError(QString("Line %1 is incorrect: %2").arg(lineNumber + 1).arg(line.toString()));
+
+            continue;
+        }
+
+        addFilter(filterData);
     }
+}
 
-    return json;
+QString Filter::toCSV() const
+{
+    QString result;
+    result.reserve((_filterData.size() + 1) * 48);
+
+    result += "StockExchange,Money,Interval,Delta,Volume\n";
+    for (const auto& filterData: _filterData)
+    {
+        result += QString("%1,%2,%3,%4,%5\n")
+                      .arg(filterData.stockExchangeID.name)
+                      .arg(filterData.klineID.symbol)
+                      .arg(KLineTypeToString(filterData.klineID.type))
+                      .arg(QString::number(filterData.delta, 'g', 17)) //без потери точности при повторном импорте
+                      .arg(QString::number(filterData.volume, 'g', 17));
+    }
+
+    return result;
 }
 
 void Filter::fromList(const FilterDataList &filterDataList)
@@ -74,6 +191,187 @@ void Filter::clear()
     _filterData.clear();
 }
 
+void Filter::applyDiff(const QJsonObject &JSONDiff)
+{
+    const Filter added(JSONDiff["Added"].toArray());
+    const Filter changed(JSONDiff["Changed"].toArray());
+    const Filter removed(JSONDiff["Removed"].toArray());
+
+    for (const auto& filter: {&added, &changed, &removed})
+    {
+        if (filter->isError())
+        {
+            addError(filter->_errorString);
+        }
+    }
+
+    const auto isSameKey = [](const FilterData& filterData1, const FilterData& filterData2)
+    {
+        return filterData1.stockExchangeID == filterData2.stockExchangeID && filterData1.klineID == filterData2.klineID;
+    };
+
+    for (const auto& filterData: removed._filterData)
+    {
+        _filterData.removeIf([&](const FilterData& current){ return isSameKey(current, filterData); });
+    }
+
+    for (const auto& filterData: changed._filterData)
+    {
+        const auto filterData_it = std::find_if(_filterData.begin(), _filterData.end(),
+                                                [&](const FilterData& current){ return isSameKey(current, filterData); });
+        if (filterData_it == _filterData.end())
+        {
+            addError(QString("Changed rule not found: %1 %2 %3")
+                         .arg(filterData.stockExchangeID.name)
+                         .arg(filterData.klineID.symbol)
+                         .arg(KLineTypeToString(filterData.klineID.type)));
+
+            _filterData.push_back(filterData);
+
+            continue;
+        }
+
+        *filterData_it = filterData;
+    }
+
+    for (const auto& filterData: added._filterData)
+    {
+        _filterData.push_back(filterData);
+    }
+}
+
+std::optional<Filter::FilterDiff> Filter::diff(const Filter &filter) const
+{
+    const auto oldIndex = makeFilterIndex(_filterData);
+    const auto newIndex = makeFilterIndex(filter._filterData);
+    if (!oldIndex.has_value() || !newIndex.has_value())
+    {
+        return std::nullopt;
+    }
+
+    FilterDiff result;
+    for (const auto& filterData: filter._filterData)
+    {
+        const auto oldIndex_it = oldIndex->find(Filter::FilterID{filterData.stockExchangeID, filterData.klineID});
+        if (oldIndex_it == oldIndex->end())
+        {
+            result.added.push_back(filterData);
+        }
+        else if (!(oldIndex_it.value() == filterData))
+        {
+            result.changed.push_back(filterData);
+        }
+    }
+
+    for (const auto& filterData: _filterData)
+    {
+        if (!newIndex->contains(Filter::FilterID{filterData.stockExchangeID, filterData.klineID}))
+        {
+            result.removed.push_back(filterData);
+        }
+    }
+
+    return result;
+}
+
+qsizetype Filter::normalize(const ExistsStockExchange &existKLines)
+{
+    const auto oldCount = _filterData.size();
+
+    //rule1 перекрывает rule2, если срабатывает на всех свечах, на которых срабатывает rule2
+    const auto isCovered = [](const FilterData& rule1, const FilterData& rule2)
+    {
+        return rule1.delta <= rule2.delta && rule1.volume <= rule2.volume;
+    };
+
+    //проверка по списку существующих монет и группировка по ключу с удалением дубликатов
+    QList<FilterID> order;
+    QHash<FilterID, FilterDataList> groups;
+    groups.reserve(_filterData.size());
+
+    for (const auto& filterData: _filterData)
+    {
+        if (!existKLines.isEmpty())
+        {
+            const auto stockExchange_it = existKLines.find(filterData.stockExchangeID.name);
+            if (stockExchange_it == existKLines.end())
+            {
+                addError(QString("Unsupport stock exchange: %1. Rule removed").arg(filterData.stockExchangeID.name));
+
+                continue;
+            }
+
+            const auto money_it = stockExchange_it.value().find(filterData.klineID.symbol);
+            if (money_it == stockExchange_it.value().end() && filterData.klineID.symbol != "ALL")
+            {
+                addError(QString("Unsupport money: %1 on %2. Rule removed").arg(filterData.klineID.symbol).arg(filterData.stockExchangeID.name));
+
+                continue;
+            }
+
+            if (money_it != stockExchange_it.value().end() && !money_it.value().contains(KLineTypeToString(filterData.klineID.type)))
+            {
+                addError(QString("Unsupport interval: %1 for %2 on %3. Rule removed")
+                             .arg(KLineTypeToString(filterData.klineID.type))
+                             .arg(filterData.klineID.symbol)
+                             .arg(filterData.stockExchangeID.name));
+
+                continue;
+            }
+        }
+
+        const FilterID id{filterData.stockExchangeID, filterData.klineID};
+        auto groups_it = groups.find(id);
+        if (groups_it == groups.end())
+        {
+            order.push_back(id);
+            groups.insert(id, FilterDataList{filterData});
+
+            continue;
+        }
+
+        auto& group = groups_it.value();
+        if (std::any_of(group.begin(), group.end(), [&](const FilterData& rule){ return isCovered(rule, filterData); }))
+        {
+            continue;
+        }
+
+        group.removeIf([&](const FilterData& rule){ return isCovered(filterData, rule); });
+        group.push_back(filterData);
+    }
+
+    //удаляем правила конкретных монет, перекрытые правилом ALL той же биржи и интервала
+    FilterDataList result;
+    result.reserve(_filterData.size());
+
+    for (const auto& id: order)
+    {
+        const auto& group = groups[id];
+        if (id.klineID.symbol == "ALL")
+        {
+            result.append(group);
+
+            continue;
+        }
+
+        const auto allGroup_it = groups.find(FilterID{id.stockExchangeID, KLineID{"ALL", id.klineID.type}});
+        for (const auto& filterData: group)
+        {
+            if (allGroup_it != groups.end()
+                && std::any_of(allGroup_it->begin(), allGroup_it->end(), [&](const FilterData& rule){ return isCovered(rule, filterData); }))
+            {
+                continue;
+            }
+
+            result.push_back(filterData);
+        }
+    }
+
+    _filterData = std::move(result);
+
+    return oldCount - _filterData.size();
+}
+
 QString Filter::errorString()
 {
     const QString tmp = _errorString;
@@ -86,3 +384,46 @@ bool Filter::isError() const
 {
     return !_errorString.isEmpty();
 }
+
+void Filter::addError(const QString &msg)
+{
+    if (!_errorString.isEmpty())
+    {
+        _errorString += "\n";
+    }
+
+    _errorString += msg;
+}
+
+bool Filter::FilterDiff::isEmpty() const
+{
+    return added.isEmpty() && changed.isEmpty() && removed.isEmpty();
+}
+
+QJsonObject Filter::FilterDiff::toJSON() const
+{
+    QJsonObject json;
+    json.insert("Added", filterDataListToJSON(added));
+    json.insert("Changed", filterDataListToJSON(changed));
+    json.insert("Removed", filterDataListToJSON(removed));
+
+    return json;
+}
+
+size_t qHash(const Filter::FilterID &key, size_t seed)
+{
+    return qHash(key.stockExchangeID, seed) + 31 * qHash(key.klineID, seed);
+}
+
+bool operator==(const Filter::FilterID &key1, const Filter::FilterID &key2)
+{
+    return (key1.stockExchangeID == key2.stockExchangeID) && (key1.klineID == key2.klineID);
+}
+
+bool operator==(const Filter::FilterData &filterData1, const Filter::FilterData &filterData2)
+{
+    return (filterData1.stockExchangeID == filterData2.stockExchangeID)
+           && (filterData1.klineID == filterData2.klineID)
+           && (filterData1.delta == filterData2.delta)
+           && (filterData1.volume == filterData2.volume);
+}
@@ -1,7 +1,13 @@
 #ifndef FILTER_H
 #define FILTER_H
 
+//STL
+#include <optional>
+
+//Qt
 #include <QString>
+#include <QJsonObject>
+#include <QJsonArray>
 
 #include "types.h"
 
@@ -18,6 +24,22 @@ public:
 
     using FilterDataList = QList<FilterData>;
 
+    struct FilterID //ключ правила фильтра
+    {
+        StockExchangeID stockExchangeID;
+        KLineID klineID;
+    };
+
+    struct FilterDiff //изменения фильтра относительно ранее отправленного
+    {
+        FilterDataList added;
+        FilterDataList changed;
+        FilterDataList removed;
+
+        bool isEmpty() const;
+        QJsonObject toJSON() const;
+    };
+
 public:
     Filter() = default;
     explicit Filter(const QJsonArray& JSONFilter);
@@ -26,19 +48,39 @@ public:
 
     void fromJSON(const QJsonArray& JSONFilter);
     QJsonArray toJSON() const;
+    void fromCSV(const QString& CSVFilter);
+    QString toCSV() const;
     void fromList(const FilterDataList& filterDataList);
     const FilterDataList& toList() const;
 
     void addFilter(const FilterData& filterData);
     void clear();
 
+    //возвращает изменения, которые нужно применить к этому фильтру, чтобы получить filter
+    //std::nullopt - если в одном из фильтров есть правила с одинаковым ключом и разность построить нельзя
+    std::optional<FilterDiff> diff(const Filter& filter) const;
+
+    //применяет изменения в формате FilterDiff::toJSON()
+    void applyDiff(const QJsonObject& JSONDiff);
+
+    //удаляет правила для несуществующих монет, дубликаты и правила, перекрытые более общими правилами
+    //возвращает количество удаленных правил
+    qsizetype normalize(const ExistsStockExchange& existKLines);
+
     QString errorString();
     bool isError() const;
 
+private:
+    void addError(const QString& msg);
+
 private:
     FilterDataList _filterData;
 
     QString _errorString;
 };
 
+size_t qHash(const Filter::FilterID& key, size_t seed);
+bool operator==(const Filter::FilterID& key1, const Filter::FilterID& key2);
+bool operator==(const Filter::FilterData& filterData1, const Filter::FilterData& filterData2);
+
 #endif // FILTER_H
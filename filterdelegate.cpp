@@ -0,0 +1,174 @@
+#include <QDebug>
+#include <QComboBox>
+#include <QDoubleSpinBox>
+
+#include "filtermodel.h"
+
+#include "filterdelegate.h"
+
+FilterDelegate::FilterDelegate(const ExistsStockExchange& existKLines, QObject *parent)
+    : QStyledItemDelegate{parent}
+    , _existKLines(existKLines)
+{
+}
+
+QWidget *FilterDelegate::createEditor(QWidget *parent, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    switch (index.column())
+    {
+    case FilterModel::Column::STOCK_EXCHANGE:
+    {
+        auto stockExchangeComboBox = new QComboBox(parent);
+        stockExchangeComboBox->setEditable(false);
+
+        for (auto existKLines_it = _existKLines.begin(); existKLines_it != _existKLines.end(); ++existKLines_it)
+        {
+            stockExchangeComboBox->addItem(FilterModel::stockExchangeIcon(existKLines_it.key()), existKLines_it.key());
+        }
+
+        return stockExchangeComboBox;
+    }
+    case FilterModel::Column::MONEY:
+    {
+        auto moneyComboBox = new QComboBox(parent);
+        moneyComboBox->setEditable(false);
+
+        const auto stockExchange = index.siblingAtColumn(FilterModel::Column::STOCK_EXCHANGE).data(Qt::EditRole).toString();
+        const auto currentStockExchange_it = _existKLines.find(stockExchange);
+        if (currentStockExchange_it != _existKLines.end())
+        {
+            const auto& moneyList = currentStockExchange_it.value();
+            for (auto moneyList_it = moneyList.begin(); moneyList_it != moneyList.end(); ++moneyList_it)
+            {
+                moneyComboBox->addItem(moneyList_it.key());
+            }
+        }
+
+        return moneyComboBox;
+    }
+    case FilterModel::Column::INTERVAL:
+    {
+        auto intervalComboBox = new QComboBox(parent);
+        intervalComboBox->setEditable(false);
+
+        const auto stockExchange = index.siblingAtColumn(FilterModel::Column::STOCK_EXCHANGE).data(Qt::EditRole).toString();
+        const auto money = index.siblingAtColumn(FilterModel::Column::MONEY).data(Qt::EditRole).toString();
+        const auto currentStockExchange_it = _existKLines.find(stockExchange);
+        if (currentStockExchange_it != _existKLines.end())
+        {
+            const auto& moneyList = currentStockExchange_it.value();
+            const auto currentMoneyList_it = moneyList.find(money);
+            if (currentMoneyList_it != moneyList.end())
+            {
+                const auto& intervalList = currentMoneyList_it.value();
+                for (auto intervalList_it = intervalList.begin(); intervalList_it != intervalList.end(); ++intervalList_it)
+                {
+                    intervalComboBox->addItem(*intervalList_it);
+                }
+            }
+        }
+
+        return intervalComboBox;
+    }
+    case FilterModel::Column::DELTA:
+    {
+        auto deltaSpinBox = new QDoubleSpinBox(parent);
+        deltaSpinBox->setMinimum(2);
+        deltaSpinBox->setMaximum(1000000);
+        deltaSpinBox->setSpecialValueText("MINIMUM");
+
+        return deltaSpinBox;
+    }
+    case FilterModel::Column::VOLUME:
+    {
+        auto volumeSpinBox = new QDoubleSpinBox(parent);
+        volumeSpinBox->setMinimum(500);
+        volumeSpinBox->setMaximum(1000000);
+        volumeSpinBox->setSingleStep(100.0);
+        volumeSpinBox->setSpecialValueText("MINIMUM");
+
+        return volumeSpinBox;
+    }
+    default:
+        break;
+    }
+
+    return QStyledItemDelegate::createEditor(parent, option, index);
+}
+
+void FilterDelegate::setEditorData(QWidget *editor, const QModelIndex &index) const
+{
+    const auto value = index.data(Qt::EditRole);
+
+    switch (index.column())
+    {
+    case FilterModel::Column::STOCK_EXCHANGE:
+    case FilterModel::Column::MONEY:
+    case FilterModel::Column::INTERVAL:
+    {
+        auto comboBox = static_cast<QComboBox*>(editor);
+        const auto currentIndex = comboBox->findText(value.toString());
+        if (currentIndex != -1)
+        {
+            comboBox->setCurrentIndex(currentIndex);
+
+            return;
+        }
+
+        if (index.column() == FilterModel::Column::STOCK_EXCHANGE)
+        {
+            qDebug() << "Unsupport stock exchange:" << value.toString() << ". Set MEXC";
+            comboBox->setCurrentText("MEXC");
+        }
+        else if (index.column() == FilterModel::Column::MONEY)
+        {
+            qDebug() << "Unsupport money:" << value.toString() << ". Set ALL";
+            comboBox->setCurrentText("ALL");
+        }
+        else
+        {
+            qDebug() << "Unsupport interval:" << value.toString() << ". Set 1min";
+            comboBox->setCurrentText(KLineTypeToString(KLineType::MIN1));
+        }
+
+        break;
+    }
+    case FilterModel::Column::DELTA:
+    case FilterModel::Column::VOLUME:
+        static_cast<QDoubleSpinBox*>(editor)->setValue(value.toDouble());
+        break;
+    default:
+        QStyledItemDelegate::setEditorData(editor, index);
+        break;
+    }
+}
+
+void FilterDelegate::setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex &index) const
+{
+    switch (index.column())
+    {
+    case FilterModel::Column::STOCK_EXCHANGE:
+    case FilterModel::Column::MONEY:
+    case FilterModel::Column::INTERVAL:
+        model->setData(index, static_cast<QComboBox*>(editor)->currentText(), Qt::EditRole);
+        break;
+    case FilterModel::Column::DELTA:
+    case FilterModel::Column::VOLUME:
+    {
+        auto spinBox = static_cast<QDoubleSpinBox*>(editor);
+        spinBox->interpretText();
+        model->setData(index, spinBox->value(), Qt::EditRole);
+        break;
+    }
+    default:
+        QStyledItemDelegate::setModelData(editor, model, index);
+        break;
+    }
+}
+
+void FilterDelegate::updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+    Q_UNUSED(index);
+
+    editor->setGeometry(option.rect);
+}
@@ -0,0 +1,25 @@
+#ifndef FILTERDELEGATE_H
+#define FILTERDELEGATE_H
+
+#include <QStyledItemDelegate>
+
+#include "types.h"
+
+//Редактор ячеек таблицы фильтра. Виджет создается только для редактируемой ячейки
+class FilterDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+
+public:
+    explicit FilterDelegate(const ExistsStockExchange& existKLines, QObject *parent = nullptr);
+
+    QWidget* createEditor(QWidget *parent, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    void setEditorData(QWidget *editor, const QModelIndex& index) const override;
+    void setModelData(QWidget *editor, QAbstractItemModel *model, const QModelIndex& index) const override;
+    void updateEditorGeometry(QWidget *editor, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+
+private:
+    const ExistsStockExchange& _existKLines; // список существующих монет
+};
+
+#endif // FILTERDELEGATE_H
@@ -0,0 +1,97 @@
+#include "filtermatcher.h"
+
+FilterMatcher::FilterMatcher(const Filter::FilterDataList &filterDataList)
+{
+    compile(filterDataList);
+}
+
+void FilterMatcher::compile(const Filter::FilterDataList &filterDataList)
+{
+    clear();
+
+    for (const auto& filterData: filterDataList)
+    {
+        _rules[filterData.stockExchangeID.name][filterData.klineID.symbol][filterData.klineID.type].push_back(filterData);
+    }
+}
+
+void FilterMatcher::clear()
+{
+    _rules.clear();
+}
+
+bool FilterMatcher::isEmpty() const
+{
+    return _rules.isEmpty();
+}
+
+const Filter::FilterData* FilterMatcher::match(const StockExchangeID &stockExchangeID, const KLine &kline) const
+{
+    const auto stockExchangeRules_it = _rules.find(stockExchangeID.name);
+    if (stockExchangeRules_it == _rules.end())
+    {
+        return nullptr;
+    }
+
+    const double delta = deltaKLine(kline);
+    const double volume = volumeKLine(kline);
+
+    //сначала правила для конкретной монеты, затем общие правила биржи
+    for (const auto& money: {kline.id.symbol, QString("ALL")})
+    {
+        const auto rules = findRules(stockExchangeRules_it.value(), money, kline.id.type);
+        if (rules == nullptr)
+        {
+            continue;
+        }
+
+        for (const auto& filterData: *rules)
+        {
+            if (delta >= filterData.delta && volume >= filterData.volume)
+            {
+                return &filterData;
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+Filter::FilterDataList FilterMatcher::rules(const StockExchangeID &stockExchangeID, const KLineID &id) const
+{
+    Filter::FilterDataList result;
+
+    const auto stockExchangeRules_it = _rules.find(stockExchangeID.name);
+    if (stockExchangeRules_it == _rules.end())
+    {
+        return result;
+    }
+
+    for (const auto& money: {id.symbol, QString("ALL")})
+    {
+        const auto rules = findRules(stockExchangeRules_it.value(), money, id.type);
+        if (rules != nullptr)
+        {
+            result.append(*rules);
+        }
+    }
+
+    return result;
+}
+
+const Filter::FilterDataList* FilterMatcher::findRules(const MoneyRules &moneyRules, const QString &money, KLineType type) const
+{
+    const auto moneyRules_it = moneyRules.find(money);
+    if (moneyRules_it == moneyRules.end())
+    {
+        return nullptr;
+    }
+
+    const auto intervalRules_it = moneyRules_it.value().find(type);
+    if (intervalRules_it == moneyRules_it.value().end())
+    {
+        return nullptr;
+    }
+
+    return &intervalRules_it.value();
+}
@@ -0,0 +1,39 @@
+#ifndef FILTERMATCHER_H
+#define FILTERMATCHER_H
+
+#include <QHash>
+#include <QString>
+
+#include "types.h"
+#include "filter.h"
+
+//Скомпилированный фильтр: индекс биржа -> монета (или ALL) -> интервал для локальной проверки свечей
+class FilterMatcher
+{
+public:
+    FilterMatcher() = default;
+    explicit FilterMatcher(const Filter::FilterDataList& filterDataList);
+
+    void compile(const Filter::FilterDataList& filterDataList);
+    void clear();
+    bool isEmpty() const;
+
+    //возвращает правило, которому удовлетворяет свеча, или nullptr
+    const Filter::FilterData* match(const StockExchangeID& stockExchangeID, const KLine& kline) const;
+
+    //все правила для свечей инструмента: сначала правила монеты, затем общие правила биржи
+    Filter::FilterDataList rules(const StockExchangeID& stockExchangeID, const KLineID& id) const;
+
+private:
+    using IntervalRules = QHash<KLineType, Filter::FilterDataList>;
+    using MoneyRules = QHash<QString, IntervalRules>;
+    using StockExchangeRules = QHash<QString, MoneyRules>;
+
+private:
+    const Filter::FilterDataList* findRules(const MoneyRules& moneyRules, const QString& money, KLineType type) const;
+
+private:
+    StockExchangeRules _rules;
+};
+
+#endif // FILTERMATCHER_H
@@ -0,0 +1,248 @@
+#include "filtermodel.h"
+
+FilterModel::FilterModel(QObject *parent)
+    : QAbstractTableModel{parent}
+{
+}
+
+void FilterModel::setFilterList(const Filter::FilterDataList &filterDataList)
+{
+    beginResetModel();
+
+    _filterData = filterDataList;
+    ++_version;
+
+    endResetModel();
+}
+
+const Filter::FilterDataList &FilterModel::filterList() const
+{
+    return _filterData;
+}
+
+void FilterModel::addFilter(const Filter::FilterData &filterData)
+{
+    const auto row = _filterData.size();
+
+    beginInsertRows(QModelIndex(), row, row);
+
+    _filterData.push_back(filterData);
+    ++_version;
+
+    endInsertRows();
+}
+
+void FilterModel::removeFilter(int row)
+{
+    if (row < 0 || row >= _filterData.size())
+    {
+        return;
+    }
+
+    beginRemoveRows(QModelIndex(), row, row);
+
+    _filterData.removeAt(row);
+    ++_version;
+
+    endRemoveRows();
+}
+
+quint64 FilterModel::version() const
+{
+    return _version;
+}
+
+QIcon FilterModel::stockExchangeIcon(const QString &stockExchange)
+{
+    if (stockExchange == "MEXC")
+    {
+        return QIcon(":/icon/img/MEXC.ico");
+    }
+    else if (stockExchange == "KUCOIN")
+    {
+        return QIcon(":/icon/img/kucoin.png");
+    }
+    else if (stockExchange == "GATE")
+    {
+        return QIcon(":/icon/img/gate.png");
+    }
+    else if (stockExchange == "BYBIT")
+    {
+        return QIcon(":/icon/img/bybit.png");
+    }
+    else if (stockExchange == "BINANCE")
+    {
+        return QIcon(":/icon/img/binance.png");
+    }
+
+    return QIcon();
+}
+
+int FilterModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return _filterData.size();
+}
+
+int FilterModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+    {
+        return 0;
+    }
+
+    return Column::COUNT;
+}
+
+QVariant FilterModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= _filterData.size())
+    {
+        return QVariant();
+    }
+
+    const auto& filterData = _filterData.at(index.row());
+
+    if (role == Qt::DecorationRole && index.column() == Column::STOCK_EXCHANGE)
+    {
+        return stockExchangeIcon(filterData.stockExchangeID.name);
+    }
+
+    if (role != Qt::DisplayRole && role != Qt::EditRole)
+    {
+        return QVariant();
+    }
+
+    switch (index.column())
+    {
+    case Column::STOCK_EXCHANGE:
+        return filterData.stockExchangeID.name;
+    case Column::MONEY:
+        return filterData.klineID.symbol;
+    case Column::INTERVAL:
+        return filterData.klineID.type != KLineType::UNKNOW ? KLineTypeToString(filterData.klineID.type) : QString();
+    case Column::DELTA:
+        return filterData.delta;
+    case Column::VOLUME:
+        return filterData.volume;
+    default:
+        Q_ASSERT(false);
+        break;
+    }
+
+    return QVariant();
+}
+
+bool FilterModel::setData(const QModelIndex &index, const QVariant &value, int role)
+{
+    if (!index.isValid() || index.row() >= _filterData.size() || role != Qt::EditRole)
+    {
+        return false;
+    }
+
+    auto& filterData = _filterData[index.row()];
+
+    switch (index.column())
+    {
+    case Column::STOCK_EXCHANGE:
+    {
+        const auto stockExchange = value.toString();
+        if (filterData.stockExchangeID.name == stockExchange)
+        {
+            return false;
+        }
+
+        //при смене биржи список монет другой - сбрасываем монету на ALL
+        filterData.stockExchangeID.name = stockExchange;
+        filterData.klineID.symbol = "ALL";
+        ++_version;
+
+        emit dataChanged(index, index.siblingAtColumn(Column::MONEY));
+
+        return true;
+    }
+    case Column::MONEY:
+        if (filterData.klineID.symbol == value.toString())
+        {
+            return false;
+        }
+        filterData.klineID.symbol = value.toString();
+        break;
+    case Column::INTERVAL:
+        if (filterData.klineID.type == stringToKLineType(value.toString()))
+        {
+            return false;
+        }
+        filterData.klineID.type = stringToKLineType(value.toString());
+        break;
+    case Column::DELTA:
+        if (filterData.delta == value.toDouble())
+        {
+            return false;
+        }
+        filterData.delta = value.toDouble();
+        break;
+    case Column::VOLUME:
+        if (filterData.volume == value.toDouble())
+        {
+            return false;
+        }
+        filterData.volume = value.toDouble();
+        break;
+    default:
+        Q_ASSERT(false);
+
+        return false;
+    }
+
+    ++_version;
+
+    emit dataChanged(index, index);
+
+    return true;
+}
+
+Qt::ItemFlags FilterModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+    {
+        return Qt::NoItemFlags;
+    }
+
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable | Qt::ItemIsEditable;
+}
+
+QVariant FilterModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    if (orientation == Qt::Vertical)
+    {
+        return section + 1;
+    }
+
+    switch (section)
+    {
+    case Column::STOCK_EXCHANGE:
+        return "Stock exchange";
+    case Column::MONEY:
+        return "Money";
+    case Column::INTERVAL:
+        return "Interval";
+    case Column::DELTA:
+        return "Delta";
+    case Column::VOLUME:
+        return "Volume";
+    default:
+        break;
+    }
+
+    return QVariant();
+}
@@ -0,0 +1,49 @@
+#ifndef FILTERMODEL_H
+#define FILTERMODEL_H
+
+#include <QAbstractTableModel>
+#include <QIcon>
+
+#include "filter.h"
+
+class FilterModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column: int //колонки таблицы фильтра
+    {
+        STOCK_EXCHANGE = 0,
+        MONEY = 1,
+        INTERVAL = 2,
+        DELTA = 3,
+        VOLUME = 4,
+        COUNT = 5
+    };
+
+public:
+    explicit FilterModel(QObject *parent = nullptr);
+
+    void setFilterList(const Filter::FilterDataList& filterDataList);
+    const Filter::FilterDataList& filterList() const;
+
+    void addFilter(const Filter::FilterData& filterData);
+    void removeFilter(int row);
+
+    quint64 version() const; //увеличивается при каждом изменении правил
+
+    static QIcon stockExchangeIcon(const QString& stockExchange);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    bool setData(const QModelIndex& index, const QVariant& value, int role = Qt::EditRole) override;
+    Qt::ItemFlags flags(const QModelIndex& index) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    Filter::FilterDataList _filterData; //правила фильтра, отображаемые в таблице
+    quint64 _version = 0; //номер версии правил
+};
+
+#endif // FILTERMODEL_H
@@ -11,10 +11,27 @@
 #include <QJsonObject>
 #include <QJsonParseError>
 
+#ifdef __EMSCRIPTEN__
+#include <emscripten/fetch.h>
+#else
+#include <QCoreApplication>
+#include <QNetworkAccessManager>
+#include <QNetworkRequest>
+#include <QNetworkReply>
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+#include <QHttp1Configuration>
+#endif
+#endif
+
+#include "httpsreplay.h"
+#include "tracer.h"
+
 #include "httpsquery.h"
 
 using namespace Common;
+#ifdef __EMSCRIPTEN__
 using namespace emscripten;
+#endif
 
 static const qint64 MAX_SAVE_RESULT = 600000; //ms
 static const qint64 CHECK_INTERVAL = 1000; //ms
@@ -28,8 +45,15 @@ struct AnswerData
 static std::unordered_map<int, AnswerData> answers;
 static QMutex answerMutex;
 
+static HTTPSCapture capture;
+static HTTPSReplay replay;
+static int connectionsPerHost = 0; //HTTP/1.1 соединений с одним сервером в нативной сборке, 0 - по умолчанию Qt (6)
+
 void addAnswerResult(int requestID, AnswerData&& answer)
 {
+    //записываем в момент получения: при опросе по таймеру время ответа в записи сдвигалось бы до CHECK_INTERVAL
+    capture.addAnswer(requestID, answer.answer);
+
     QMutexLocker<QMutex> locker(&answerMutex);
 
     answers.emplace(std::move(requestID), std::move(answer));
@@ -39,12 +63,16 @@ void clearOldAnswerResult()
 {
     QMutexLocker<QMutex> locker(&answerMutex);
 
-    for (auto answers_it = answers.begin(); answers_it != answers.end(); ++answers_it)
+    for (auto answers_it = answers.begin(); answers_it != answers.end(); )
     {
         if (answers_it->second.addTime.msecsTo(QDateTime::currentDateTime()) > MAX_SAVE_RESULT)
         {
             answers_it = answers.erase(answers_it);
         }
+        else
+        {
+            ++answers_it;
+        }
     }
 }
 
@@ -76,6 +104,8 @@ static QMutex errorMutex;
 
 void addErrorResult(int requestID, ErrorData&& answer)
 {
+    capture.addError(requestID, answer.code, answer.msg);
+
     QMutexLocker<QMutex> locker(&errorMutex);
 
     errors.emplace(std::move(requestID), std::move(answer));
@@ -101,15 +131,20 @@ void clearOldErrorsResult()
 {
     QMutexLocker<QMutex> locker(&errorMutex);
 
-    for (auto errors_it = errors.begin(); errors_it != errors.end(); ++errors_it)
+    for (auto errors_it = errors.begin(); errors_it != errors.end(); )
     {
         if (errors_it->second.addTime.secsTo(QDateTime::currentDateTime()) > MAX_SAVE_RESULT)
         {
             errors_it = errors.erase(errors_it);
         }
+        else
+        {
+            ++errors_it;
+        }
     }
 }
 
+#ifdef __EMSCRIPTEN__
 void downloadSucceeded(emscripten_fetch_t *fetch)
 {
     QByteArray answer(fetch->data, fetch->numBytes);
@@ -136,6 +171,7 @@ void downloadFailed(emscripten_fetch_t *fetch)
 
     emscripten_fetch_close(fetch); // Also free data on failure.
 }
+#endif
 
 HTTPSQuery::HTTPSQuery(QObject *parent)
     : QObject{parent}
@@ -157,8 +193,67 @@ int getID()
     return ++id;
 }
 
+bool HTTPSQuery::startCapture(const QString &fileName)
+{
+    return capture.open(fileName);
+}
+
+bool HTTPSQuery::startReplay(const QString &fileName, double speed)
+{
+    return replay.open(fileName, speed);
+}
+
+void HTTPSQuery::setConnectionsPerHost(int count)
+{
+#if defined(__EMSCRIPTEN__) || QT_VERSION < QT_VERSION_CHECK(6, 5, 0)
+    if (count > 0)
+    {
+        qDebug() << "Connections per host are not configurable in this build";
+    }
+#endif
+
+    connectionsPerHost = count;
+}
+
+qsizetype HTTPSQuery::resultsSize()
+{
+    qsizetype result = 0;
+
+    {
+        QMutexLocker<QMutex> locker(&answerMutex);
+
+        for (const auto& answer: answers)
+        {
+            result += sizeof(AnswerData) + answer.second.answer.capacity();
+        }
+    }
+
+    {
+        QMutexLocker<QMutex> locker(&errorMutex);
+
+        for (const auto& error: errors)
+        {
+            result += sizeof(ErrorData) + error.second.msg.capacity() * sizeof(QChar);
+        }
+    }
+
+    return result;
+}
+
 quint64 HTTPSQuery::send(const QUrl& url, const HTTPSQuery::Headers& headers, const QByteArray& data)
 {
+    TRACE_SPAN("HTTPSQuery::send");
+
+    if (replay.isOpen())
+    {
+        _id = getID();
+
+        sendReplay(url);
+
+        return _id;
+    }
+
+#ifdef __EMSCRIPTEN__
     emscripten_fetch_attr_t attr;
     emscripten_fetch_attr_init(&attr);
     if (data.isEmpty())
@@ -184,13 +279,67 @@ quint64 HTTPSQuery::send(const QUrl& url, const HTTPSQuery::Headers& headers, co
 
     fetch->userData = new int{getID()};
     _id = *(int*)fetch->userData;
+#else
+    //нативная сборка (запись и отладка без браузера)
+    static QNetworkAccessManager *networkManager = new QNetworkAccessManager(QCoreApplication::instance());
+
+    _id = getID();
+
+    QNetworkRequest request(url);
+    for (auto headers_it = headers.begin(); headers_it != headers.end(); ++headers_it)
+    {
+        request.setRawHeader(headers_it.key(), headers_it.value());
+    }
+
+#if QT_VERSION >= QT_VERSION_CHECK(6, 5, 0)
+    //сверх лимита запросы ждут свободного соединения в очереди QNetworkAccessManager
+    if (connectionsPerHost > 0)
+    {
+        QHttp1Configuration http1Configuration;
+        http1Configuration.setNumberOfConnectionsPerHost(connectionsPerHost);
+        request.setHttp1Configuration(http1Configuration);
+    }
+#endif
 
+    auto reply = data.isEmpty() ? networkManager->get(request) : networkManager->post(request, data);
+    QObject::connect(reply, &QNetworkReply::finished, reply,
+        [reply, id = _id]()
+        {
+            if (reply->error() != QNetworkReply::NoError)
+            {
+                ErrorData tmp;
+                tmp.code = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toUInt();
+                tmp.msg = QString("Error code: %1 URL: %2 %3").arg(tmp.code).arg(reply->url().toString()).arg(reply->errorString());
+
+                addErrorResult(id, std::move(tmp));
+            }
+            else
+            {
+                AnswerData tmp;
+                tmp.answer = reply->readAll();
+                tmp.addTime = QDateTime::currentDateTime();
+
+                addAnswerResult(id, std::move(tmp));
+            }
+
+            reply->deleteLater();
+        });
+
+    //ответ забираем сразу после сохранения, без опроса по таймеру: задержка CHECK_INTERVAL искажала бы
+    //время ответа, а тысячи одновременных запросов нагрузочного теста не держат по таймеру каждый
+    QObject::connect(reply, &QNetworkReply::finished, this, &HTTPSQuery::checkResult);
+#endif
+
+    capture.addRequest(_id, url, data);
+
+#ifdef __EMSCRIPTEN__
     //timer
-    _timer = new QTimer();
+    _timer = new QTimer(this);
 
     connect(_timer, SIGNAL(timeout()), SLOT(checkResult()));
 
     _timer->start(CHECK_INTERVAL);
+#endif
 
  //   qDebug() << _id << "SEND TO:" << url << "DATA:" << data;
 
@@ -199,25 +348,56 @@ quint64 HTTPSQuery::send(const QUrl& url, const HTTPSQuery::Headers& headers, co
 
 void HTTPSQuery::checkResult()
 {
-    auto answerResult =  getAnswerResult(_id);
+    TRACE_SPAN("HTTPSQuery::checkResult");
+
+    //получатель сигнала может удалить этот объект - после emit к членам класса не обращаемся
+    const auto id = _id;
+
+    clearOldAnswerResult();
+    clearOldErrorsResult();
+
+    auto answerResult =  getAnswerResult(id);
     if (answerResult.has_value())
     {
-        emit getAnswer(answerResult.value().answer, _id);
+        emit getAnswer(answerResult.value().answer, id);
+
+//        qDebug() << id << "ANSWER:" << answerResult.value().answer;
 
-//        qDebug() << _id << "ANSWER:" << answerResult.value().answer;
+        return;
     }
 
-    auto errorResult =  getErrorResult(_id);
+    auto errorResult =  getErrorResult(id);
     if (errorResult.has_value())
     {
-        emit errorOccurred(errorResult.value().code, errorResult.value().msg, _id);
+        emit errorOccurred(errorResult.value().code, errorResult.value().msg, id);
 
-//        qDebug() << _id << "ERROR:" << errorResult.value().code << errorResult.value().msg;
+//        qDebug() << id << "ERROR:" << errorResult.value().code << errorResult.value().msg;
     }
-
-    clearOldAnswerResult();
-    clearOldErrorsResult();
 }
 
+void HTTPSQuery::sendReplay(const QUrl &url)
+{
+    HTTPSReplay::Answer answer;
+    qint64 delay = 0;
+    if (!replay.take(url, answer, delay))
+    {
+        //запрос остается без ответа - как будто сервер перестал отвечать
+        qDebug() << _id << "REPLAY: no more recorded answers for" << HTTPSReplay::method(url);
 
+        return;
+    }
 
+    //сигнал отправляется напрямую, без опроса по таймеру - иначе ускоренное воспроизведение ограничено CHECK_INTERVAL
+    QTimer::singleShot(delay, this,
+        [this, answer]()
+        {
+            if (answer.isError)
+            {
+                emit errorOccurred(answer.code, answer.msg, _id);
+            }
+            else
+            {
+                emit getAnswer(answer.answer, _id);
+            }
+        });
+}
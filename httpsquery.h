@@ -7,8 +7,6 @@
 #include <QByteArray>
 #include <QTimer>
 
-#include <emscripten/fetch.h>
-
 namespace Common
 {
 
@@ -26,6 +24,11 @@ public:
 
     quint64 send(const QUrl& url, const Headers& headers, const QByteArray& data); //запускает отправку запроса
 
+    static bool startCapture(const QString& fileName); //все последующие запросы и ответы записываются в файл
+    static bool startReplay(const QString& fileName, double speed); //ответы берутся из файла записи, сервер не используется
+    static void setConnectionsPerHost(int count); //соединений с одним сервером (нативная сборка, Qt 6.5+), 0 - по умолчанию Qt
+    static qsizetype resultsSize(); //байт в полученных, но еще не забранных ответах и ошибках
+
 signals:
     void getAnswer(const QByteArray& answer, int id);
     void errorOccurred(quint32 code, const QString& msg, int id);
@@ -33,6 +36,9 @@ signals:
 private slots:
     void checkResult();
 
+private:
+    void sendReplay(const QUrl& url);
+
 private:
     int _id = 0;
 
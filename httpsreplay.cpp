@@ -0,0 +1,218 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDebug>
+#include <QDateTime>
+
+#include "httpsreplay.h"
+
+using namespace Common;
+
+static const quint32 CAPTURE_MAGIC = 0x54434843; //"TCHC"
+static const quint32 CAPTURE_VERSION = 1;
+
+bool HTTPSCapture::open(const QString &fileName)
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    _file.setFileName(fileName);
+    if (!_file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot open capture file:" << fileName << _file.errorString();
+
+        return false;
+    }
+
+    _stream.setDevice(&_file);
+    _stream << CAPTURE_MAGIC << CAPTURE_VERSION << QDateTime::currentMSecsSinceEpoch();
+
+    _timer.start();
+
+    return true;
+}
+
+void HTTPSCapture::close()
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    _stream.setDevice(nullptr);
+    _file.close();
+}
+
+bool HTTPSCapture::isOpen() const
+{
+    return _file.isOpen();
+}
+
+void HTTPSCapture::addRequest(int id, const QUrl &url, const QByteArray &data)
+{
+    write(RecordType::REQUEST, id, data, 0, url.toString());
+}
+
+void HTTPSCapture::addAnswer(int id, const QByteArray &answer)
+{
+    write(RecordType::ANSWER, id, answer, 0, QString());
+}
+
+void HTTPSCapture::addError(int id, quint32 code, const QString &msg)
+{
+    write(RecordType::ERROR, id, QByteArray(), code, msg);
+}
+
+void HTTPSCapture::write(RecordType type, int id, const QByteArray &data, quint32 code, const QString &text)
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    if (!_file.isOpen())
+    {
+        return;
+    }
+
+    _stream << static_cast<quint8>(type) << _timer.elapsed() << static_cast<qint32>(id) << data << code << text;
+
+    //при аварийном завершении в файле остаются все записи до последней
+    _file.flush();
+}
+
+bool HTTPSReplay::open(const QString &fileName, double speed)
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        qDebug() << "Cannot open replay file:" << fileName << file.errorString();
+
+        return false;
+    }
+
+    QDataStream stream(&file);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    qint64 captureStart = 0;
+    stream >> magic >> version >> captureStart;
+    if (magic != CAPTURE_MAGIC || version != CAPTURE_VERSION)
+    {
+        qDebug() << "Unsupported replay file format:" << fileName;
+
+        return false;
+    }
+
+    _answers.clear();
+
+    QHash<qint32, QString> requests; //id запроса -> метод сервера
+    QHash<qint32, qsizetype> answerIndexes; //id запроса -> индекс ответа в очереди метода
+    qsizetype answerCount = 0;
+
+    while (!stream.atEnd())
+    {
+        quint8 type = 0;
+        qint64 time = 0;
+        qint32 id = 0;
+        QByteArray data;
+        quint32 code = 0;
+        QString text;
+        stream >> type >> time >> id >> data >> code >> text;
+
+        //последняя запись могла остаться недописанной
+        if (stream.status() != QDataStream::Ok)
+        {
+            qDebug() << "Replay file is truncated:" << fileName;
+
+            break;
+        }
+
+        switch (static_cast<HTTPSCapture::RecordType>(type))
+        {
+        case HTTPSCapture::RecordType::REQUEST:
+        {
+            //место в очереди определяется порядком запросов, а не ответов
+            const auto method = HTTPSReplay::method(QUrl(text));
+            requests.insert(id, method);
+            answerIndexes.insert(id, _answers[method].size());
+            _answers[method].push_back(Answer());
+            break;
+        }
+        case HTTPSCapture::RecordType::ANSWER:
+        case HTTPSCapture::RecordType::ERROR:
+        {
+            const auto requests_it = requests.find(id);
+            if (requests_it == requests.end())
+            {
+                break;
+            }
+
+            auto& answer = _answers[requests_it.value()][answerIndexes.value(id)];
+            answer.time = time;
+            answer.isError = static_cast<HTTPSCapture::RecordType>(type) == HTTPSCapture::RecordType::ERROR;
+            answer.answer = data;
+            answer.code = code;
+            answer.msg = text;
+
+            requests.erase(requests_it);
+            ++answerCount;
+            break;
+        }
+        default:
+            qDebug() << "Unknown replay record type:" << type;
+            break;
+        }
+    }
+
+    //запросы, на которые ответ не был записан, воспроизводить нечем - удаляем их из очередей
+    for (auto requests_it = requests.begin(); requests_it != requests.end(); ++requests_it)
+    {
+        _answers[requests_it.value()][answerIndexes.value(requests_it.key())].time = -1;
+    }
+    for (auto& answers: _answers)
+    {
+        answers.removeIf([](const Answer& answer){ return answer.time < 0; });
+    }
+
+    _speed = std::max(speed, 0.0);
+    _isOpen = true;
+    _timer.invalidate();
+
+    qDebug() << "Replay file loaded:" << fileName << "Answers:" << answerCount << "Speed:" << _speed;
+
+    return true;
+}
+
+bool HTTPSReplay::isOpen() const
+{
+    return _isOpen;
+}
+
+bool HTTPSReplay::take(const QUrl &url, Answer &answer, qint64 &delay)
+{
+    QMutexLocker<QMutex> locker(&_mutex);
+
+    auto& answers = _answers[method(url)];
+    if (answers.isEmpty())
+    {
+        return false;
+    }
+
+    if (!_timer.isValid())
+    {
+        _timer.start();
+    }
+
+    answer = answers.takeFirst();
+
+    //ответ выдается в момент, соответствующий записи, с учетом скорости воспроизведения
+    delay = 0;
+    if (_speed > 0.0)
+    {
+        delay = std::max<qint64>(0, static_cast<qint64>(answer.time / _speed) - _timer.elapsed());
+    }
+
+    return true;
+}
+
+QString HTTPSReplay::method(const QUrl &url)
+{
+    return url.path().section('/', 1, 1);
+}
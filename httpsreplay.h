@@ -0,0 +1,83 @@
+#ifndef HTTPSREPLAY_H
+#define HTTPSREPLAY_H
+
+//Qt
+#include <QByteArray>
+#include <QString>
+#include <QUrl>
+#include <QFile>
+#include <QDataStream>
+#include <QMutex>
+#include <QHash>
+#include <QList>
+#include <QElapsedTimer>
+
+namespace Common
+{
+
+//Запись запросов и ответов HTTPSQuery в файл для последующего воспроизведения
+class HTTPSCapture
+{
+public:
+    enum class RecordType: quint8
+    {
+        REQUEST = 1,
+        ANSWER = 2,
+        ERROR = 3
+    };
+
+public:
+    bool open(const QString& fileName);
+    void close();
+    bool isOpen() const;
+
+    void addRequest(int id, const QUrl& url, const QByteArray& data);
+    void addAnswer(int id, const QByteArray& answer);
+    void addError(int id, quint32 code, const QString& msg);
+
+private:
+    void write(RecordType type, int id, const QByteArray& data, quint32 code, const QString& text);
+
+private:
+    QMutex _mutex;
+    QFile _file;
+    QDataStream _stream;
+    QElapsedTimer _timer; //время записи отсчитывается от открытия файла
+};
+
+//Воспроизведение записанных ответов вместо обращения к серверу.
+//Ответ на запрос берется из очереди ответов того же метода сервера (/login, /data и т.д.) в порядке записи,
+//поэтому идентификаторы сессии и пользователя при воспроизведении могут отличаться от записанных
+class HTTPSReplay
+{
+public:
+    struct Answer
+    {
+        qint64 time = 0; //ms от начала записи
+        bool isError = false;
+        QByteArray answer;
+        quint32 code = 0;
+        QString msg;
+    };
+
+public:
+    //speed: 1 - в реальном времени, N - в N раз быстрее, 0 - без задержек
+    bool open(const QString& fileName, double speed);
+    bool isOpen() const;
+
+    //следующий записанный ответ на запрос url и задержка его выдачи в ms. false - записанные ответы закончились
+    bool take(const QUrl& url, Answer& answer, qint64& delay);
+
+    static QString method(const QUrl& url); //метод сервера - первый элемент пути URL
+
+private:
+    QMutex _mutex;
+    QHash<QString, QList<Answer>> _answers; //ответы по методам сервера в порядке записи
+    double _speed = 1.0;
+    bool _isOpen = false;
+    QElapsedTimer _timer; //время воспроизведения отсчитывается от первого запроса
+};
+
+} //namespace Common
+
+#endif // HTTPSREPLAY_H
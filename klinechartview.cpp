@@ -0,0 +1,226 @@
+//STL
+#include <algorithm>
+#include <limits>
+
+//Qt
+#include <QChart>
+#include <QDateTimeAxis>
+#include <QValueAxis>
+#include <QPainter>
+
+#include "klinechartview.h"
+
+KLineChartView::KLineChartView(qreal bodyWidth, qreal capsWidth, bool markFlatKLine, QWidget *parent /* = nullptr */)
+    : QChartView(parent)
+    , _series(new QCandlestickSeries)
+    , _seriesVolume(new QCandlestickSeries)
+{
+    _series->setIncreasingColor(QColor(Qt::green));
+    _series->setDecreasingColor(QColor(Qt::red));
+    _series->setBodyOutlineVisible(true);
+    _series->setBodyWidth(bodyWidth);
+    _series->setCapsVisible(true);
+    _series->setCapsWidth(capsWidth);
+    _series->setMinimumColumnWidth(-1.0);
+    _series->setMaximumColumnWidth(50.0);
+    auto pen = _series->pen();
+    pen.setWidth(1);
+    pen.setColor(Qt::white);
+    _series->setPen(pen);
+
+    _seriesVolume->setIncreasingColor(QColor(61, 56, 70));
+    _seriesVolume->setDecreasingColor(QColor(61, 56, 70));
+    _seriesVolume->setBodyOutlineVisible(false);
+    _seriesVolume->setCapsVisible(true);
+    _seriesVolume->setMinimumColumnWidth(-1.0);
+    _seriesVolume->setMaximumColumnWidth(50.0);
+    _seriesVolume->setCapsWidth(capsWidth);
+
+    auto chart = new QChart;
+    chart->addSeries(_seriesVolume);
+    chart->addSeries(_series);
+ //   chart->setAnimationOptions(QChart::SeriesAnimations);
+    chart->setBackgroundBrush(QBrush(QColor(36, 31, 49)));
+    auto titleFont = chart->titleFont();
+    titleFont.setPointSize(20);
+    chart->setTitleFont(titleFont);
+    chart->legend()->setVisible(false);
+    chart->setTitle("No data");
+    chart->setMargins({0,0,0,0});
+
+    auto axisX = new QDateTimeAxis;
+    axisX->setTickCount(3);
+    axisX->setFormat("hh:mm");
+    axisX->setGridLineVisible(false);
+    axisX->setLabelsColor(Qt::white);
+
+    chart->addAxis(axisX, Qt::AlignBottom);
+
+    _series->attachAxis(axisX);
+    _seriesVolume->attachAxis(axisX);
+
+    auto axisY = new QValueAxis();
+    axisY->setGridLineVisible(true);
+    axisY->setGridLineColor(QColor(94, 92, 100));
+    auto axisYGridLinePen = axisY->gridLinePen();
+    axisYGridLinePen.setStyle(Qt::DotLine);
+    axisY->setGridLinePen(axisYGridLinePen);
+    axisY->setLabelsColor(Qt::white);
+
+    chart->addAxis(axisY, Qt::AlignRight);
+
+    _series->attachAxis(axisY);
+
+    auto axisY2 = new QValueAxis();
+    axisY2->setGridLineVisible(false);
+    axisY2->setLabelsVisible(false);
+
+    chart->addAxis(axisY2, Qt::AlignLeft);
+
+    _seriesVolume->attachAxis(axisY2);
+
+    setChart(chart);
+
+    makeIndicatorSeries();
+
+    _klineSeries = new KLineSeries(_series, _seriesVolume, markFlatKLine);
+}
+
+KLineChartView::~KLineChartView()
+{
+    //пулы наборов удаляются до графика, которому принадлежат серии
+    delete _klineSeries;
+}
+
+void KLineChartView::setKLines(const QString &title, const KLines &history, const KLineIndicators *klineIndicators)
+{
+    if (history.isEmpty())
+    {
+        _klineSeries->clear();
+        showIndicators(nullptr);
+
+        chart()->setTitle(title);
+
+        return;
+    }
+
+    chart()->setTitle(title + showIndicators(klineIndicators));
+
+    _klineSeries->setKLines(history);
+
+    double max = std::numeric_limits<double>::min();
+    double min = std::numeric_limits<double>::max();
+    double maxVolume = std::numeric_limits<double>::min();
+
+    for (auto kline_it = history.begin(); kline_it != history.end(); ++kline_it)
+    {
+        max = std::max(max, kline_it->high);
+        min = std::min(min, kline_it->low);
+        maxVolume = std::max(maxVolume, kline_it->volume);
+    }
+
+    //полосы Боллинджера могут выходить за диапазон свечей
+    if (klineIndicators != nullptr && klineIndicators->isOverlay())
+    {
+        for (const auto& point: klineIndicators->upper())
+        {
+            max = std::max(max, point.y());
+        }
+        for (const auto& point: klineIndicators->lower())
+        {
+            min = std::min(min, point.y());
+        }
+    }
+
+    auto axisX = qobject_cast<QDateTimeAxis*>(chart()->axes(Qt::Horizontal).at(0));
+    axisX->setMax(history.first().closeTime.addMSecs(static_cast<qint64>(history.first().id.type) * 5));
+    axisX->setMin(history.last().closeTime.addMSecs(-static_cast<qint64>(history.first().id.type)));
+    axisX->setTickCount(5);
+
+    auto axisY = qobject_cast<QValueAxis*>(chart()->axes(Qt::Vertical).at(0));
+    axisY->setMax(max * 1.05);
+    axisY->setMin(min * 0.95);
+
+    auto axisY2 = qobject_cast<QValueAxis*>(chart()->axes(Qt::Vertical).at(1));
+    axisY2->setMax(maxVolume * 2);
+    axisY2->setMin(0);
+}
+
+void KLineChartView::clear()
+{
+    _klineSeries->clear();
+}
+
+QImage KLineChartView::toImage()
+{
+    //размер изображения в пикселях окна, как у KLineChartWidget::render(), независимо от масштаба экрана
+    QImage image(size(), QImage::Format_RGB32);
+
+    QPainter painter(&image);
+    render(&painter);
+
+    return image;
+}
+
+qsizetype KLineChartView::setCount() const
+{
+    return _klineSeries->setCount();
+}
+
+qsizetype KLineChartView::indicatorPointCount() const
+{
+    return _indicatorLine->count() + _indicatorUpper->count() + _indicatorLower->count();
+}
+
+void KLineChartView::makeIndicatorSeries()
+{
+    auto axisX = chart()->axes(Qt::Horizontal).at(0);
+    auto axisY = chart()->axes(Qt::Vertical).at(0);
+
+    _indicatorLine = new QLineSeries;
+    _indicatorLine->setPen(QPen(QColor(255, 200, 0), 1.5));
+
+    _indicatorUpper = new QLineSeries;
+    _indicatorUpper->setPen(QPen(QColor(100, 160, 255), 1.0, Qt::DashLine));
+
+    _indicatorLower = new QLineSeries;
+    _indicatorLower->setPen(QPen(QColor(100, 160, 255), 1.0, Qt::DashLine));
+
+    for (auto series: {_indicatorLine, _indicatorUpper, _indicatorLower})
+    {
+        chart()->addSeries(series);
+        series->attachAxis(axisX);
+        series->attachAxis(axisY);
+        series->hide();
+    }
+}
+
+QString KLineChartView::showIndicators(const KLineIndicators *klineIndicators)
+{
+    //RSI и ATR не в масштабе цены - показываем только последнее значение в заголовке
+    if (klineIndicators == nullptr || !klineIndicators->isOverlay())
+    {
+        for (auto series: {_indicatorLine, _indicatorUpper, _indicatorLower})
+        {
+            series->clear();
+            series->hide();
+        }
+
+        if (klineIndicators != nullptr && klineIndicators->isReady())
+        {
+            return QString(" %1: %2").arg(KLineIndicators::typeToString(klineIndicators->type())).arg(klineIndicators->lastValue(), 0, 'f', 2);
+        }
+
+        return QString();
+    }
+
+    _indicatorLine->replace(klineIndicators->line());
+    _indicatorUpper->replace(klineIndicators->upper());
+    _indicatorLower->replace(klineIndicators->lower());
+
+    _indicatorLine->show();
+    _indicatorUpper->setVisible(!klineIndicators->upper().isEmpty());
+    _indicatorLower->setVisible(!klineIndicators->lower().isEmpty());
+
+    return QString(" %1").arg(KLineIndicators::typeToString(klineIndicators->type()));
+}
@@ -0,0 +1,50 @@
+#ifndef KLINECHARTVIEW_H
+#define KLINECHARTVIEW_H
+
+#include <QChartView>
+#include <QCandlestickSeries>
+#include <QLineSeries>
+#include <QImage>
+#include <QString>
+
+#include "types.h"
+#include "klineseries.h"
+#include "klineindicators.h"
+
+//График свечей и объема QtCharts с линиями индикатора поверх свечей.
+//Наборы свечей переиспользуются между вызовами setKLines() (KLineSeries)
+class KLineChartView : public QChartView
+{
+    Q_OBJECT
+
+public:
+    //bodyWidth, capsWidth - ширина тела и засечек свечей, markFlatKLine - рисовать свечу с open == close как растущую
+    KLineChartView(qreal bodyWidth, qreal capsWidth, bool markFlatKLine, QWidget *parent = nullptr);
+    ~KLineChartView() override;
+
+    //history - от новых свечей к старым. klineIndicators может быть nullptr, название индикатора добавляется к title
+    void setKLines(const QString& title, const KLines& history, const KLineIndicators *klineIndicators);
+    void clear(); //убирает свечи, заголовок не меняется
+
+    QImage toImage(); //рисует график в изображение размера виджета
+
+    qsizetype setCount() const; //наборы свечей в сериях и в пулах
+    qsizetype indicatorPointCount() const; //точки линий индикатора
+
+private:
+    Q_DISABLE_COPY_MOVE(KLineChartView)
+
+    void makeIndicatorSeries();
+    QString showIndicators(const KLineIndicators *klineIndicators); //возвращает добавку к заголовку
+
+private:
+    QCandlestickSeries *_series = nullptr;       //серия цены (принадлежит графику)
+    QCandlestickSeries *_seriesVolume = nullptr; //серия объема (принадлежит графику)
+    KLineSeries *_klineSeries = nullptr;
+
+    QLineSeries *_indicatorLine = nullptr; //линии индикатора (принадлежат графику)
+    QLineSeries *_indicatorUpper = nullptr;
+    QLineSeries *_indicatorLower = nullptr;
+};
+
+#endif // KLINECHARTVIEW_H
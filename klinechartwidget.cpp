@@ -0,0 +1,377 @@
+//STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+//Qt
+#include <QPaintEvent>
+#include <QWheelEvent>
+#include <QMouseEvent>
+#include <QDateTime>
+
+#include "klinechartwidget.h"
+
+static const QColor BACKGROUND_COLOR = QColor(36, 31, 49);
+static const QColor GRID_COLOR = QColor(94, 92, 100);
+static const QColor INCREASE_COLOR = QColor(Qt::green);
+static const QColor DECREASE_COLOR = QColor(Qt::red);
+static const QColor VOLUME_COLOR = QColor(61, 56, 70);
+static const int TITLE_HEIGHT = 30;          //px
+static const int AXIS_WIDTH = 70;            //px
+static const int TIME_AXIS_HEIGHT = 20;      //px
+static const double VOLUME_AREA = 0.25;      //доля высоты под объем
+static const double MIN_VISIBLE_KLINES = 10; //минимальное количество видимых свечей при увеличении
+static const double ZOOM_FACTOR = 0.8;
+
+KLineChartWidget::KLineChartWidget(QWidget *parent)
+    : QWidget{parent}
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    setMouseTracking(false);
+}
+
+void KLineChartWidget::setKLines(const KLines &klines)
+{
+    makeCandles(klines, _candles);
+
+    resetView();
+    update();
+}
+
+void KLineChartWidget::setKLines(const KLineColumns &columns)
+{
+    makeCandles(columns, _candles);
+
+    resetView();
+    update();
+}
+
+void KLineChartWidget::setTitle(const QString &title)
+{
+    _title = title;
+    update();
+}
+
+void KLineChartWidget::clear()
+{
+    _candles.clear();
+    _columns.clear();
+    _title = "No data";
+
+    resetView();
+    update();
+}
+
+QImage KLineChartWidget::render(const KLines &klines, const QString &title, const QSize &size)
+{
+    Candles candles;
+    makeCandles(klines, candles);
+
+    return render(candles, title, size);
+}
+
+QImage KLineChartWidget::render(const KLineColumns &columns, const QString &title, const QSize &size)
+{
+    Candles candles;
+    makeCandles(columns, candles);
+
+    return render(candles, title, size);
+}
+
+QImage KLineChartWidget::render(const Candles &candles, const QString &title, const QSize &size)
+{
+    QImage image(size, QImage::Format_RGB32);
+
+    Candles columns;
+
+    QPainter painter(&image);
+    draw(painter, image.rect(), candles, 0, candles.size(), title, columns);
+
+    return image;
+}
+
+void KLineChartWidget::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event);
+
+    QPainter painter(this);
+
+    const auto first = static_cast<qsizetype>(std::floor(_viewBegin));
+    const auto last = std::min(static_cast<qsizetype>(std::ceil(_viewEnd)), _candles.size());
+    draw(painter, rect(), _candles, first, last, _title, _columns);
+}
+
+void KLineChartWidget::draw(QPainter &painter, const QRect &rect, const Candles &candles, qsizetype first, qsizetype last,
+                            const QString &title, Candles &columns)
+{
+    painter.fillRect(rect, BACKGROUND_COLOR);
+
+    painter.setPen(Qt::white);
+    auto titleFont = painter.font();
+    titleFont.setPointSize(14);
+    painter.setFont(titleFont);
+    painter.drawText(QRect(rect.left(), rect.top(), rect.width(), TITLE_HEIGHT), Qt::AlignCenter, title);
+    titleFont.setPointSize(8);
+    painter.setFont(titleFont);
+
+    const QRectF plotRect(rect.left(), rect.top() + TITLE_HEIGHT, rect.width() - AXIS_WIDTH, rect.height() - TITLE_HEIGHT - TIME_AXIS_HEIGHT);
+    if (candles.isEmpty() || plotRect.width() < 1 || plotRect.height() < 1)
+    {
+        return;
+    }
+
+    makeColumns(candles, first, last, static_cast<int>(plotRect.width()), columns);
+    if (columns.isEmpty())
+    {
+        return;
+    }
+
+    double max = std::numeric_limits<double>::lowest();
+    double min = std::numeric_limits<double>::max();
+    double maxVolume = 0.0;
+    for (const auto& column: columns)
+    {
+        max = std::max(max, column.high);
+        min = std::min(min, column.low);
+        maxVolume = std::max(maxVolume, column.volume);
+    }
+
+    if (max <= min)
+    {
+        max = min + 1.0;
+    }
+
+    const double priceHeight = plotRect.height() * (1.0 - VOLUME_AREA);
+    const double volumeTop = plotRect.top() + priceHeight;
+    const double volumeHeight = plotRect.height() * VOLUME_AREA;
+
+    const auto priceToY = [&](double price)
+    {
+        return plotRect.top() + (max - price) / (max - min) * priceHeight;
+    };
+
+    //сетка и подписи цены
+    auto gridPen = QPen(GRID_COLOR);
+    gridPen.setStyle(Qt::DotLine);
+    for (int i = 0; i <= 4; ++i)
+    {
+        const double price = min + (max - min) * i / 4.0;
+        const double y = priceToY(price);
+        painter.setPen(gridPen);
+        painter.drawLine(QPointF(plotRect.left(), y), QPointF(plotRect.right(), y));
+        painter.setPen(Qt::white);
+        painter.drawText(QRectF(plotRect.right() + 4, y - 8, AXIS_WIDTH - 4, 16), Qt::AlignLeft | Qt::AlignVCenter, QString::number(price, 'g', 6));
+    }
+
+    const double slot = plotRect.width() / columns.size();
+    const double bodyWidth = std::max(1.0, slot * 0.7);
+
+    for (qsizetype i = 0; i < columns.size(); ++i)
+    {
+        const auto& column = columns.at(i);
+        const double x = plotRect.left() + (i + 0.5) * slot;
+
+        //объем
+        if (maxVolume > 0.0)
+        {
+            const double volumeBarHeight = column.volume / maxVolume * volumeHeight;
+            painter.fillRect(QRectF(x - bodyWidth / 2, volumeTop + volumeHeight - volumeBarHeight, bodyWidth, volumeBarHeight), VOLUME_COLOR);
+        }
+
+        //свеча
+        const auto& color = column.open <= column.close ? INCREASE_COLOR : DECREASE_COLOR;
+        painter.setPen(color);
+        painter.drawLine(QPointF(x, priceToY(column.high)), QPointF(x, priceToY(column.low)));
+
+        const double bodyTop = priceToY(std::max(column.open, column.close));
+        const double bodyBottom = priceToY(std::min(column.open, column.close));
+        painter.fillRect(QRectF(x - bodyWidth / 2, bodyTop, bodyWidth, std::max(1.0, bodyBottom - bodyTop)), color);
+    }
+
+    //подписи времени
+    painter.setPen(Qt::white);
+    const auto timeFormat = (columns.last().time - columns.first().time) > 24 * 60 * 60 * 1000 ? "dd.MM hh:mm" : "hh:mm";
+    const QRectF timeRect(plotRect.left(), plotRect.bottom(), plotRect.width(), TIME_AXIS_HEIGHT);
+    painter.drawText(timeRect, Qt::AlignLeft | Qt::AlignVCenter, QDateTime::fromMSecsSinceEpoch(columns.first().time).toString(timeFormat));
+    painter.drawText(timeRect, Qt::AlignRight | Qt::AlignVCenter, QDateTime::fromMSecsSinceEpoch(columns.last().time).toString(timeFormat));
+}
+
+void KLineChartWidget::wheelEvent(QWheelEvent *event)
+{
+    if (_candles.isEmpty())
+    {
+        return;
+    }
+
+    const double plotWidth = std::max(1, width() - AXIS_WIDTH);
+    const double visibleCount = _viewEnd - _viewBegin;
+    const double anchor = _viewBegin + std::clamp(event->position().x() / plotWidth, 0.0, 1.0) * visibleCount;
+
+    const double factor = event->angleDelta().y() > 0 ? ZOOM_FACTOR : 1.0 / ZOOM_FACTOR;
+    const double newVisibleCount = std::clamp(visibleCount * factor, std::min(MIN_VISIBLE_KLINES, static_cast<double>(_candles.size())), static_cast<double>(_candles.size()));
+
+    _viewBegin = anchor - (anchor - _viewBegin) * newVisibleCount / visibleCount;
+    _viewEnd = _viewBegin + newVisibleCount;
+
+    clampView();
+    update();
+
+    event->accept();
+}
+
+void KLineChartWidget::mousePressEvent(QMouseEvent *event)
+{
+    if (event->button() != Qt::LeftButton)
+    {
+        QWidget::mousePressEvent(event);
+
+        return;
+    }
+
+    _isDragging = true;
+    _dragStartX = event->position().x();
+    _dragStartBegin = _viewBegin;
+}
+
+void KLineChartWidget::mouseMoveEvent(QMouseEvent *event)
+{
+    if (!_isDragging)
+    {
+        QWidget::mouseMoveEvent(event);
+
+        return;
+    }
+
+    const double plotWidth = std::max(1, width() - AXIS_WIDTH);
+    const double visibleCount = _viewEnd - _viewBegin;
+    const double shift = (event->position().x() - _dragStartX) / plotWidth * visibleCount;
+
+    _viewBegin = _dragStartBegin - shift;
+    _viewEnd = _viewBegin + visibleCount;
+
+    clampView();
+    update();
+}
+
+void KLineChartWidget::mouseReleaseEvent(QMouseEvent *event)
+{
+    if (event->button() == Qt::LeftButton)
+    {
+        _isDragging = false;
+    }
+
+    QWidget::mouseReleaseEvent(event);
+}
+
+void KLineChartWidget::mouseDoubleClickEvent(QMouseEvent *event)
+{
+    Q_UNUSED(event);
+
+    resetView();
+    update();
+}
+
+void KLineChartWidget::resetView()
+{
+    _viewBegin = 0.0;
+    _viewEnd = _candles.size();
+}
+
+void KLineChartWidget::clampView()
+{
+    const double visibleCount = _viewEnd - _viewBegin;
+    if (_viewBegin < 0.0)
+    {
+        _viewBegin = 0.0;
+        _viewEnd = visibleCount;
+    }
+
+    if (_viewEnd > _candles.size())
+    {
+        _viewEnd = _candles.size();
+        _viewBegin = std::max(0.0, _viewEnd - visibleCount);
+    }
+}
+
+void KLineChartWidget::makeCandles(const KLines &klines, Candles &candles)
+{
+    candles.resize(klines.size());
+
+    for (qsizetype i = 0; i < klines.size(); ++i)
+    {
+        const auto& kline = klines.at(i);
+        auto& candle = candles[i];
+        candle.time = kline.closeTime.toMSecsSinceEpoch();
+        candle.open = kline.open;
+        candle.high = kline.high;
+        candle.low = kline.low;
+        candle.close = kline.close;
+        candle.volume = kline.volume;
+    }
+
+    //история от сервера может идти от новых свечей к старым
+    if (!std::is_sorted(candles.begin(), candles.end(), [](const Candle& c1, const Candle& c2){ return c1.time < c2.time; }))
+    {
+        std::sort(candles.begin(), candles.end(), [](const Candle& c1, const Candle& c2){ return c1.time < c2.time; });
+    }
+}
+
+void KLineChartWidget::makeCandles(const KLineColumns &columns, Candles &candles)
+{
+    //столбцы хранилища уже идут по возрастанию времени
+    candles.resize(columns.size());
+
+    for (qsizetype i = 0; i < columns.size(); ++i)
+    {
+        auto& candle = candles[i];
+        candle.time = columns.closeTime[i];
+        candle.open = columns.open[i];
+        candle.high = columns.high[i];
+        candle.low = columns.low[i];
+        candle.close = columns.close[i];
+        candle.volume = columns.volume[i];
+    }
+}
+
+void KLineChartWidget::makeColumns(const Candles& candles, qsizetype first, qsizetype last, int width, Candles& columns)
+{
+    columns.clear();
+
+    const auto count = last - first;
+    if (count <= 0 || width <= 0)
+    {
+        return;
+    }
+
+    if (count <= width)
+    {
+        columns = Candles(candles.cbegin() + first, candles.cbegin() + last);
+
+        return;
+    }
+
+    //несколько свечей на столбец - объединяем с сохранением OHLC
+    columns.reserve(width);
+    for (qsizetype x = 0; x < width; ++x)
+    {
+        const auto begin = first + x * count / width;
+        const auto end = first + (x + 1) * count / width;
+        if (begin >= end)
+        {
+            continue;
+        }
+
+        Candle column = candles.at(begin);
+        for (auto i = begin + 1; i < end; ++i)
+        {
+            const auto& candle = candles.at(i);
+            column.high = std::max(column.high, candle.high);
+            column.low = std::min(column.low, candle.low);
+            column.close = candle.close;
+            column.time = candle.time;
+            column.volume += candle.volume;
+        }
+
+        columns.push_back(column);
+    }
+}
@@ -0,0 +1,77 @@
+#ifndef KLINECHARTWIDGET_H
+#define KLINECHARTWIDGET_H
+
+#include <QWidget>
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+#include <QString>
+
+#include "types.h"
+#include "klinestore.h"
+
+//Легковесный график свечей и объема для длинных историй.
+//Рисует напрямую из непрерывного буфера свечей. Свечи, попадающие в один столбец пикселей,
+//объединяются с сохранением OHLC, поэтому стоимость отрисовки зависит от ширины виджета, а не от количества свечей
+class KLineChartWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit KLineChartWidget(QWidget *parent = nullptr);
+
+    void setKLines(const KLines& klines);
+    void setKLines(const KLineColumns& columns); //история из KLineStore
+    void setTitle(const QString& title);
+    void clear();
+
+    //рисует всю историю в изображение заданного размера. Не требует GUI потока
+    static QImage render(const KLines& klines, const QString& title, const QSize& size);
+    static QImage render(const KLineColumns& columns, const QString& title, const QSize& size);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void wheelEvent(QWheelEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+    void mouseMoveEvent(QMouseEvent *event) override;
+    void mouseReleaseEvent(QMouseEvent *event) override;
+    void mouseDoubleClickEvent(QMouseEvent *event) override;
+
+private:
+    struct Candle //свеча в буфере отрисовки
+    {
+        qint64 time = 0;
+        double open = 0.0;
+        double high = 0.0;
+        double low = 0.0;
+        double close = 0.0;
+        double volume = 0.0;
+    };
+
+    using Candles = QVector<Candle>;
+
+private:
+    void resetView();
+    void clampView();
+
+    static void makeCandles(const KLines& klines, Candles& candles);
+    static void makeCandles(const KLineColumns& columns, Candles& candles);
+    static QImage render(const Candles& candles, const QString& title, const QSize& size);
+    static void makeColumns(const Candles& candles, qsizetype first, qsizetype last, int width, Candles& columns);
+    static void draw(QPainter& painter, const QRect& rect, const Candles& candles, qsizetype first, qsizetype last,
+                     const QString& title, Candles& columns);
+
+private:
+    Candles _candles;   //свечи по возрастанию времени
+    Candles _columns;   //свечи, объединенные по столбцам пикселей (пересчитывается при отрисовке)
+    QString _title = "No data";
+
+    double _viewBegin = 0.0; //индекс первой видимой свечи
+    double _viewEnd = 0.0;   //индекс за последней видимой свечой
+
+    bool _isDragging = false;
+    double _dragStartX = 0.0;
+    double _dragStartBegin = 0.0;
+};
+
+#endif // KLINECHARTWIDGET_H
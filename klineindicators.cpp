@@ -0,0 +1,172 @@
+#include "klineindicators.h"
+
+KLineIndicators::KLineIndicators(Type type)
+    : _type(type)
+    , _sma(PERIOD)
+    , _ema(PERIOD)
+    , _bollinger(PERIOD)
+    , _rsi(WILDER_PERIOD)
+    , _atr(WILDER_PERIOD)
+{
+}
+
+KLineIndicators::Type KLineIndicators::type() const
+{
+    return _type;
+}
+
+bool KLineIndicators::isOverlay() const
+{
+    return _type == Type::SMA || _type == Type::EMA || _type == Type::BOLLINGER || _type == Type::VWAP;
+}
+
+void KLineIndicators::append(const KLine &kline)
+{
+    const auto x = static_cast<qreal>(kline.closeTime.toMSecsSinceEpoch());
+
+    switch (_type)
+    {
+    case Type::NONE:
+        break;
+    case Type::SMA:
+        _sma.append(kline.close);
+        if (_sma.isReady())
+        {
+            _line.append(QPointF(x, _sma.value()));
+        }
+        break;
+    case Type::EMA:
+        _ema.append(kline.close);
+        if (_ema.isReady())
+        {
+            _line.append(QPointF(x, _ema.value()));
+        }
+        break;
+    case Type::BOLLINGER:
+        _bollinger.append(kline.close);
+        if (_bollinger.isReady())
+        {
+            _line.append(QPointF(x, _bollinger.middle()));
+            _upper.append(QPointF(x, _bollinger.upper()));
+            _lower.append(QPointF(x, _bollinger.lower()));
+        }
+        break;
+    case Type::VWAP:
+        _vwap.append(kline);
+        _line.append(QPointF(x, _vwap.value()));
+        break;
+    case Type::RSI:
+        _rsi.append(kline);
+        if (_rsi.isReady())
+        {
+            _line.append(QPointF(x, _rsi.value()));
+        }
+        break;
+    case Type::ATR:
+        _atr.append(kline);
+        if (_atr.isReady())
+        {
+            _line.append(QPointF(x, _atr.value()));
+        }
+        break;
+    default:
+        Q_ASSERT(false);
+        break;
+    }
+}
+
+void KLineIndicators::clear()
+{
+    _sma.clear();
+    _ema.clear();
+    _bollinger.clear();
+    _vwap.clear();
+    _rsi.clear();
+    _atr.clear();
+
+    _line.clear();
+    _upper.clear();
+    _lower.clear();
+}
+
+const QList<QPointF> &KLineIndicators::line() const
+{
+    return _line;
+}
+
+const QList<QPointF> &KLineIndicators::upper() const
+{
+    return _upper;
+}
+
+const QList<QPointF> &KLineIndicators::lower() const
+{
+    return _lower;
+}
+
+bool KLineIndicators::isReady() const
+{
+    return !_line.isEmpty();
+}
+
+double KLineIndicators::lastValue() const
+{
+    return _line.isEmpty() ? 0.0 : _line.last().y();
+}
+
+qsizetype KLineIndicators::size() const
+{
+    return _line.size();
+}
+
+QString KLineIndicators::typeToString(Type type)
+{
+    switch (type)
+    {
+    case Type::NONE: return "No indicator";
+    case Type::SMA: return QString("SMA(%1)").arg(PERIOD);
+    case Type::EMA: return QString("EMA(%1)").arg(PERIOD);
+    case Type::BOLLINGER: return QString("Bollinger(%1, 2)").arg(PERIOD);
+    case Type::VWAP: return "VWAP";
+    case Type::RSI: return QString("RSI(%1)").arg(WILDER_PERIOD);
+    case Type::ATR: return QString("ATR(%1)").arg(WILDER_PERIOD);
+    default:
+        Q_ASSERT(false);
+    }
+
+    return QString();
+}
+
+KLineIndicators KLineIndicators::make(Type type, const KLines &klines)
+{
+    KLineIndicators result(type);
+
+    if (type == Type::NONE || klines.isEmpty())
+    {
+        return result;
+    }
+
+    result._line.reserve(klines.size());
+    if (type == Type::BOLLINGER)
+    {
+        result._upper.reserve(klines.size());
+        result._lower.reserve(klines.size());
+    }
+
+    if (klines.first().openTime <= klines.last().openTime)
+    {
+        for (auto kline_it = klines.begin(); kline_it != klines.end(); ++kline_it)
+        {
+            result.append(*kline_it);
+        }
+    }
+    else
+    {
+        for (auto kline_it = klines.rbegin(); kline_it != klines.rend(); ++kline_it)
+        {
+            result.append(*kline_it);
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,67 @@
+#ifndef KLINEINDICATORS_H
+#define KLINEINDICATORS_H
+
+//QT
+#include <QList>
+#include <QPointF>
+
+#include "types.h"
+
+//Линии индикатора для графика. Точки добавляются инкрементально (append()),
+//поэтому при поступлении новой свечи история не пересчитывается
+class KLineIndicators
+{
+public:
+    enum class Type: quint8
+    {
+        NONE = 0,
+        SMA = 1,
+        EMA = 2,
+        BOLLINGER = 3,
+        VWAP = 4,
+        RSI = 5,
+        ATR = 6
+    };
+
+    static const qsizetype PERIOD = 20; //период скользящих средних и полос Боллинджера
+    static const qsizetype WILDER_PERIOD = 14; //период RSI и ATR
+
+public:
+    explicit KLineIndicators(Type type);
+
+    Type type() const;
+    bool isOverlay() const; //true - значения в масштабе цены и рисуются поверх свечей
+
+    void append(const KLine& kline); //свечи должны идти по возрастанию времени
+    void clear();
+
+    const QList<QPointF>& line() const; //x - время закрытия свечи в мс
+    const QList<QPointF>& upper() const; //только для BOLLINGER
+    const QList<QPointF>& lower() const;
+
+    bool isReady() const;
+    double lastValue() const;
+
+    qsizetype size() const; //количество точек основной линии
+
+    static QString typeToString(Type type);
+
+    //строит линии по всей истории. Порядок свечей в klines - любой (история события хранится от новых к старым)
+    static KLineIndicators make(Type type, const KLines& klines);
+
+private:
+    Type _type = Type::NONE;
+
+    SMAIndicator _sma;
+    EMAIndicator _ema;
+    BollingerIndicator _bollinger;
+    VWAPIndicator _vwap;
+    RSIIndicator _rsi;
+    ATRIndicator _atr;
+
+    QList<QPointF> _line;
+    QList<QPointF> _upper;
+    QList<QPointF> _lower;
+};
+
+#endif // KLINEINDICATORS_H
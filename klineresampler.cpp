@@ -0,0 +1,118 @@
+//STL
+#include <algorithm>
+
+#include "klineresampler.h"
+
+//1970-01-01 - четверг, недельные свечи бирж начинаются с понедельника
+static const qint64 WEEK_OFFSET = 4 * static_cast<qint64>(KLineType::DAY1);
+
+KLineResampler::KLineResampler(KLineType type)
+    : _type(type)
+{
+    Q_ASSERT(_type != KLineType::UNKNOW);
+}
+
+KLineType KLineResampler::type() const
+{
+    return _type;
+}
+
+void KLineResampler::append(const KLine &kline)
+{
+    const auto openTime = kline.openTime.toMSecsSinceEpoch();
+    const auto start = bucketStart(openTime, _type);
+
+    if (!_klines.isEmpty() && _klines.last().openTime.toMSecsSinceEpoch() == start)
+    {
+        auto& last = _klines.last();
+        last.high = std::max(last.high, kline.high);
+        last.low = std::min(last.low, kline.low);
+        last.close = kline.close;
+        last.volume += kline.volume;
+        last.quoteAssetVolume += kline.quoteAssetVolume;
+
+        return;
+    }
+
+    Q_ASSERT(_klines.isEmpty() || _klines.last().openTime.toMSecsSinceEpoch() < start);
+
+    KLine tmp = kline;
+    tmp.id.type = _type;
+    tmp.openTime = QDateTime::fromMSecsSinceEpoch(start);
+    tmp.closeTime = QDateTime::fromMSecsSinceEpoch(start + static_cast<qint64>(_type) - 1);
+
+    _klines.emplaceBack(std::move(tmp));
+}
+
+void KLineResampler::clear()
+{
+    _klines.clear();
+}
+
+const KLines &KLineResampler::klines() const
+{
+    return _klines;
+}
+
+qint64 KLineResampler::bucketStart(qint64 time, KLineType type)
+{
+    const auto interval = static_cast<qint64>(type);
+    Q_ASSERT(interval > 0);
+
+    const auto offset = type == KLineType::WEEK1 ? WEEK_OFFSET : 0;
+    auto shifted = time - offset;
+    auto start = shifted - shifted % interval;
+    if (shifted < 0 && shifted % interval != 0)
+    {
+        start -= interval;
+    }
+
+    return start + offset;
+}
+
+bool KLineResampler::canResample(KLineType from, KLineType to)
+{
+    if (from == KLineType::UNKNOW || to == KLineType::UNKNOW)
+    {
+        return false;
+    }
+
+    const auto fromInterval = static_cast<qint64>(from);
+    const auto toInterval = static_cast<qint64>(to);
+
+    return toInterval >= fromInterval && toInterval % fromInterval == 0;
+}
+
+KLines KLineResampler::resample(const KLines &klines, KLineType type)
+{
+    if (klines.isEmpty())
+    {
+        return klines;
+    }
+
+    const bool isDescending = klines.first().openTime > klines.last().openTime;
+
+    KLineResampler resampler(type);
+    if (isDescending)
+    {
+        for (auto kline_it = klines.rbegin(); kline_it != klines.rend(); ++kline_it)
+        {
+            resampler.append(*kline_it);
+        }
+    }
+    else
+    {
+        for (const auto& kline: klines)
+        {
+            resampler.append(kline);
+        }
+    }
+
+    auto result = resampler.klines();
+    if (isDescending)
+    {
+        std::reverse(result.begin(), result.end());
+    }
+
+    return result;
+}
@@ -0,0 +1,31 @@
+#ifndef KLINERESAMPLER_H
+#define KLINERESAMPLER_H
+
+#include "types.h"
+
+//Построение свечей старшего интервала из свечей младшего.
+//В инкрементальном режиме (append()) пересчитывается только последняя свеча
+class KLineResampler
+{
+public:
+    explicit KLineResampler(KLineType type);
+
+    KLineType type() const;
+
+    void append(const KLine& kline); //добавляет свечу младшего интервала (свечи должны идти по возрастанию времени)
+    void clear();
+
+    const KLines& klines() const; //свечи старшего интервала по возрастанию времени
+
+    static qint64 bucketStart(qint64 time, KLineType type); //время открытия свечи интервала type, содержащей time
+    static bool canResample(KLineType from, KLineType to);
+
+    //пересчитывает всю историю. Порядок свечей в результате совпадает с порядком в klines
+    static KLines resample(const KLines& klines, KLineType type);
+
+private:
+    const KLineType _type = KLineType::UNKNOW;
+    KLines _klines;
+};
+
+#endif // KLINERESAMPLER_H
@@ -0,0 +1,135 @@
+#include "klineseries.h"
+
+static const QColor INCREASE_COLOR = QColor(Qt::green);
+static const QColor DECREASE_COLOR = QColor(Qt::red);
+static const QColor VOLUME_COLOR = QColor(61, 56, 70);
+
+KLineSeries::KLineSeries(QCandlestickSeries *series, QCandlestickSeries *seriesVolume, bool markFlatKLine)
+    : _series(series)
+    , _seriesVolume(seriesVolume)
+    , _markFlatKLine(markFlatKLine)
+{
+    Q_CHECK_PTR(_series);
+    Q_CHECK_PTR(_seriesVolume);
+}
+
+KLineSeries::~KLineSeries()
+{
+    qDeleteAll(_pool);
+    qDeleteAll(_poolVolume);
+}
+
+void KLineSeries::setKLines(const KLines &klines)
+{
+    resize(klines.size());
+
+    const auto sets = _series->sets();
+    const auto setsVolume = _seriesVolume->sets();
+
+    for (qsizetype i = 0; i < klines.size(); ++i)
+    {
+        const auto& kline = klines.at(i);
+        const auto timestamp = kline.closeTime.toMSecsSinceEpoch();
+
+        auto candlestick = sets.at(i);
+        candlestick->setTimestamp(timestamp);
+        candlestick->setHigh(kline.high);
+        candlestick->setLow(kline.low);
+        candlestick->setOpen(kline.open);
+        candlestick->setClose(_markFlatKLine && kline.open == kline.close ? kline.close + 0.001 * kline.close : kline.close);
+
+        const auto& color = kline.open <= kline.close ? INCREASE_COLOR : DECREASE_COLOR;
+        if (candlestick->pen().color() != color)
+        {
+            auto pen = _series->pen();
+            pen.setColor(color);
+            candlestick->setPen(pen);
+        }
+
+        auto candlestickVolume = setsVolume.at(i);
+        candlestickVolume->setTimestamp(timestamp);
+        candlestickVolume->setOpen(kline.volume);
+        candlestickVolume->setHigh(kline.volume);
+    }
+}
+
+void KLineSeries::clear()
+{
+    resize(0);
+}
+
+qsizetype KLineSeries::setCount() const
+{
+    return _series->count() + _seriesVolume->count() + _pool.size() + _poolVolume.size();
+}
+
+void KLineSeries::resize(qsizetype count)
+{
+    const auto currentCount = _series->count();
+
+    if (count < currentCount)
+    {
+        //лишние наборы не удаляются, а возвращаются в пул
+        const auto sets = _series->sets();
+        const auto setsVolume = _seriesVolume->sets();
+
+        QList<QCandlestickSet*> removeSets(sets.begin() + count, sets.end());
+        QList<QCandlestickSet*> removeSetsVolume(setsVolume.begin() + count, setsVolume.end());
+
+        for (auto candlestick: removeSets)
+        {
+            _series->take(candlestick);
+            _pool.push_back(candlestick);
+        }
+
+        for (auto candlestickVolume: removeSetsVolume)
+        {
+            _seriesVolume->take(candlestickVolume);
+            _poolVolume.push_back(candlestickVolume);
+        }
+
+        return;
+    }
+
+    if (count == currentCount)
+    {
+        return;
+    }
+
+    QList<QCandlestickSet*> addSets;
+    QList<QCandlestickSet*> addSetsVolume;
+    addSets.reserve(count - currentCount);
+    addSetsVolume.reserve(count - currentCount);
+
+    for (auto i = currentCount; i < count; ++i)
+    {
+        if (!_pool.isEmpty())
+        {
+            addSets.push_back(_pool.takeLast());
+        }
+        else
+        {
+            auto candlestick = new QCandlestickSet();
+            candlestick->setPen(_series->pen());
+            addSets.push_back(candlestick);
+        }
+
+        if (!_poolVolume.isEmpty())
+        {
+            addSetsVolume.push_back(_poolVolume.takeLast());
+        }
+        else
+        {
+            auto candlestickVolume = new QCandlestickSet();
+            candlestickVolume->setLow(0);
+            candlestickVolume->setClose(0);
+            auto penVolume = _seriesVolume->pen();
+            penVolume.setColor(VOLUME_COLOR);
+            candlestickVolume->setPen(penVolume);
+            addSetsVolume.push_back(candlestickVolume);
+        }
+    }
+
+    _series->append(addSets);
+    _seriesVolume->append(addSetsVolume);
+}
@@ -0,0 +1,37 @@
+#ifndef KLINESERIES_H
+#define KLINESERIES_H
+
+#include <QList>
+#include <QCandlestickSeries>
+#include <QCandlestickSet>
+
+#include "types.h"
+
+//Связка серий цены и объема графика. Наборы свечей переиспользуются между вызовами setKLines():
+//значения обновляются на месте, добавляются или удаляются только недостающие/лишние наборы
+class KLineSeries
+{
+public:
+    KLineSeries(QCandlestickSeries *series, QCandlestickSeries *seriesVolume, bool markFlatKLine);
+    ~KLineSeries();
+
+    void setKLines(const KLines& klines);
+    void clear();
+
+    qsizetype setCount() const; //наборы свечей в сериях и в пулах
+
+private:
+    Q_DISABLE_COPY_MOVE(KLineSeries)
+
+    void resize(qsizetype count);
+
+private:
+    QCandlestickSeries *_series = nullptr;       //серия цены (принадлежит графику)
+    QCandlestickSeries *_seriesVolume = nullptr; //серия объема (принадлежит графику)
+    const bool _markFlatKLine = false;           //рисовать свечу с open == close как растущую
+
+    QList<QCandlestickSet*> _pool;       //свободные наборы цены
+    QList<QCandlestickSet*> _poolVolume; //свободные наборы объема
+};
+
+#endif // KLINESERIES_H
@@ -0,0 +1,101 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDebug>
+
+#include "configstorage.h"
+#include "mappedklinestore.h"
+
+#include "klinestore.h"
+
+qsizetype KLineColumns::size() const
+{
+    return static_cast<qsizetype>(openTime.size());
+}
+
+bool KLineColumns::isEmpty() const
+{
+    return openTime.empty();
+}
+
+KLineColumns KLineColumns::subspan(qsizetype first, qsizetype count) const
+{
+    Q_ASSERT(first >= 0 && count >= 0 && first + count <= size());
+
+    KLineColumns result;
+    result.openTime = openTime.subspan(first, count);
+    result.closeTime = closeTime.subspan(first, count);
+    result.open = open.subspan(first, count);
+    result.high = high.subspan(first, count);
+    result.low = low.subspan(first, count);
+    result.close = close.subspan(first, count);
+    result.volume = volume.subspan(first, count);
+    result.quoteAssetVolume = quoteAssetVolume.subspan(first, count);
+
+    return result;
+}
+
+qsizetype KLineColumns::upperBound(qint64 time) const
+{
+    return std::upper_bound(openTime.begin(), openTime.end(), time) - openTime.begin();
+}
+
+qsizetype KLineStore::size() const
+{
+    return columns().size();
+}
+
+KLines KLineStore::klines(qsizetype first, qsizetype count) const
+{
+    const auto allColumns = columns();
+
+    first = std::clamp<qsizetype>(first, 0, allColumns.size());
+    count = std::clamp<qsizetype>(count, 0, allColumns.size() - first);
+
+    const auto range = allColumns.subspan(first, count);
+
+    KLines result;
+    result.reserve(count);
+
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        KLine kline;
+        kline.id = id();
+        kline.openTime = QDateTime::fromMSecsSinceEpoch(range.openTime[i]);
+        kline.closeTime = QDateTime::fromMSecsSinceEpoch(range.closeTime[i]);
+        kline.open = range.open[i];
+        kline.high = range.high[i];
+        kline.low = range.low[i];
+        kline.close = range.close[i];
+        kline.volume = range.volume[i];
+        kline.quoteAssetVolume = range.quoteAssetVolume[i];
+
+        result.push_back(std::move(kline));
+    }
+
+    return result;
+}
+
+KLineStore *KLineStore::make(const StockExchangeID &stockExchangeID, const KLineID &id)
+{
+#ifdef __EMSCRIPTEN__
+    //в браузере отображение файлов в память не дает выигрыша - история остается в событиях
+    Q_UNUSED(stockExchangeID);
+    Q_UNUSED(id);
+
+    return nullptr;
+#else
+    auto store = new MappedKLineStore(ConfigStorage::offlineDir() + "/klines", stockExchangeID, id);
+    if (!store->open())
+    {
+        qDebug() << "Cannot open candle store:" << store->errorString();
+
+        delete store;
+
+        return nullptr;
+    }
+
+    return store;
+#endif
+}
@@ -0,0 +1,51 @@
+#ifndef KLINESTORE_H
+#define KLINESTORE_H
+
+//STL
+#include <span>
+
+#include "types.h"
+
+struct KLineColumns //история свечей по столбцам, по возрастанию времени. Данные не копируются
+{
+    std::span<const qint64> openTime; //мс с начала эпохи
+    std::span<const qint64> closeTime;
+    std::span<const double> open;
+    std::span<const double> high;
+    std::span<const double> low;
+    std::span<const double> close;
+    std::span<const double> volume;
+    std::span<const double> quoteAssetVolume;
+
+    qsizetype size() const;
+    bool isEmpty() const;
+
+    KLineColumns subspan(qsizetype first, qsizetype count) const;
+    qsizetype upperBound(qint64 time) const; //индекс первой свечи, открытой позже time
+};
+
+//Хранилище истории свечей одного инструмента
+class KLineStore
+{
+public:
+    virtual ~KLineStore() = default;
+
+    virtual const KLineID& id() const = 0;
+
+    //добавляет свечи новее последней сохраненной. Свеча с временем открытия последней сохраненной заменяет ее
+    //(незакрытая свеча), более старые пропускаются. Порядок klines - любой, из повторов одной свечи берется последний.
+    //Возвращает количество записанных свечей, включая замененную
+    virtual qsizetype append(const KLines& klines) = 0;
+
+    //столбцы действительны до следующего вызова append()
+    virtual KLineColumns columns() const = 0;
+
+    qsizetype size() const;
+
+    KLines klines(qsizetype first, qsizetype count) const; //копия диапазона для кода, работающего с KLines
+
+    //хранилище для текущей сборки. nullptr - сборка не хранит историю свечей
+    static KLineStore* make(const StockExchangeID& stockExchangeID, const KLineID& id);
+};
+
+#endif // KLINESTORE_H
@@ -0,0 +1,149 @@
+//Qt
+#include <QDebug>
+
+#include "klinestorecache.h"
+
+static const int FLUSH_DELAY = 1000; //ms задержка записи после первого незаписанного события
+
+KLineStoreCache::KLineStoreCache(int maxOpenStores)
+{
+    Q_ASSERT(maxOpenStores > 0);
+
+    _stores.setMaxCost(maxOpenStores);
+
+    _flushTimer.setSingleShot(true);
+    _flushTimer.setInterval(FLUSH_DELAY);
+    QObject::connect(&_flushTimer, &QTimer::timeout, [this](){ flush(); });
+}
+
+KLineStoreCache::~KLineStoreCache()
+{
+    flush();
+}
+
+void KLineStoreCache::append(const StockExchangeID &stockExchangeID, const KLines &klines)
+{
+    if (klines.isEmpty())
+    {
+        return;
+    }
+
+    const auto& id = klines.first().id;
+    const auto storeKey = key(stockExchangeID, id);
+    if (_unavailableKeys.contains(storeKey))
+    {
+        return;
+    }
+
+    auto& pendingKLines = _pendingKLines[storeKey];
+    if (pendingKLines.histories.isEmpty())
+    {
+        pendingKLines.stockExchangeID = stockExchangeID;
+        pendingKLines.id = id;
+    }
+    pendingKLines.histories.push_back(klines);
+
+    //не перезапускаем таймер: при непрерывном потоке событий запись все равно происходит раз в FLUSH_DELAY
+    if (!_flushTimer.isActive())
+    {
+        _flushTimer.start();
+    }
+}
+
+void KLineStoreCache::flush()
+{
+    _flushTimer.stop();
+
+    const auto keys = _pendingKLines.keys();
+    for (const auto& storeKey: keys)
+    {
+        flush(storeKey);
+    }
+}
+
+KLineColumns KLineStoreCache::columns(const StockExchangeID &stockExchangeID, const KLineID &id)
+{
+    const auto storeKey = key(stockExchangeID, id);
+
+    //график должен видеть и свечи, которые еще ждут записи
+    flush(storeKey);
+
+    const auto klineStore = store(storeKey, stockExchangeID, id);
+    if (klineStore == nullptr)
+    {
+        return KLineColumns();
+    }
+
+    return klineStore->columns();
+}
+
+qsizetype KLineStoreCache::openStoreCount() const
+{
+    return _stores.size();
+}
+
+QString KLineStoreCache::key(const StockExchangeID &stockExchangeID, const KLineID &id)
+{
+    return QString("%1/%2/%3").arg(stockExchangeID.name).arg(id.symbol).arg(KLineTypeToString(id.type));
+}
+
+KLineStore *KLineStoreCache::store(const QString &key, const StockExchangeID &stockExchangeID, const KLineID &id)
+{
+    if (_unavailableKeys.contains(key))
+    {
+        return nullptr;
+    }
+
+    auto result = _stores.object(key);
+    if (result != nullptr)
+    {
+        return result;
+    }
+
+    result = KLineStore::make(stockExchangeID, id);
+    if (result == nullptr)
+    {
+        _unavailableKeys.insert(key);
+
+        return nullptr;
+    }
+
+    //при превышении размера QCache закрывает давно не использованные хранилища
+    _stores.insert(key, result);
+
+    return result;
+}
+
+void KLineStoreCache::flush(const QString &key)
+{
+    const auto pendingKLines_it = _pendingKLines.find(key);
+    if (pendingKLines_it == _pendingKLines.end())
+    {
+        return;
+    }
+
+    const auto pendingKLines = pendingKLines_it.value();
+    _pendingKLines.erase(pendingKLines_it);
+
+    auto klineStore = store(key, pendingKLines.stockExchangeID, pendingKLines.id);
+    if (klineStore == nullptr)
+    {
+        return;
+    }
+
+    //все истории инструмента дописываются одним вызовом append() - файлы синхронизируются один раз
+    if (pendingKLines.histories.size() == 1)
+    {
+        klineStore->append(pendingKLines.histories.first());
+
+        return;
+    }
+
+    KLines klines;
+    for (const auto& history: pendingKLines.histories)
+    {
+        klines.append(history);
+    }
+
+    klineStore->append(klines);
+}
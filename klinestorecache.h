@@ -0,0 +1,55 @@
+#ifndef KLINESTORECACHE_H
+#define KLINESTORECACHE_H
+
+//Qt
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QCache>
+#include <QTimer>
+
+#include "types.h"
+#include "klinestore.h"
+
+//Накопленная история свечей инструментов для событий и графиков.
+//Открытыми держатся только недавно использованные хранилища (у каждого по файлу на столбец).
+//Свечи новых событий копятся и дописываются пакетом - одна синхронизация файлов хранилища на пакет, а не на событие
+class KLineStoreCache
+{
+public:
+    explicit KLineStoreCache(int maxOpenStores);
+    ~KLineStoreCache();
+
+    void append(const StockExchangeID& stockExchangeID, const KLines& klines); //запись откладывается до flush()
+    void flush(); //дописывает накопленные свечи во все хранилища
+
+    //история инструмента вместе с еще не записанными свечами. Пусто - сборка не хранит историю.
+    //Столбцы действительны до следующего вызова методов кеша
+    KLineColumns columns(const StockExchangeID& stockExchangeID, const KLineID& id);
+
+    qsizetype openStoreCount() const;
+
+private:
+    Q_DISABLE_COPY_MOVE(KLineStoreCache)
+
+    struct PendingKLines //свечи одного инструмента, ожидающие записи
+    {
+        StockExchangeID stockExchangeID;
+        KLineID id;
+        QList<KLines> histories; //истории событий без копирования
+    };
+
+    static QString key(const StockExchangeID& stockExchangeID, const KLineID& id);
+
+    KLineStore* store(const QString& key, const StockExchangeID& stockExchangeID, const KLineID& id);
+    void flush(const QString& key);
+
+private:
+    QCache<QString, KLineStore> _stores; //LRU: вытесненное хранилище закрывается
+    QSet<QString> _unavailableKeys; //хранилища, которые не удалось открыть, - повторно не открываем
+    QHash<QString, PendingKLines> _pendingKLines;
+    QTimer _flushTimer;
+};
+
+#endif // KLINESTORECACHE_H
@@ -0,0 +1,280 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDebug>
+#include <QFile>
+#include <QSet>
+#include <QDateTime>
+#include <QTextStream>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRandomGenerator>
+
+#include "loadgenerator.h"
+
+static const qint64 RAMP_TICK = 100; //ms
+static const qint64 CONFIG_TICK = 1000; //ms
+static const double MIN_DELTA = 1.0; //% границы случайного порога фильтра
+static const double MAX_DELTA = 20.0;
+static const double MAX_VOLUME = 1000000.0;
+
+LoadGenerator::LoadGenerator(const Config &config, QObject *parent /* = nullptr */)
+    : QObject{parent}
+    , _config(config)
+{
+    Q_ASSERT(_config.sessionCount > 0);
+
+    _rampTimer = new QTimer(this);
+    QObject::connect(_rampTimer, SIGNAL(timeout()), SLOT(rampTimer_timeout()));
+
+    _configTimer = new QTimer(this);
+    QObject::connect(_configTimer, SIGNAL(timeout()), SLOT(configTimer_timeout()));
+
+    _reportTimer = new QTimer(this);
+    QObject::connect(_reportTimer, SIGNAL(timeout()), SLOT(reportTimer_timeout()));
+}
+
+LoadGenerator::~LoadGenerator()
+{
+    //задачи удаленных сеансов в _parserPool не вызывают callback, пул дожидается их при удалении
+    qDeleteAll(_sessions);
+}
+
+void LoadGenerator::start()
+{
+    _sessions.reserve(_config.sessionCount);
+
+    _startTime.start();
+    _reportTime.start();
+
+    if (_config.rampUp > 0)
+    {
+        _rampTimer->start(RAMP_TICK);
+    }
+    else
+    {
+        rampTimer_timeout();
+    }
+
+    if (_config.configInterval > 0)
+    {
+        _configTimer->start(CONFIG_TICK);
+    }
+
+    _reportTimer->start(_config.reportInterval);
+
+    if (_config.duration > 0)
+    {
+        QTimer::singleShot(_config.duration, this, SLOT(finish()));
+    }
+
+    QTextStream(stdout) << "Starting " << _config.sessionCount << " sessions to " << _config.serverURL
+                        << " in " << _config.rampUp / 1000.0 << " s" << Qt::endl;
+}
+
+void LoadGenerator::rampTimer_timeout()
+{
+    //сеансы запускаются равномерно, иначе все /newuser и /login приходят на сервер одновременно
+    auto targetCount = _config.sessionCount;
+    if (_config.rampUp > 0)
+    {
+        targetCount = std::min<qsizetype>(_config.sessionCount, _config.sessionCount * _startTime.elapsed() / _config.rampUp);
+    }
+
+    while (_sessions.size() < targetCount)
+    {
+        addSession();
+    }
+
+    if (_sessions.size() >= _config.sessionCount)
+    {
+        _rampTimer->stop();
+    }
+}
+
+void LoadGenerator::configTimer_timeout()
+{
+    if (_sessions.isEmpty())
+    {
+        return;
+    }
+
+    //обходим сеансы по кругу: каждый меняет фильтр в среднем раз в configInterval
+    _configChangeCount += static_cast<double>(_sessions.size()) * CONFIG_TICK / _config.configInterval;
+
+    while (_configChangeCount >= 1.0)
+    {
+        _configChangeCount -= 1.0;
+
+        auto session = _sessions[_configSessionIndex % _sessions.size()];
+        _configSessionIndex = (_configSessionIndex + 1) % _sessions.size();
+
+        if (session->isOnline())
+        {
+            changeFilter(session);
+        }
+    }
+}
+
+void LoadGenerator::reportTimer_timeout()
+{
+    const auto report = _statistic.report(_reportTime.restart(), onlineCount(), _sessions.size());
+
+    QTextStream(stdout) << "[" << _startTime.elapsed() / 1000 << " s] " << report << Qt::endl;
+}
+
+void LoadGenerator::finish()
+{
+    _rampTimer->stop();
+    _configTimer->stop();
+    _reportTimer->stop();
+
+    QTextStream(stdout) << _statistic.summary(_startTime.elapsed()) << Qt::endl;
+
+    saveJSON();
+
+    emit finished();
+}
+
+void LoadGenerator::addSession()
+{
+    auto session = new Session(_config.serverURL);
+    session->setParserPool(&_parserPool);
+
+    QObject::connect(session, &Session::requestFinished, session,
+        [this](Session::HTTPRequstType type, qint64 latency, bool isError)
+        {
+            _statistic.addRequest(type, latency, isError);
+        });
+
+    QObject::connect(session, &Session::eventsReceived, session,
+        [this](const QList<KLineData>& klines)
+        {
+            _statistic.addEvents(klines.size());
+        });
+
+    QObject::connect(session, &Session::connectionLost, session,
+        [this]()
+        {
+            _statistic.addReconnect();
+        });
+
+    QObject::connect(session, &Session::catalogReceived, session,
+        [this, session]()
+        {
+            if (_catalogRules.isEmpty())
+            {
+                makeCatalogRules(session->catalog());
+            }
+
+            //после повторного входа сервер возвращает уже заданный фильтр
+            if (session->filter().toList().isEmpty() && !_catalogRules.isEmpty())
+            {
+                session->setFilter(makeFilter());
+                session->flushConfig();
+            }
+        });
+
+    session->start(QString(), QString());
+
+    _sessions.push_back(session);
+}
+
+void LoadGenerator::makeCatalogRules(const ExistsStockExchange &catalog)
+{
+    for (auto stockExchange_it = catalog.begin(); stockExchange_it != catalog.end(); ++stockExchange_it)
+    {
+        for (auto money_it = stockExchange_it.value().begin(); money_it != stockExchange_it.value().end(); ++money_it)
+        {
+            for (const auto& interval: money_it.value())
+            {
+                FilterRule rule;
+                rule.stockExchange = stockExchange_it.key();
+                rule.symbol = money_it.key();
+                rule.type = stringToKLineType(interval);
+
+                if (rule.type != KLineType::UNKNOW)
+                {
+                    _catalogRules.push_back(rule);
+                }
+            }
+        }
+    }
+}
+
+Filter LoadGenerator::makeFilter() const
+{
+    //правила с разными ключами - иначе сервер получает фильтр целиком вместо изменений
+    QSet<qsizetype> ruleIndexes;
+    const auto ruleCount = std::min(_config.filterSize, _catalogRules.size());
+    while (ruleIndexes.size() < ruleCount)
+    {
+        ruleIndexes.insert(QRandomGenerator::global()->bounded(_catalogRules.size()));
+    }
+
+    Filter filter;
+    for (const auto index: ruleIndexes)
+    {
+        const auto& rule = _catalogRules[index];
+
+        Filter::FilterData filterData;
+        filterData.stockExchangeID.name = rule.stockExchange;
+        filterData.klineID.symbol = rule.symbol;
+        filterData.klineID.type = rule.type;
+        filterData.delta = MIN_DELTA + QRandomGenerator::global()->bounded(MAX_DELTA - MIN_DELTA);
+        filterData.volume = QRandomGenerator::global()->bounded(MAX_VOLUME);
+
+        filter.addFilter(filterData);
+    }
+
+    return filter;
+}
+
+void LoadGenerator::changeFilter(Session *session) const
+{
+    auto filterDataList = session->filter().toList();
+    if (filterDataList.isEmpty())
+    {
+        return;
+    }
+
+    auto& filterData = filterDataList[QRandomGenerator::global()->bounded(filterDataList.size())];
+    filterData.delta = MIN_DELTA + QRandomGenerator::global()->bounded(MAX_DELTA - MIN_DELTA);
+
+    Filter filter;
+    filter.fromList(filterDataList);
+
+    session->setFilter(filter);
+    session->flushConfig();
+}
+
+qsizetype LoadGenerator::onlineCount() const
+{
+    return std::count_if(_sessions.begin(), _sessions.end(), [](const Session* session){ return session->isOnline(); });
+}
+
+bool LoadGenerator::saveJSON() const
+{
+    if (_config.outputFileName.isEmpty())
+    {
+        return true;
+    }
+
+    auto json = _statistic.toJSON(_startTime.elapsed());
+    json.insert("Date", QDateTime::currentDateTime().toString(Qt::ISODate));
+    json.insert("Server", _config.serverURL);
+    json.insert("Sessions", _config.sessionCount);
+
+    QFile file(_config.outputFileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot save load test result:" << _config.outputFileName << file.errorString();
+
+        return false;
+    }
+
+    file.write(QJsonDocument(json).toJson(QJsonDocument::Indented));
+
+    return true;
+}
@@ -0,0 +1,92 @@
+#ifndef LOADGENERATOR_H
+#define LOADGENERATOR_H
+
+//Qt
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QJsonArray>
+
+#include "session.h"
+#include "filter.h"
+
+#include "loadstatistic.h"
+
+//Имитация многих независимых пользователей в одном процессе.
+//Каждый сеанс проходит свой цикл newuser/login/config/data со своим фильтром, все сеансы используют
+//общий цикл событий, общий пул соединений HTTPSQuery и общий пул разбора ответов
+class LoadGenerator : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config
+    {
+        QString serverURL;
+        qsizetype sessionCount = 100;
+        qint64 rampUp = 10000;          //ms за которое запускаются все сеансы
+        qint64 duration = 60000;        //ms, 0 - до остановки процесса
+        qsizetype filterSize = 10;      //правил в фильтре каждого пользователя
+        qint64 configInterval = 60000;  //ms среднее время между изменениями фильтра одного пользователя, 0 - не менять
+        qint64 reportInterval = 10000;  //ms
+        QString outputFileName;         //итог в JSON, пусто - не записывать
+    };
+
+public:
+    explicit LoadGenerator(const Config& config, QObject *parent = nullptr);
+    ~LoadGenerator();
+
+    void start();
+
+signals:
+    void finished(); //истекло время теста, итог выведен
+
+private slots:
+    void rampTimer_timeout();
+    void configTimer_timeout();
+    void reportTimer_timeout();
+    void finish();
+
+private:
+    struct FilterRule //строка каталога: биржа, монета, интервал
+    {
+        QString stockExchange;
+        QString symbol;
+        KLineType type = KLineType::UNKNOW;
+    };
+
+private:
+    Q_DISABLE_COPY_MOVE(LoadGenerator)
+
+    void addSession();
+    void makeCatalogRules(const ExistsStockExchange& catalog);
+    Filter makeFilter() const;
+    void changeFilter(Session* session) const;
+    qsizetype onlineCount() const;
+    bool saveJSON() const;
+
+private:
+    const Config _config;
+
+    QThreadPool _parserPool; //общий для всех сеансов - иначе по потоку на сеанс
+    QList<Session*> _sessions;
+
+    QList<FilterRule> _catalogRules; //каталог первого ответа /klines, одинаков для всех пользователей
+
+    LoadStatistic _statistic;
+
+    QElapsedTimer _startTime;
+    QElapsedTimer _reportTime;
+
+    QTimer *_rampTimer = nullptr;
+    QTimer *_configTimer = nullptr;
+    QTimer *_reportTimer = nullptr;
+
+    double _configChangeCount = 0.0; //накопленная дробная часть изменений фильтров
+    qsizetype _configSessionIndex = 0; //следующий сеанс для изменения фильтра
+};
+
+#endif // LOADGENERATOR_H
@@ -0,0 +1,279 @@
+//STL
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+//Qt
+#include <QJsonArray>
+
+#include "loadstatistic.h"
+
+static double toMs(qint64 latency)
+{
+    return static_cast<double>(latency) / 1000.0;
+}
+
+static double perSecond(quint64 count, qint64 duration)
+{
+    return duration > 0 ? static_cast<double>(count) * 1000.0 / static_cast<double>(duration) : 0.0;
+}
+
+static double percent(quint64 part, quint64 count)
+{
+    return count > 0 ? static_cast<double>(part) * 100.0 / static_cast<double>(count) : 0.0;
+}
+
+void LatencyHistogram::add(qint64 latency)
+{
+    ++_buckets[bucket(latency)];
+    ++_count;
+    _max = std::max(_max, latency);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &histogram)
+{
+    for (qsizetype i = 0; i < BUCKET_COUNT; ++i)
+    {
+        _buckets[i] += histogram._buckets[i];
+    }
+
+    _count += histogram._count;
+    _max = std::max(_max, histogram._max);
+}
+
+void LatencyHistogram::clear()
+{
+    _buckets.fill(0);
+    _count = 0;
+    _max = 0;
+}
+
+quint64 LatencyHistogram::count() const
+{
+    return _count;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (_count == 0)
+    {
+        return 0;
+    }
+
+    const auto target = std::max<quint64>(1, static_cast<quint64>(std::ceil(p * static_cast<double>(_count))));
+
+    quint64 sum = 0;
+    for (qsizetype i = 0; i < BUCKET_COUNT; ++i)
+    {
+        sum += _buckets[i];
+        if (sum >= target)
+        {
+            return std::min(bucketUpperBound(i), _max);
+        }
+    }
+
+    return _max;
+}
+
+qint64 LatencyHistogram::max() const
+{
+    return _max;
+}
+
+qsizetype LatencyHistogram::bucket(qint64 latency)
+{
+    if (latency < SUB_BUCKET_COUNT)
+    {
+        return std::max<qint64>(latency, 0);
+    }
+
+    //старшие SUB_BUCKET_BITS + 1 бит значения: степень двойки и номер корзины внутри нее
+    const auto shift = static_cast<int>(std::bit_width(static_cast<quint64>(latency))) - 1 - SUB_BUCKET_BITS;
+    const qint64 result = (shift + 1) * SUB_BUCKET_COUNT + ((latency >> shift) - SUB_BUCKET_COUNT);
+
+    return static_cast<qsizetype>(std::min<qint64>(result, BUCKET_COUNT - 1));
+}
+
+qint64 LatencyHistogram::bucketUpperBound(qsizetype bucket)
+{
+    if (bucket < SUB_BUCKET_COUNT)
+    {
+        return bucket;
+    }
+
+    const auto shift = bucket / SUB_BUCKET_COUNT - 1;
+    const auto subBucket = bucket % SUB_BUCKET_COUNT;
+
+    return (static_cast<qint64>(SUB_BUCKET_COUNT + subBucket + 1) << shift) - 1;
+}
+
+void LoadStatistic::Counters::merge(const Counters &counters)
+{
+    for (qsizetype i = 0; i < TYPE_COUNT; ++i)
+    {
+        requests[i].errorCount += counters.requests[i].errorCount;
+        requests[i].latency.merge(counters.requests[i].latency);
+    }
+
+    eventCount += counters.eventCount;
+    reconnectCount += counters.reconnectCount;
+}
+
+void LoadStatistic::Counters::clear()
+{
+    for (auto& request: requests)
+    {
+        request.errorCount = 0;
+        request.latency.clear();
+    }
+
+    eventCount = 0;
+    reconnectCount = 0;
+}
+
+void LoadStatistic::addRequest(Session::HTTPRequstType type, qint64 latency, bool isError)
+{
+    auto& request = _interval.requests[static_cast<qsizetype>(type)];
+
+    request.latency.add(latency);
+    if (isError)
+    {
+        ++request.errorCount;
+    }
+}
+
+void LoadStatistic::addEvents(qsizetype count)
+{
+    _interval.eventCount += count;
+}
+
+void LoadStatistic::addReconnect()
+{
+    ++_interval.reconnectCount;
+}
+
+QString LoadStatistic::report(qint64 interval, qsizetype onlineCount, qsizetype sessionCount)
+{
+    auto result = QString("Sessions online: %1 of %2 Events: %3 Reconnects: %4\n")
+                      .arg(onlineCount)
+                      .arg(sessionCount)
+                      .arg(_interval.eventCount)
+                      .arg(_interval.reconnectCount);
+
+    result += makeTable(_interval, interval);
+
+    _total.merge(_interval);
+    _interval.clear();
+
+    return result;
+}
+
+QString LoadStatistic::summary(qint64 duration) const
+{
+    auto total = _total;
+    total.merge(_interval);
+
+    auto result = QString("Total for %1 s Events: %2 Reconnects: %3\n")
+                      .arg(static_cast<double>(duration) / 1000.0, 0, 'f', 1)
+                      .arg(total.eventCount)
+                      .arg(total.reconnectCount);
+
+    result += makeTable(total, duration);
+
+    return result;
+}
+
+QJsonObject LoadStatistic::toJSON(qint64 duration) const
+{
+    auto total = _total;
+    total.merge(_interval);
+
+    LatencyHistogram allLatency;
+    quint64 allErrorCount = 0;
+
+    QJsonArray methodsJson;
+    for (qsizetype i = 0; i < TYPE_COUNT; ++i)
+    {
+        const auto& request = total.requests[i];
+        if (request.latency.count() == 0)
+        {
+            continue;
+        }
+
+        allLatency.merge(request.latency);
+        allErrorCount += request.errorCount;
+
+        QJsonObject methodJson;
+        methodJson.insert("Name", Session::requestTypeName(static_cast<Session::HTTPRequstType>(i)));
+        methodJson.insert("Requests", static_cast<qint64>(request.latency.count()));
+        methodJson.insert("Errors", static_cast<qint64>(request.errorCount));
+        methodJson.insert("RequestsPerSecond", perSecond(request.latency.count(), duration));
+        methodJson.insert("P50", toMs(request.latency.percentile(0.5)));
+        methodJson.insert("P90", toMs(request.latency.percentile(0.9)));
+        methodJson.insert("P99", toMs(request.latency.percentile(0.99)));
+        methodJson.insert("Max", toMs(request.latency.max()));
+
+        methodsJson.push_back(methodJson);
+    }
+
+    QJsonObject json;
+    json.insert("Duration", static_cast<double>(duration) / 1000.0);
+    json.insert("Requests", static_cast<qint64>(allLatency.count()));
+    json.insert("Errors", static_cast<qint64>(allErrorCount));
+    json.insert("RequestsPerSecond", perSecond(allLatency.count(), duration));
+    json.insert("ErrorRate", percent(allErrorCount, allLatency.count()));
+    json.insert("P50", toMs(allLatency.percentile(0.5)));
+    json.insert("P90", toMs(allLatency.percentile(0.9)));
+    json.insert("P99", toMs(allLatency.percentile(0.99)));
+    json.insert("Max", toMs(allLatency.max()));
+    json.insert("Events", static_cast<qint64>(total.eventCount));
+    json.insert("Reconnects", static_cast<qint64>(total.reconnectCount));
+    json.insert("Methods", methodsJson);
+
+    return json;
+}
+
+QString LoadStatistic::makeTable(const Counters &counters, qint64 duration)
+{
+    auto result = QString("%1 %2 %3 %4 %5 %6 %7\n")
+                      .arg("Method", -8)
+                      .arg("RPS", 10)
+                      .arg("Errors,%", 9)
+                      .arg("p50,ms", 9)
+                      .arg("p90,ms", 9)
+                      .arg("p99,ms", 9)
+                      .arg("max,ms", 9);
+
+    const auto addRow = [&result, duration](const QString& name, const LatencyHistogram& latency, quint64 errorCount)
+    {
+        result += QString("%1 %2 %3 %4 %5 %6 %7\n")
+                      .arg(name, -8)
+                      .arg(perSecond(latency.count(), duration), 10, 'f', 1)
+                      .arg(percent(errorCount, latency.count()), 9, 'f', 2)
+                      .arg(toMs(latency.percentile(0.5)), 9, 'f', 1)
+                      .arg(toMs(latency.percentile(0.9)), 9, 'f', 1)
+                      .arg(toMs(latency.percentile(0.99)), 9, 'f', 1)
+                      .arg(toMs(latency.max()), 9, 'f', 1);
+    };
+
+    LatencyHistogram allLatency;
+    quint64 allErrorCount = 0;
+
+    for (qsizetype i = 0; i < TYPE_COUNT; ++i)
+    {
+        const auto& request = counters.requests[i];
+        if (request.latency.count() == 0)
+        {
+            continue;
+        }
+
+        addRow(Session::requestTypeName(static_cast<Session::HTTPRequstType>(i)), request.latency, request.errorCount);
+
+        allLatency.merge(request.latency);
+        allErrorCount += request.errorCount;
+    }
+
+    addRow("total", allLatency, allErrorCount);
+
+    return result;
+}
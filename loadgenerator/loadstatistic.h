@@ -0,0 +1,86 @@
+#ifndef LOADSTATISTIC_H
+#define LOADSTATISTIC_H
+
+//STL
+#include <array>
+
+//Qt
+#include <QString>
+#include <QJsonObject>
+
+#include "session.h"
+
+//Гистограмма времени ответа с постоянным объемом памяти.
+//16 корзин на каждую степень двойки - погрешность перцентиля не более 1/16
+class LatencyHistogram
+{
+public:
+    LatencyHistogram() = default;
+
+    void add(qint64 latency); //мкс
+    void merge(const LatencyHistogram& histogram);
+    void clear();
+
+    quint64 count() const;
+    qint64 percentile(double p) const; //p = 0..1, мкс
+    qint64 max() const;
+
+private:
+    static qsizetype bucket(qint64 latency);
+    static qint64 bucketUpperBound(qsizetype bucket);
+
+private:
+    static const int SUB_BUCKET_BITS = 4;
+    static const qsizetype SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static const qsizetype BUCKET_COUNT = SUB_BUCKET_COUNT * 40; //до 2^43 мкс
+
+    std::array<quint64, BUCKET_COUNT> _buckets = {};
+    quint64 _count = 0;
+    qint64 _max = 0;
+};
+
+//Сводная статистика запросов всех сеансов: отдельно за интервал отчета и за все время
+class LoadStatistic
+{
+public:
+    LoadStatistic() = default;
+
+    void addRequest(Session::HTTPRequstType type, qint64 latency, bool isError); //latency - мкс
+    void addEvents(qsizetype count);
+    void addReconnect();
+
+    //текст отчета за интервал interval мс, после чего интервал добавляется к итогу и начинается заново
+    QString report(qint64 interval, qsizetype onlineCount, qsizetype sessionCount);
+    QString summary(qint64 duration) const; //итог за duration мс
+    QJsonObject toJSON(qint64 duration) const;
+
+private:
+    static const qsizetype TYPE_COUNT = static_cast<qsizetype>(Session::HTTPRequstType::DATA) + 1;
+
+    struct RequestCounters
+    {
+        quint64 errorCount = 0;
+        LatencyHistogram latency;
+    };
+
+    struct Counters
+    {
+        std::array<RequestCounters, TYPE_COUNT> requests;
+        quint64 eventCount = 0;
+        quint64 reconnectCount = 0;
+
+        void merge(const Counters& counters);
+        void clear();
+    };
+
+private:
+    Q_DISABLE_COPY_MOVE(LoadStatistic)
+
+    static QString makeTable(const Counters& counters, qint64 duration);
+
+private:
+    Counters _interval;
+    Counters _total;
+};
+
+#endif // LOADSTATISTIC_H
@@ -0,0 +1,72 @@
+//Qt
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QLoggingCategory>
+#include <QDebug>
+
+#include "httpsquery.h"
+
+#include "loadgenerator.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCoreApplication::setApplicationName("TradingCatLoadGenerator");
+    QCoreApplication::setOrganizationName("Cat software development");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Simulates many TradingCat users in one process and reports requests per second, "
+                                     "latency percentiles and error rates. Latency includes waiting for a free connection.");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("server", "Server URL.", "url", "http://localhost:59923"));
+    parser.addOption(QCommandLineOption("sessions", "Number of simulated users.", "count", "100"));
+    parser.addOption(QCommandLineOption("ramp-up", "Seconds to start all sessions.", "seconds", "10"));
+    parser.addOption(QCommandLineOption("duration", "Test duration in seconds, 0 - until the process is stopped.", "seconds", "60"));
+    parser.addOption(QCommandLineOption("filter-size", "Filter rules of each user.", "count", "10"));
+    parser.addOption(QCommandLineOption("config-interval", "Average seconds between filter changes of one user, 0 - never.", "seconds", "60"));
+    parser.addOption(QCommandLineOption("report-interval", "Seconds between reports.", "seconds", "10"));
+    parser.addOption(QCommandLineOption("output", "Write the total result as JSON to <file>.", "file"));
+    parser.addOption(QCommandLineOption("replay", "Take server answers from <file> recorded with the client --capture option.", "file"));
+    parser.addOption(QCommandLineOption("replay-speed", "Replay speed: 1 - real time, N - N times faster, 0 - as fast as possible.", "speed", "1"));
+    parser.addOption(QCommandLineOption("connections", "HTTP/1.1 connections per server host shared by all sessions, 0 - Qt default (6).", "count", "0"));
+    parser.addOption(QCommandLineOption("verbose", "Print messages of every session."));
+    parser.process(a);
+
+    LoadGenerator::Config config;
+    config.serverURL = parser.value("server");
+    config.sessionCount = parser.value("sessions").toLongLong();
+    config.rampUp = static_cast<qint64>(parser.value("ramp-up").toDouble() * 1000.0);
+    config.duration = static_cast<qint64>(parser.value("duration").toDouble() * 1000.0);
+    config.filterSize = parser.value("filter-size").toLongLong();
+    config.configInterval = static_cast<qint64>(parser.value("config-interval").toDouble() * 1000.0);
+    config.reportInterval = static_cast<qint64>(parser.value("report-interval").toDouble() * 1000.0);
+    config.outputFileName = parser.value("output");
+
+    if (config.sessionCount <= 0 || config.reportInterval <= 0)
+    {
+        qDebug() << "Number of sessions and report interval must be positive";
+
+        return 1;
+    }
+
+    Common::HTTPSQuery::setConnectionsPerHost(parser.value("connections").toInt());
+
+    if (parser.isSet("replay") && !Common::HTTPSQuery::startReplay(parser.value("replay"), parser.value("replay-speed").toDouble()))
+    {
+        return 1;
+    }
+
+    //тысячи сеансов пишут о каждом входе и изменении фильтра - отчет теряется в сообщениях
+    if (!parser.isSet("verbose"))
+    {
+        QLoggingCategory::setFilterRules("default.debug=false");
+    }
+
+    LoadGenerator generator(config);
+    QObject::connect(&generator, SIGNAL(finished()), &a, SLOT(quit()));
+
+    generator.start();
+
+    return a.exec();
+}
@@ -1,17 +1,55 @@
-#include "localconfig.h"
+#include <QCoreApplication>
+#include <QFile>
+#include <QDir>
+#include <QDebug>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten/html5.h>
+#endif
 
-using namespace emscripten;
+#include "localconfig.h"
 
-static const QString CONFIG_FILE_NAME = "/offline/TraidingCatBot.ini";
+static const int FLUSH_DELAY = 2000; //ms задержка записи после последнего изменения
+static const int DEFAULT_MEMORY_BUDGET = 384; //Мб, сборка WASM ограничена 1024 Мб
+static const QString CATALOG_FILE_NAME = "catalog.json";
 
 LocalConfig::LocalConfig()
+    : _storage(ConfigStorage::make())
 {
-    _localStorage = val::global("window")["localStorage"];
+    _flushTimer.setSingleShot(true);
+    _flushTimer.setInterval(FLUSH_DELAY);
+    QObject::connect(&_flushTimer, &QTimer::timeout, [this](){ flush(); });
+
+    if (QCoreApplication::instance() != nullptr)
+    {
+        QObject::connect(QCoreApplication::instance(), &QCoreApplication::aboutToQuit, &_flushTimer, [this](){ flush(); });
+    }
+
+#ifdef __EMSCRIPTEN__
+    //при закрытии вкладки браузера деструкторы не вызываются
+    emscripten_set_beforeunload_callback(this,
+        [](int eventType, const void *reserved, void *userData) -> const char*
+        {
+            static_cast<LocalConfig*>(userData)->flush();
+
+            return nullptr;
+        });
+#endif
 
     _user = QByteArray::fromBase64(loadValue("user").toUtf8());
     _password = QByteArray::fromBase64(loadValue("password").toUtf8());
     _autoLogin = loadValue("auto_login") == "true";
     _splitterPos = QByteArray::fromBase64(loadValue("splitter_pos").toUtf8());
+    loadCatalog();
+    _filter = loadValue("filter").toUtf8();
+    _localDetection = loadValue("local_detection") == "true";
+
+    bool ok = false;
+    _memoryBudget = loadValue("memory_budget").toInt(&ok);
+    if (!ok || _memoryBudget <= 0)
+    {
+        _memoryBudget = DEFAULT_MEMORY_BUDGET;
+    }
 }
 
 const QString &LocalConfig::user() const
@@ -54,25 +92,162 @@ QByteArray LocalConfig::splitterPos() const
 
 void LocalConfig::setSplitterPos(const QByteArray& newPos)
 {
+    //вызывается на каждое перемещение разделителя
+    if (_splitterPos == newPos)
+    {
+        return;
+    }
+
     _splitterPos= newPos;
     saveValue("splitter_pos", QString(_splitterPos.toBase64()));
 }
 
+const QByteArray &LocalConfig::catalog() const
+{
+    return _catalog;
+}
+
+void LocalConfig::setCatalog(const QByteArray &catalog)
+{
+    //каталог меняется редко - не перезаписываем хранилище при каждом входе
+    if (_catalog == catalog)
+    {
+        return;
+    }
+
+    _catalog = catalog;
+    _isCatalogChanged = true;
+
+    _flushTimer.start();
+}
+
+const QByteArray &LocalConfig::filter() const
+{
+    return _filter;
+}
+
+void LocalConfig::setFilter(const QByteArray &filter)
+{
+    if (_filter == filter)
+    {
+        return;
+    }
+
+    _filter = filter;
+    saveValue("filter", QString::fromUtf8(_filter));
+}
+
+int LocalConfig::memoryBudget() const
+{
+    return _memoryBudget;
+}
+
+void LocalConfig::setMemoryBudget(int memoryBudget)
+{
+    if (_memoryBudget == memoryBudget)
+    {
+        return;
+    }
+
+    _memoryBudget = memoryBudget;
+    saveValue("memory_budget", QString::number(_memoryBudget));
+}
+
+bool LocalConfig::localDetection() const
+{
+    return _localDetection;
+}
+
+void LocalConfig::setLocalDetection(bool localDetection)
+{
+    _localDetection = localDetection;
+    saveValue("local_detection", _localDetection ? "true" : "false");
+}
+
+LocalConfig::~LocalConfig()
+{
+#ifdef __EMSCRIPTEN__
+    emscripten_set_beforeunload_callback(nullptr, nullptr);
+#endif
+
+    flush();
+}
+
+void LocalConfig::flush()
+{
+    _flushTimer.stop();
+
+    if (_isCatalogChanged)
+    {
+        saveCatalog();
+    }
+
+    if (_dirtyValues.isEmpty())
+    {
+        return;
+    }
+
+    _storage->save(_dirtyValues);
+    _dirtyValues.clear();
+}
+
 void LocalConfig::saveValue(const QString &key, const QString &value)
 {
-    const std::string keyString = key.toStdString();
-    const std::string valueString = value.toStdString();
-    _localStorage.call<void>("setItem", keyString, valueString);
+    _dirtyValues.insert(key, value);
+
+    _flushTimer.start();
 }
 
 QString LocalConfig::loadValue(const QString &key)
 {
-    const std::string keyString = key.toStdString();
-    const emscripten::val value = _localStorage.call<val>("getItem", keyString);
-    if (value.isNull())
+    return _storage->load(key);
+}
+
+void LocalConfig::loadCatalog()
+{
+    QFile catalogFile(ConfigStorage::offlineDir() + "/" + CATALOG_FILE_NAME);
+    if (catalogFile.open(QIODevice::ReadOnly))
+    {
+        _catalog = catalogFile.readAll();
+
+        return;
+    }
+
+    //прежние версии хранили каталог в хранилище настроек - переносим в файл и освобождаем ключ
+    _catalog = loadValue("catalog").toUtf8();
+    if (!_catalog.isEmpty())
     {
-        return "";
+        _isCatalogChanged = true;
+        saveValue("catalog", "");
     }
+}
+
+void LocalConfig::saveCatalog()
+{
+    _isCatalogChanged = false;
+
+    const auto dirName = ConfigStorage::offlineDir();
+    if (!QDir().mkpath(dirName))
+    {
+        qDebug() << "Cannot create directory" << dirName;
+
+        return;
+    }
+
+    QFile catalogFile(dirName + "/" + CATALOG_FILE_NAME);
+    if (!catalogFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot save catalog:" << catalogFile.errorString();
+
+        return;
+    }
+
+    if (catalogFile.write(_catalog) != _catalog.size())
+    {
+        qDebug() << "Cannot save catalog:" << catalogFile.errorString();
+    }
+
+    catalogFile.close();
 
-    return QString::fromStdString(value.as<std::string>());
+    ConfigStorage::syncOfflineDir();
 }
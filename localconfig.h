@@ -1,16 +1,21 @@
 #ifndef LOCALCONFIG_H
 #define LOCALCONFIG_H
 
+//STL
+#include <memory>
+
+//Qt
 #include <QString>
 #include <QByteArray>
+#include <QTimer>
 
-#include <emscripten.h>
-#include <emscripten/val.h>
+#include "configstorage.h"
 
 class LocalConfig
 {
 public:
     LocalConfig();
+    ~LocalConfig();
 
     const QString& user() const;
     void setUser(const QString& user);
@@ -20,18 +25,40 @@ public:
     void setAutoLogin(bool autoLogin);
     QByteArray splitterPos() const;
     void setSplitterPos(const QByteArray& newPos);
+    //JSON списка бирж, монет и интервалов из последнего ответа /klines. Хранится в отдельном файле каталога
+    //постоянных данных (IDBFS в WASM сборке): в localStorage браузера большой каталог не помещается
+    const QByteArray& catalog() const;
+    void setCatalog(const QByteArray& catalog);
+    const QByteArray& filter() const; //JSON последнего фильтра, подтвержденного сервером
+    void setFilter(const QByteArray& filter);
+    int memoryBudget() const; //Мб ограничение памяти под события и графики
+    void setMemoryBudget(int memoryBudget);
+    bool localDetection() const; //локальный поиск событий по свечам полученных событий
+    void setLocalDetection(bool localDetection);
+
+    void flush(); //записывает измененные значения в хранилище
 
 private:
     void saveValue(const QString& key, const QString& value);
     QString loadValue(const QString& key);
 
+    void loadCatalog();
+    void saveCatalog();
+
 private:
     QString _user;
     QString _password;
     bool _autoLogin = false;
     QByteArray _splitterPos;
+    QByteArray _catalog;
+    bool _isCatalogChanged = false; //каталог еще не записан в файл
+    QByteArray _filter;
+    int _memoryBudget = 0;
+    bool _localDetection = false;
 
-    emscripten::val _localStorage;
+    std::unique_ptr<ConfigStorage> _storage;
+    ConfigStorage::Values _dirtyValues; //значения, еще не записанные в хранилище
+    QTimer _flushTimer; //отложенная запись измененных значений
 };
 
 #endif // LOCALCONFIG_H
@@ -1,6 +1,10 @@
 #include "mainwindow.h"
 
 #include <QApplication>
+#include <QCommandLineParser>
+
+#include "httpsquery.h"
+#include "tracer.h"
 
 int main(int argc, char *argv[])
 {
@@ -10,8 +14,39 @@ int main(int argc, char *argv[])
     QApplication::setOrganizationName("Cat software development");
     QApplication::setApplicationVersion(QString("Version:0.1 Build: %1 %2").arg(__DATE__).arg(__TIME__));
 
+    //запись и воспроизведение обмена с сервером
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    parser.addVersionOption();
+    parser.addOption(QCommandLineOption("capture", "Write all server requests and answers to <file>.", "file"));
+    parser.addOption(QCommandLineOption("replay", "Take server answers from <file> recorded with --capture.", "file"));
+    parser.addOption(QCommandLineOption("replay-speed", "Replay speed: 1 - real time, N - N times faster, 0 - as fast as possible.", "speed", "1"));
+#ifdef TRADINGCAT_TRACE
+    parser.addOption(QCommandLineOption("trace", "Write the Chrome trace of the session to <file> on exit.", "file"));
+#endif
+    parser.process(a);
+
+    if (parser.isSet("capture") && !Common::HTTPSQuery::startCapture(parser.value("capture")))
+    {
+        return 1;
+    }
+
+    if (parser.isSet("replay") && !Common::HTTPSQuery::startReplay(parser.value("replay"), parser.value("replay-speed").toDouble()))
+    {
+        return 1;
+    }
+
     MainWindow w;
     w.show();
 
-    return a.exec();
+    const auto result = a.exec();
+
+#ifdef TRADINGCAT_TRACE
+    if (parser.isSet("trace"))
+    {
+        Tracer::writeChromeTrace(parser.value("trace"));
+    }
+#endif
+
+    return result;
 }
@@ -1,3 +1,5 @@
+#include <algorithm>
+
 #include <QTimer>
 #include <QJsonDocument>
 #include <QJsonObject>
@@ -6,18 +8,43 @@
 #include <QBarCategoryAxis>
 #include <QValueAxis>
 #include <QDateTimeAxis>
-#include <QComboBox>
-#include <QDoubleSpinBox>
-#include <QRandomGenerator64>
+#include <QFileDialog>
+#include <QMenu>
+#include <QFileInfo>
+#include <QElapsedTimer>
+#include <QShortcut>
+#include <QLocale>
+#include <QGuiApplication>
 
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 
 #include "Common/common.h"
 
+#include "tracer.h"
+
 using namespace Common;
 
-static const quint64 SEND_INTERVAL = 5000;
+static const qsizetype LONG_HISTORY_SIZE = 1000; //начиная с этого количества свечей история рисуется KLineChartWidget
+static const int CHART_IMAGE_CACHE_SIZE = 64 * 1024; //Kb наибольший размер кеша изображений графиков
+static const qsizetype CHART_IMAGE_BUDGET_SHARE = 4; //кеш изображений занимает не больше 1/4 бюджета памяти
+static const int PRE_RENDER_NEWEST_COUNT = 10; //количество последних событий, графики которых рисуются заранее
+static const int PRE_RENDER_NEIGHBOURS_COUNT = 2; //количество соседей текущего события, графики которых рисуются заранее
+static const int FRAME_INTERVAL = 16; //ms изменения GUI применяются не чаще одного раза за кадр
+static const int PRE_RENDER_INTERVAL = FRAME_INTERVAL; //ms между шагами предварительной отрисовки
+static const qreal HISTORY_BODY_WIDTH = 0.7; //ширина тела и засечек свечей графика истории
+static const qreal HISTORY_CAPS_WIDTH = 0.5;
+static const qreal REVIEW_BODY_WIDTH = 0.5; //ширина тела и засечек свечей графика обзора
+static const qreal REVIEW_CAPS_WIDTH = 0.3;
+static const int MAX_OPEN_KLINE_STORES = 32; //открытых хранилищ истории свечей, у каждого 9 файлов
+static const qsizetype ADD_KLINES_PER_PASS = 20; //количество событий, добавляемых в список за один кадр
+static const qsizetype MAX_PENDING_KLINES = 500; //при превышении следующий запрос /data откладывается до разбора очереди
+static const int INDICATOR_CACHE_SIZE = 200000; //наибольшее количество точек в кеше линий индикаторов
+static const qsizetype INDICATOR_BUDGET_SHARE = 16; //каждый кеш индикаторов занимает не больше 1/16 бюджета памяти
+static const int MAX_EVENT_ITEMS = 100; //максимальное количество событий в списке
+static const int DIAGNOSTICS_INTERVAL = 1000; //ms обновление вкладки Diagnostics
+static const qsizetype LIST_ITEM_SIZE = 256; //оценка памяти элемента списка событий без текста
+static const qsizetype CANDLESTICK_SET_SIZE = 256; //оценка памяти набора свечи QtCharts вместе с приватными данными
 #ifdef QT_NO_DEBUG
 static const QString SERVER_URL = "https://tradingcat.ru";
 #else
@@ -28,16 +55,68 @@ MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
 {
+    _startupTimer.start();
+
+    _stallWatchdog = new StallWatchdog(this);
+    updateStallWatchdog();
+    QObject::connect(qApp, &QGuiApplication::applicationStateChanged, this, [this](){ updateStallWatchdog(); });
+
+    //session
+    _session = new Session(SERVER_URL, this);
+
     //UI
     ui->setupUi(this);
 
-    //http
-    _headers.insert(QByteArray{"Content-Type"}, QByteArray{"application/json"});
+    //filter
+    _filterModel = new FilterModel(this);
+    _filterDelegate = new FilterDelegate(_session->catalog(), this);
+    ui->filterTableView->setModel(_filterModel);
+    ui->filterTableView->setItemDelegate(_filterDelegate);
+    ui->filterTableView->setEditTriggers(QAbstractItemView::NoEditTriggers); //до ответа сервера показывается сохраненный фильтр
+    for (int column = 0; column < FilterModel::Column::COUNT; ++column)
+    {
+        ui->filterTableView->horizontalHeader()->setSectionResizeMode(column, QHeaderView::ResizeToContents);
+    }
+
+    //chart interval
+    ui->chartIntervalComboBox->addItem("Event interval", static_cast<qint64>(KLineType::UNKNOW));
+    for (const auto type: {KLineType::MIN5, KLineType::MIN15, KLineType::MIN30, KLineType::MIN60,
+                           KLineType::HOUR4, KLineType::HOUR8, KLineType::DAY1, KLineType::WEEK1})
+    {
+        ui->chartIntervalComboBox->addItem(KLineTypeToString(type), static_cast<qint64>(type));
+    }
+
+    //indicators
+    for (const auto type: {KLineIndicators::Type::NONE, KLineIndicators::Type::SMA, KLineIndicators::Type::EMA,
+                           KLineIndicators::Type::BOLLINGER, KLineIndicators::Type::VWAP,
+                           KLineIndicators::Type::RSI, KLineIndicators::Type::ATR})
+    {
+        ui->indicatorComboBox->addItem(KLineIndicators::typeToString(type), static_cast<quint8>(type));
+    }
+
+    //data
+    _eventLog = new EventLog(this);
+    _klineStoreCache = new KLineStoreCache(MAX_OPEN_KLINE_STORES);
+
+    _frameTimer = new QTimer(this);
+    _frameTimer->setSingleShot(true);
+    _frameTimer->setInterval(FRAME_INTERVAL);
+    QObject::connect(_frameTimer, SIGNAL(timeout()), SLOT(frameTimer_timeout()));
+
+    //pre-render
+    updateCacheLimits();
+
+    _preRenderTimer = new QTimer(this);
+    _preRenderTimer->setInterval(PRE_RENDER_INTERVAL); //между шагами отрисовки обрабатывается пользовательский ввод
+    QObject::connect(_preRenderTimer, SIGNAL(timeout()), SLOT(preRenderTimer_timeout()));
 
     //connect signal-slots
     QObject::connect(ui->eventsList, SIGNAL(itemClicked(QListWidgetItem *)),
                      SLOT(eventList_itemClicked(QListWidgetItem *)));
 
+    QObject::connect(ui->eventsList, SIGNAL(currentItemChanged(QListWidgetItem *, QListWidgetItem *)),
+                     SLOT(eventList_currentItemChanged(QListWidgetItem *, QListWidgetItem *)));
+
     QObject::connect(ui->eventsList, SIGNAL(itemDoubleClicked(QListWidgetItem *)),
                      SLOT(eventList_itemDoubleClicked(QListWidgetItem *)));
 
@@ -47,11 +126,51 @@ MainWindow::MainWindow(QWidget *parent)
 
     QObject::connect(ui->addPushButton, SIGNAL(clicked()), SLOT(addPushButton_clicked()));
     QObject::connect(ui->removePushButton, SIGNAL(clicked()), SLOT(removePushButton_clicked()));
+    QObject::connect(ui->importPushButton, SIGNAL(clicked()), SLOT(importPushButton_clicked()));
+
+    //формат выгрузки выбирается в меню кнопки Export
+    auto exportMenu = new QMenu(ui->exportPushButton);
+    QObject::connect(exportMenu->addAction("JSON"), SIGNAL(triggered()), SLOT(exportJSONAction_triggered()));
+    QObject::connect(exportMenu->addAction("CSV"), SIGNAL(triggered()), SLOT(exportCSVAction_triggered()));
+    ui->exportPushButton->setMenu(exportMenu);
+
+    ui->localDetectionCheckBox->setChecked(_localCnf.localDetection());
+    QObject::connect(ui->localDetectionCheckBox, SIGNAL(toggled(bool)), SLOT(localDetectionCheckBox_toggled(bool)));
 
     QObject::connect(ui->mainTabWidget, SIGNAL(currentChanged(int)), SLOT(mainTabWidget_currentChanged(int)));
 
-    makeChart();
-    makeReviewChart();
+    QObject::connect(ui->chartIntervalComboBox, SIGNAL(currentIndexChanged(int)), SLOT(chartIntervalComboBox_currentIndexChanged(int)));
+    QObject::connect(ui->indicatorComboBox, SIGNAL(currentIndexChanged(int)), SLOT(indicatorComboBox_currentIndexChanged(int)));
+
+    QObject::connect(_filterModel, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&, const QList<int>&)), SLOT(filterModel_changed()));
+    QObject::connect(_filterModel, SIGNAL(rowsInserted(const QModelIndex&, int, int)), SLOT(filterModel_changed()));
+    QObject::connect(_filterModel, SIGNAL(rowsRemoved(const QModelIndex&, int, int)), SLOT(filterModel_changed()));
+    QObject::connect(_filterModel, SIGNAL(modelReset()), SLOT(filterModel_changed()));
+
+    QObject::connect(_session, SIGNAL(credentialsChanged(const QString&, const QString&)), SLOT(session_credentialsChanged(const QString&, const QString&)));
+    QObject::connect(_session, SIGNAL(loggedIn()), SLOT(session_loggedIn()));
+    QObject::connect(_session, SIGNAL(catalogReceived(const QJsonArray&)), SLOT(session_catalogReceived(const QJsonArray&)));
+    QObject::connect(_session, SIGNAL(serverFilterChanged(const QJsonArray&)), SLOT(session_serverFilterChanged(const QJsonArray&)));
+    QObject::connect(_session, SIGNAL(eventsReceived(const QList<KLineData>&)), SLOT(session_eventsReceived(const QList<KLineData>&)));
+    QObject::connect(_session, SIGNAL(messagesReceived(const QStringList&)), SLOT(session_messagesReceived(const QStringList&)));
+    QObject::connect(_session, SIGNAL(connectionLost()), SLOT(session_connectionLost()));
+
+#ifdef TRADINGCAT_TRACE
+    //выгрузка трассы для Perfetto
+    auto traceShortcut = new QShortcut(QKeySequence("Ctrl+Shift+T"), this);
+    QObject::connect(traceShortcut, &QShortcut::activated, this,
+        []()
+        {
+            QFileDialog::saveFileContent(Tracer::toChromeTrace(), "trace.json");
+        });
+#endif
+
+    //графики QtCharts создаются при первом показе события (showChart()/showReviewChart())
+    _chartPreviewLabel = new QLabel(ui->chartFrame);
+    _chartPreviewLabel->hide();
+
+    _reviewChartPreviewLabel = new QLabel(ui->reviewChartFrame);
+    _reviewChartPreviewLabel->hide();
 
     if (!_localCnf.splitterPos().isEmpty())
     {
@@ -60,846 +179,808 @@ MainWindow::MainWindow(QWidget *parent)
 
     ui->mainTabWidget->setCurrentIndex(0);
 
-    //start
-    QTimer::singleShot(100,
-                       [this]()
-                       {
-                            _reviewChartView->show();
-                            _chartView->show();
-
-                            resizeEvent(nullptr);
-                       });
+    //diagnostics
+    ui->memoryBudgetSpinBox->setValue(_localCnf.memoryBudget());
+    ui->memoryTableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
+    ui->stallTableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
 
-    QTimer::singleShot(100, [this](){ login("Please enter your username and password"); });
-}
+    _diagnosticsTimer = new QTimer(this);
+    _diagnosticsTimer->setInterval(DIAGNOSTICS_INTERVAL);
+    QObject::connect(_diagnosticsTimer, SIGNAL(timeout()), SLOT(diagnosticsTimer_timeout()));
+    QObject::connect(ui->memoryBudgetSpinBox, SIGNAL(valueChanged(int)), SLOT(memoryBudgetSpinBox_valueChanged(int)));
 
-MainWindow::~MainWindow()
-{
-    Q_CHECK_PTR(ui);
+    //данные прошлого сеанса показываем сразу, сервер обновит их после входа
+    loadCachedState();
 
-    for (const auto& request: _sentHTTPRequest)
+    //events
+    _pendingKLines.append(_eventLog->restore(MAX_EVENT_ITEMS));
+    if (!_pendingKLines.isEmpty())
     {
-        delete request.HTTPSQuery;
-    }
+        qDebug() << "Restored events:" << _pendingKLines.size();
 
-    delete ui;
-}
+        scheduleFrame();
+    }
 
-void MainWindow::login(const QString& title)
-{   
-    if (_localCnf.user().isEmpty() || _localCnf.password().isEmpty())
-    {
-        _localCnf.setUser(QString::number(QRandomGenerator64::global()->generate64()));
-        _localCnf.setPassword(QString::number(QRandomGenerator64::global()->generate64()));
+    //start
+    QTimer::singleShot(100, [this](){ resizeEvent(nullptr); });
 
-        sendNewUser(_localCnf.user(), _localCnf.password());
-    }
-    else
-    {
-        sendLogin(_localCnf.user(), _localCnf.password());
-    }
+    QTimer::singleShot(100, [this](){ _session->start(_localCnf.user(), _localCnf.password()); });
 }
 
-void MainWindow::
-    parseLogin(const QByteArray &data)
+MainWindow::~MainWindow()
 {
-    QJsonParseError error;
-    const auto doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError)
-    {
-        qDebug() << "LOGIN: Error parsing json: " << error.errorString();
-        Q_ASSERT(false);
-
-        return;
-    }
-
-    const auto json = doc.object();
-    if (json["Result"] == "OK")
-    {
-        auto item = new QListWidgetItem(QString("Login successfully as: %1").arg(_localCnf.user()));
-        item->setIcon(QIcon(":/image/img/ok.png"));
-        ui->eventsList->addItem(item);
+    Q_CHECK_PTR(ui);
 
-        _sessionID = json["SessionID"].toInt(0);
+    delete _session;
+    delete _eventLog;
+    delete _klineStoreCache;
+    qDeleteAll(_pendingKLines);
+    qDeleteAll(_klines);
 
-        ui->mainTabWidget->setVisible(true);
+    delete _preRenderImages;
+    delete _previewChartView;
+    delete _reviewPreviewChartView;
 
-        _filter.fromJSON(json["Filter"].toArray());
-        if (_filter.isError())
-        {
-            qDebug() << _filter.errorString();
-        }
+    delete ui;
+}
 
-        QTimer::singleShot(1, [this](){ sendGetKLines(); });
-    }
-    else
-    {
-        qDebug() << "LOGIN:" << json["Message"].toString();
-        QTimer::singleShot(1, [this, json](){ login(json["Message"].toString()); });
-    }
+void MainWindow::session_credentialsChanged(const QString &user, const QString &password)
+{
+    _localCnf.setUser(user);
+    _localCnf.setPassword(password);
+    _localCnf.flush();
 }
 
-void MainWindow::getAnswerHttp(const QByteArray &answer, int id)
+void MainWindow::session_loggedIn()
 {
-    const auto sendHTTPRequest_it = _sentHTTPRequest.find(id);
-    if (sendHTTPRequest_it == _sentHTTPRequest.end())
-    {
-        qDebug() << "GET ANSWER UNDEFINE REQUEST WITH ID:" << id;
+    auto item = new QListWidgetItem(QString("Login successfully as: %1").arg(_session->user()));
+    item->setIcon(QIcon(":/image/img/ok.png"));
+    ui->eventsList->addItem(item);
 
-        return;
-    }
+    ui->mainTabWidget->setVisible(true);
+}
 
-    switch (sendHTTPRequest_it.value().type)
-    {
-    case HTTPRequstType::LOGIN:
-        parseLogin(answer);
-        break;
-    case HTTPRequstType::KLINES:
-        parseKLines(answer);
-        break;
-    case HTTPRequstType::DATA:
-        parseData(answer);
-        break;
-    case HTTPRequstType::CONFIG:
-        parseConfig(answer);
-        break;
-    case HTTPRequstType::NEWUSER:
-        parseNewUser(answer);
-        break;
-    default:
-        Q_ASSERT(false);
-        break;
-    }
+void MainWindow::session_catalogReceived(const QJsonArray &klinesJson)
+{
+    _localCnf.setCatalog(QJsonDocument(klinesJson).toJson(QJsonDocument::Compact));
 
-    delete sendHTTPRequest_it.value().HTTPSQuery;
+    makeFilterTab();
 
-    _sentHTTPRequest.erase(sendHTTPRequest_it);
+    qDebug() << "Startup: catalog refreshed from server in" << _startupTimer.elapsed() << "ms";
+}
 
-    _getErrorHTTPCount= 0;
+void MainWindow::session_serverFilterChanged(const QJsonArray &filterJson)
+{
+    _localCnf.setFilter(QJsonDocument(filterJson).toJson(QJsonDocument::Compact));
 }
 
-void MainWindow::errorOccurredHttp(quint32 code, const QString &msg, int id)
+void MainWindow::session_eventsReceived(const QList<KLineData> &klines)
 {
-    const auto sendHTTPRequest_it = _sentHTTPRequest.find(id);
-    if (sendHTTPRequest_it == _sentHTTPRequest.end())
-    {
-        qDebug() << "ERROR UNDEFINE REQUEST WITH ID:" << id;
+    HANDLER_SCOPE("MainWindow::session_eventsReceived");
 
-        return;
-    }
-    if (_getErrorHTTPCount > 10)
+    for (const auto& klineData: klines)
     {
-        qDebug() << "SERVER ERROR. Relogin";
+        _eventLog->append(klineData);
 
-        if (sendHTTPRequest_it.value().type == HTTPRequstType::NEWUSER)
-        {
-            QTimer::singleShot(SEND_INTERVAL, [this](){ sendNewUser(_localCnf.user(), _localCnf.password()); });
-        }
-        else
+        _klineStoreCache->append(klineData.stockExchangeID, klineData.history);
+
+        //последняя свеча истории уже найдена сервером, локально проверяются более старые свечи.
+        //Последняя свеча обзорной истории содержит тот же всплеск на другом интервале
+        if (ui->localDetectionCheckBox->isChecked())
         {
-            QTimer::singleShot(SEND_INTERVAL, [this](){ sendLogin(_localCnf.user(), _localCnf.password()); });
+            _spikeDetector.addKLines(klineData.stockExchangeID, klineData.history, true);
+            _spikeDetector.addKLines(klineData.stockExchangeID, klineData.reviewHistory, true);
         }
 
-        _getErrorHTTPCount = 0;
-
-        delete sendHTTPRequest_it.value().HTTPSQuery;
-
-        _sentHTTPRequest.erase(sendHTTPRequest_it);
+        //истории свечей разделяются с session без копирования
+        _pendingKLines.push_back(new KLineData(klineData));
+    }
 
-        auto item = new QListWidgetItem(QString("Connection is lost. Please wait for relogin...").arg(_localCnf.user()));
-        item->setIcon(QIcon(":/icon/img/error.ico"));
-        ui->eventsList->addItem(item);
+    scheduleFrame();
 
-        return;
+    //GUI не успевает добавлять события - следующий запрос отправим, когда очередь будет разобрана
+    if (_pendingKLines.size() > MAX_PENDING_KLINES)
+    {
+        _session->holdDataPoll();
     }
+}
 
-    switch (sendHTTPRequest_it.value().type)
+void MainWindow::session_messagesReceived(const QStringList &messages)
+{
+    for (const auto& message: messages)
     {
-    case HTTPRequstType::LOGIN:
-        QTimer::singleShot(SEND_INTERVAL, [this](){ sendLogin(_localCnf.user(), _localCnf.password()); });
-        break;
-    case HTTPRequstType::KLINES:
-        QTimer::singleShot(SEND_INTERVAL, [this](){ sendGetKLines(); });
-        break;
-    case HTTPRequstType::DATA:
-        QTimer::singleShot(SEND_INTERVAL, [this](){ sendGetData(); });
-        break;
-    case HTTPRequstType::CONFIG:
-        QTimer::singleShot(SEND_INTERVAL, [this](){ sendConfig(); });
-        break;
-    case HTTPRequstType::NEWUSER:
-        QTimer::singleShot(SEND_INTERVAL, [this](){ sendNewUser(_localCnf.user(), _localCnf.password()); });
-        break;
-    default:
-        Q_ASSERT(false);
-        break;
+        auto item = new QListWidgetItem(message);
+        item->setIcon(QIcon(":/image/img/info.png"));
+        ui->eventsList->addItem(item);
     }
+}
 
-    delete sendHTTPRequest_it.value().HTTPSQuery;
-
-    _sentHTTPRequest.erase(sendHTTPRequest_it);
-
-    ++_getErrorHTTPCount;
-
+void MainWindow::session_connectionLost()
+{
+    auto item = new QListWidgetItem(QString("Connection is lost. Please wait for relogin..."));
+    item->setIcon(QIcon(":/icon/img/error.ico"));
+    ui->eventsList->addItem(item);
 }
 
 void MainWindow::eventList_itemClicked(QListWidgetItem *item)
 {
+    HANDLER_SCOPE("MainWindow::eventList_itemClicked");
+
     if (item->data(Qt::UserRole).isNull())
     {
         return;
     }
 
-    showChart(*_klines.value(item->data(Qt::UserRole).toULongLong()));
-    showReviewChart(*_klines.value(item->data(Qt::UserRole).toULongLong()));
-}
-
-void MainWindow::eventList_itemDoubleClicked(QListWidgetItem *item)
-{
-    if (item->data(Qt::UserRole).isNull())
+    const auto id = item->data(Qt::UserRole).toULongLong();
+    if (!_klines.contains(id))
     {
         return;
     }
 
-    if (item->data(Qt::UserRole + 1).toUInt() == static_cast<quint8>(EventType::INCREASE))
+    //щелчок по текущему событию приходит после currentItemChanged - графики уже построены или запрошены
+    if (id == _pendingChartID)
     {
-        item->setIcon(QIcon(":/image/img/increase_star.png"));
+        return;
     }
-    else if (item->data(Qt::UserRole + 1).toUInt() == static_cast<quint8>(EventType::DECREASE))
+
+    //возврат к показанному событию до следующего кадра - запрошенные графики другого события больше не нужны
+    if (id == _currentChartID)
     {
-        item->setIcon(QIcon(":/image/img/decrease_star.png"));
-    }
-}
+        _pendingChartID = 0;
 
-void MainWindow::detectorSplitter_splitterMoved(int pos, int index)
-{
-    resizeEvent(nullptr);
-}
+        return;
+    }
 
-void MainWindow::addPushButton_clicked()
-{
-    addFilterRow(_existKLines.firstKey(), "ALL", "1m", 5.0, 1000.0);
+    //графики перестраиваются не чаще одного раза за кадр
+    _pendingChartID = id;
+    scheduleFrame();
 }
 
-void MainWindow::removePushButton_clicked()
+void MainWindow::eventList_currentItemChanged(QListWidgetItem *current, QListWidgetItem *previous)
 {
-    auto& filterTable = ui->filterTableWidget;
-    filterTable->removeRow(filterTable->currentRow());
-
-    showRemovePushButton();
-}
+    Q_UNUSED(previous);
 
-void MainWindow::stockExchangeComboBox_currentIndexChanged(int index)
-{
-    const auto currentRow = ui->filterTableWidget->currentRow();
-    if (currentRow == 0)
+    if (current == nullptr)
     {
         return;
     }
 
-    auto stockExchangeComboBox = static_cast<QComboBox*>(ui->filterTableWidget->cellWidget(currentRow, 0));
-
-    ui->filterTableWidget->removeCellWidget(currentRow, 1);
-    ui->filterTableWidget->setCellWidget(currentRow, 1, makeMoneyComboBox(stockExchangeComboBox->currentText(), "ALL"));
+    eventList_itemClicked(current);
 }
 
-void MainWindow::mainTabWidget_currentChanged(int index)
+void MainWindow::showEventCharts(quint64 id)
 {
-    if (index != 0 || _sessionID == 0)
+    const auto klines_it = _klines.find(id);
+    if (klines_it == _klines.end())
     {
         return;
     }
 
-    _filter.clear();
-    for (int row = 0; row < ui->filterTableWidget->rowCount(); ++row)
-    {
-        Filter::FilterData tmp;
+    _currentChartID = id;
+    ++_eventViews[id];
 
-        tmp.stockExchangeID.name = static_cast<QComboBox*>(ui->filterTableWidget->cellWidget(row, 0))->currentText();
+    const auto item = findEventItem(id);
+    if (item != nullptr)
+    {
+        addPreRenderNeighbours(ui->eventsList->row(item));
+    }
 
-        tmp.klineID.symbol = static_cast<QComboBox*>(ui->filterTableWidget->cellWidget(row, 1))->currentText();
-        tmp.klineID.type = stringToKLineType(static_cast<QComboBox*>(ui->filterTableWidget->cellWidget(row, 2))->currentText());
+    //если графики уже нарисованы заранее - сразу показываем изображение, а интерактивный график строим следом
+    const auto chartImages = _chartImageCache.object(id);
+    if (chartImages != nullptr && chartImages->interval == _chartInterval
+        && chartImages->history.size() == ui->chartFrame->size()
+        && chartImages->reviewHistory.size() == ui->reviewChartFrame->size())
+    {
+        showChartPreview(*chartImages);
 
-        tmp.delta = static_cast<QDoubleSpinBox*>(ui->filterTableWidget->cellWidget(row, 3))->value();
-        tmp.volume = static_cast<QDoubleSpinBox*>(ui->filterTableWidget->cellWidget(row, 4))->value();
+        QTimer::singleShot(0, this,
+            [this, id]()
+            {
+                //пользователь уже перешел к другому событию
+                if (_currentChartID != id || _pendingChartID != 0)
+                {
+                    return;
+                }
+
+                const auto klines_it = _klines.find(id);
+                if (klines_it != _klines.end())
+                {
+                    showChart(id, *klines_it.value());
+                    showReviewChart(id, *klines_it.value());
+                }
+
+                hideChartPreview();
+            });
 
-        _filter.addFilter(tmp);
+        return;
     }
 
-    sendConfig();
+    hideChartPreview();
+
+    showChart(id, *klines_it.value());
+    showReviewChart(id, *klines_it.value());
 }
 
-void MainWindow::makeChart()
+QListWidgetItem *MainWindow::findEventItem(quint64 id) const
 {
-    //Chart
-    _series = new QCandlestickSeries;
-    _series->setIncreasingColor(QColor(Qt::green));
-    _series->setDecreasingColor(QColor(Qt::red));
-    _series->setBodyOutlineVisible(true);
-    _series->setBodyWidth(0.7);
-    _series->setCapsVisible(true);
-    _series->setCapsWidth(0.5);
-    _series->setMinimumColumnWidth(-1.0);
-    _series->setMaximumColumnWidth(50.0);
-    auto pen = _series->pen();
-    pen.setColor(Qt::white);
-    _series->setPen(pen);
-
-    _seriesVolume = new QCandlestickSeries;
-    _seriesVolume->setIncreasingColor(QColor(61, 56, 70));
-    _seriesVolume->setDecreasingColor(QColor(61, 56, 70));
-    _seriesVolume->setBodyOutlineVisible(false);
-    _seriesVolume->setCapsVisible(true);
-    _seriesVolume->setMinimumColumnWidth(-1.0);
-    _seriesVolume->setMaximumColumnWidth(50.0);
-    _seriesVolume->setCapsWidth(0.5);
-
-    auto chart = new QChart;
-    chart->addSeries(_seriesVolume);
-    chart->addSeries(_series);
-    chart->setTitle("No data");
- //   chart->setAnimationOptions(QChart::SeriesAnimations);
-    chart->setBackgroundBrush(QBrush(QColor(36, 31, 49)));
-    auto titleFont = chart->titleFont();
-    titleFont.setPointSize(20);
-    chart->setTitleFont(titleFont);
-    chart->legend()->setVisible(false);
-    chart->setTitle("No data");
-    chart->setMargins({0,0,0,0});
-
-    auto axisX = new QDateTimeAxis;
-    axisX->setTickCount(3);
-    axisX->setFormat("hh:mm");
-    axisX->setGridLineVisible(false);
-    axisX->setLabelsColor(Qt::white);
-
-    chart->addAxis(axisX, Qt::AlignBottom);
-
-    _series->attachAxis(axisX);
-    _seriesVolume->attachAxis(axisX);
-
-    auto axisY = new QValueAxis();
-    axisY->setGridLineVisible(true);
-    axisY->setGridLineColor(QColor(94, 92, 100));
-    auto axisYGridLinePen = axisY->gridLinePen();
-    axisYGridLinePen.setStyle(Qt::DotLine);
-    axisY->setGridLinePen(axisYGridLinePen);
-    axisY->setLabelsColor(Qt::white);
-
-    chart->addAxis(axisY, Qt::AlignRight);
-
-    _series->attachAxis(axisY);
-
-    auto axisY2 = new QValueAxis();
-    axisY2->setGridLineVisible(false);
-    axisY2->setLabelsVisible(false);
-
-    chart->addAxis(axisY2, Qt::AlignLeft);
-
-    _seriesVolume->attachAxis(axisY2);
-
-    _chartView = new QChartView(chart, ui->chartFrame);
-    _chartView->resize(ui->chartFrame->size());
-    _chartView->show();
+    //новые события в конце списка
+    for (int row = ui->eventsList->count() - 1; row >= 0; --row)
+    {
+        const auto item = ui->eventsList->item(row);
+        const auto itemID = item->data(Qt::UserRole);
+        if (!itemID.isNull() && itemID.toULongLong() == id)
+        {
+            return item;
+        }
+    }
+
+    return nullptr;
 }
 
-void MainWindow::makeReviewChart()
+bool MainWindow::isChartVisible() const
 {
-    //ReviewChart
-    _reviewSeries = new QCandlestickSeries;
-    _reviewSeries->setIncreasingColor(QColor(Qt::green));
-    _reviewSeries->setDecreasingColor(QColor(Qt::red));
-    _reviewSeries->setBodyOutlineVisible(true);
-    _reviewSeries->setBodyWidth(0.5);
-    _reviewSeries->setMinimumColumnWidth(-1.0);
-    _reviewSeries->setMaximumColumnWidth(50.0);
-    _reviewSeries->setCapsVisible(true);
-    _reviewSeries->setCapsWidth(0.3);
-    auto pen = _series->pen();
-    pen.setWidth(1);
-    pen.setColor(Qt::white);
-    _reviewSeries->setPen(pen);
-
-    _reviewSeriesVolume = new QCandlestickSeries;
-    _reviewSeriesVolume->setIncreasingColor(QColor(61, 56, 70));
-    _reviewSeriesVolume->setDecreasingColor(QColor(61, 56, 70));
-    _reviewSeriesVolume->setBodyOutlineVisible(false);
-    _reviewSeriesVolume->setCapsVisible(true);
-    _reviewSeriesVolume->setMinimumColumnWidth(-1.0);
-    _reviewSeriesVolume->setMaximumColumnWidth(50.0);
-    _reviewSeriesVolume->setCapsWidth(0.3);
-
-    auto chart = new QChart;
-    chart->addSeries(_reviewSeriesVolume);
-    chart->addSeries(_reviewSeries);
- //   chart->setAnimationOptions(QChart::SeriesAnimations);
-    chart->setBackgroundBrush(QBrush(QColor(36, 31, 49)));
-    auto titleFont = chart->titleFont();
-    titleFont.setPointSize(20);
-    chart->setTitleFont(titleFont);
-    chart->legend()->setVisible(false);
-    chart->setTitle("No data");
-    chart->setMargins({0,0,0,0});
-
-    auto axisX = new QDateTimeAxis;
-    axisX->setTickCount(3);
-    axisX->setFormat("hh:mm");
-    axisX->setGridLineVisible(false);
-    axisX->setLabelsColor(Qt::white);
-
-    chart->addAxis(axisX, Qt::AlignBottom);
-
-    _reviewSeries->attachAxis(axisX);
-    _reviewSeriesVolume->attachAxis(axisX);
-
-    auto axisY = new QValueAxis();
-    axisY->setGridLineVisible(true);
-    axisY->setGridLineColor(QColor(94, 92, 100));
-    auto axisYGridLinePen = axisY->gridLinePen();
-    axisYGridLinePen.setStyle(Qt::DotLine);
-    axisY->setGridLinePen(axisYGridLinePen);
-    axisY->setLabelsColor(Qt::white);
-
-    chart->addAxis(axisY, Qt::AlignRight);
-
-    _reviewSeries->attachAxis(axisY);
-
-    auto axisY2 = new QValueAxis();
-    axisY2->setGridLineVisible(false);
-    axisY2->setLabelsVisible(false);
-
-    chart->addAxis(axisY2, Qt::AlignLeft);
-
-    _reviewSeriesVolume->attachAxis(axisY2);
-
-    _reviewChartView = new QChartView(chart, ui->reviewChartFrame);
-    _reviewChartView->resize(ui->reviewChartFrame->size());
-    _reviewChartView->show();
+    return isVisible() && !isMinimized() && ui->mainTabWidget->currentIndex() == 0;
 }
 
-void MainWindow::makeFilterTab()
+void MainWindow::scheduleFrame()
 {
-    ui->filterTableWidget->clear();
-    ui->filterTableWidget->setRowCount(0);
-
-    ui->filterTableWidget->setColumnCount(5);
-    QStringList headersLabel;
-    headersLabel << "Stock exchange" << "Money" << "Interval" << "Delta" << "Volume";
-    ui->filterTableWidget->setHorizontalHeaderLabels(headersLabel);
-    ui->filterTableWidget->horizontalHeader()->setSectionResizeMode(0, QHeaderView::ResizeToContents);
-    ui->filterTableWidget->horizontalHeader()->setSectionResizeMode(1, QHeaderView::ResizeToContents);
-    ui->filterTableWidget->horizontalHeader()->setSectionResizeMode(2, QHeaderView::ResizeToContents);
-    ui->filterTableWidget->horizontalHeader()->setSectionResizeMode(3, QHeaderView::ResizeToContents);
-    ui->filterTableWidget->horizontalHeader()->setSectionResizeMode(4, QHeaderView::ResizeToContents);
-
-    const auto filterList = _filter.toList();
-    bool findUnsupportValue = false;
-    for (int row = 0; row < filterList.size(); ++row)
+    if (!_frameTimer->isActive())
     {
-        const auto currentStockExcangeName = filterList.at(row).stockExchangeID.name;
-        const auto currentMoneyName = filterList.at(row).klineID.symbol;
-        const auto currentIntervalName = KLineTypeToString(filterList.at(row).klineID.type);
-        const double currentDelta = filterList.at(row).delta;
-        const double currentVolume = filterList.at(row).volume;
-
-        addFilterRow(currentStockExcangeName, currentMoneyName, currentIntervalName, currentDelta, currentVolume);
+        _frameTimer->start();
     }
-
-    ui->addPushButton->setEnabled(true);
 }
 
-QComboBox *MainWindow::makeStockExchangeComboBox(const QString &stockExchange) const
+void MainWindow::frameTimer_timeout()
 {
-    auto stockExchangeComboBox = new QComboBox();
-    stockExchangeComboBox->setEditable(false);
+    HANDLER_SCOPE("MainWindow::frameTimer_timeout");
 
-    for (auto existKLines_it = _existKLines.begin(); existKLines_it != _existKLines.end(); ++existKLines_it)
+    QElapsedTimer timer;
+    timer.start();
+
+    //0. локальный поиск событий по свечам, поступившим после прошлого кадра
+    if (ui->localDetectionCheckBox->isChecked() && _spikeDetector.hasUpdates())
     {
-        if (existKLines_it.key() == "MEXC")
-        {
-            stockExchangeComboBox->addItem(QIcon(":/icon/img/MEXC.ico"), existKLines_it.key());
-        }
-        else if (existKLines_it.key() == "KUCOIN")
-        {
-            stockExchangeComboBox->addItem(QIcon(":/icon/img/kucoin.png"), existKLines_it.key());
-        }
-        else if (existKLines_it.key() == "GATE")
-        {
-            stockExchangeComboBox->addItem(QIcon(":/icon/img/gate.png"), existKLines_it.key());
-        }
-        else if (existKLines_it.key() == "BYBIT")
-        {
-            stockExchangeComboBox->addItem(QIcon(":/icon/img/bybit.png"), existKLines_it.key());
-        }
-        else if (existKLines_it.key() == "BINANCE")
-        {
-            stockExchangeComboBox->addItem(QIcon(":/icon/img/binance.png"), existKLines_it.key());
-        }
-        else
+        for (auto& klineData: _spikeDetector.detect())
         {
-            stockExchangeComboBox->addItem(existKLines_it.key());
+            klineData.isLocal = true;
+
+            _pendingKLines.push_back(new KLineData(std::move(klineData)));
         }
     }
 
-    auto currentStockExchange_it = _existKLines.find(stockExchange);
-    if (currentStockExchange_it == _existKLines.end())
+    //1. добавление событий. За один кадр добавляется ограниченное количество, чтобы не блокировать GUI
+    qsizetype count = 0;
+    while (!_pendingKLines.isEmpty() && count < ADD_KLINES_PER_PASS)
     {
-        qDebug() << "Unsupport stock exchange:" << stockExchange << ". Set MEXC";
-        stockExchangeComboBox->setCurrentText("MEXC");
-
-        return stockExchangeComboBox;
+        addKLine(_pendingKLines.takeFirst());
+        ++count;
     }
-    else
+
+    if (count != 0)
     {
-        stockExchangeComboBox->setCurrentText(stockExchange);
+        enforceMemoryBudget();
     }
 
-    QObject::connect(stockExchangeComboBox, SIGNAL(currentIndexChanged(int)), SLOT(stockExchangeComboBox_currentIndexChanged(int)));
-
-    return stockExchangeComboBox;
-}
-
-QComboBox *MainWindow::makeMoneyComboBox(const QString &stockExchange, const QString& money) const
-{
-    Q_ASSERT(!stockExchange.isEmpty());
-    Q_ASSERT(!money.isEmpty());
-
-    auto moneyComboBox = new QComboBox();
-    moneyComboBox->setEditable(false);
-
-    auto currentStockExchange_it = _existKLines.find(stockExchange);
-    if (currentStockExchange_it == _existKLines.end())
+    if (count != 0 && _pendingKLines.isEmpty())
     {
-        return moneyComboBox;
+        //2. выделение нового события. Графики запрашиваются через currentItemChanged и строятся ниже в этом же кадре
+        const auto item = ui->eventsList->item(ui->eventsList->count() - 1);
+        if (item != nullptr && !item->data(Qt::UserRole).isNull())
+        {
+            ui->eventsList->setCurrentItem(item);
+        }
+
+        _session->releaseDataPoll();
     }
 
-    const auto& moneyList = currentStockExchange_it.value();
-    for (auto moneyList_it = moneyList.begin(); moneyList_it != moneyList.end(); ++moneyList_it)
+    //3. графики. Для свернутого окна не строятся - будут построены при показе
+    if (_pendingChartID != 0 && isChartVisible())
     {
-        moneyComboBox->addItem(moneyList_it.key());
+        const auto id = _pendingChartID;
+        _pendingChartID = 0;
+
+        showEventCharts(id);
     }
 
-    auto currentMoneyList_it = moneyList.find(money);
-    if (currentMoneyList_it == moneyList.end())
+    if (timer.elapsed() > FRAME_INTERVAL)
     {
-        qDebug() << "Unsupport money:" << money << ". Set ALL";
-        moneyComboBox->setCurrentText("ALL");
+        qDebug() << "FRAME: adding" << count << "events and updating charts took" << timer.elapsed() << "ms";
     }
-    else
+
+    if (!_pendingKLines.isEmpty())
     {
-        moneyComboBox->setCurrentText(money);
+        scheduleFrame();
     }
-
-    return moneyComboBox;
 }
 
-QComboBox *MainWindow::makeIntervalComboBox(const QString &stockExchange, const QString &money, const QString &interval) const
+void MainWindow::preRenderTimer_timeout()
 {
-    auto intervalComboBox = new QComboBox();
-    intervalComboBox->setEditable(false);
+    HANDLER_SCOPE("MainWindow::preRenderTimer_timeout");
 
-    auto currentStockExchange_it = _existKLines.find(stockExchange);
-    if (currentStockExchange_it == _existKLines.end())
+    //кадр с новыми событиями важнее изображений предпросмотра
+    if (_frameTimer->isActive())
     {
-        return intervalComboBox;
+        return;
     }
 
-    const auto& moneyList = currentStockExchange_it.value();
-    auto currentMoneyList_it = moneyList.find(money);
-    if (currentMoneyList_it == moneyList.end())
+    if (_preRenderImages == nullptr)
     {
-        return intervalComboBox;
-    }
+        _preRenderID = takePreRender();
+        if (_preRenderID == 0)
+        {
+            _preRenderTimer->stop();
 
-    const auto& intervalList = currentMoneyList_it.value();
-    for (auto intervalList_it = intervalList.begin(); intervalList_it != intervalList.end(); ++intervalList_it)
-    {
-        intervalComboBox->addItem(*intervalList_it);
+            return;
+        }
+
+        _preRenderImages = new ChartImages;
+        _preRenderImages->interval = _chartInterval;
+        _preRenderStep = PreRenderStep::HISTORY;
     }
 
-    auto currentIntervalList_it = intervalList.find(interval);
-    if (currentIntervalList_it == intervalList.end())
+    const auto klines_it = _klines.find(_preRenderID);
+    if (klines_it == _klines.end())
     {
-        qDebug() << "Unsupport interval:" << interval << ". Set 1min";
+        cancelPreRender();
 
-        intervalComboBox->setCurrentText(KLineTypeToString(KLineType::MIN1));
-        return intervalComboBox;
+        return;
     }
 
-    intervalComboBox->setCurrentText(interval);
-
-    return intervalComboBox;
-}
-
+    const auto& klineData = *klines_it.value();
 
-void MainWindow::sendLogin(const QString &user, const QString &password)
-{
-    const QString url = QString("%1/login/%2/%3")
-                            .arg(SERVER_URL)
-                            .arg(user.toUtf8().toBase64(QByteArray::Base64Encoding))
-                            .arg(password.toUtf8().toBase64(QByteArray::Base64Encoding));
+    //за один раз выполняется один шаг, чтобы не задерживать обработку пользовательского ввода.
+    //График QtCharts заполняется на одном шаге, а снимается в изображение на следующем - после отложенной раскладки
+    switch (_preRenderStep)
+    {
+    case PreRenderStep::HISTORY:
+        _preRenderImages->history = preRenderHistory(_preRenderID, klineData);
+        _preRenderStep = _preRenderImages->history.isNull() ? PreRenderStep::HISTORY_IMAGE : PreRenderStep::REVIEW;
+        break;
 
-    sendHTTPRequest(url, HTTPRequstType::LOGIN, QByteArray());
-}
+    case PreRenderStep::HISTORY_IMAGE:
+        _preRenderImages->history = _previewChartView->toImage();
+        _preRenderStep = PreRenderStep::REVIEW;
+        break;
 
-void MainWindow::sendGetKLines()
-{
-    const QString url = QString("%1/klines/%2").arg(SERVER_URL).arg(_sessionID);
+    case PreRenderStep::REVIEW:
+        _preRenderImages->reviewHistory = preRenderReviewHistory(_preRenderID, klineData);
+        _preRenderStep = _preRenderImages->reviewHistory.isNull() ? PreRenderStep::REVIEW_IMAGE : PreRenderStep::DONE;
+        break;
 
-    sendHTTPRequest(url, HTTPRequstType::KLINES, QByteArray());
-}
+    case PreRenderStep::REVIEW_IMAGE:
+        _preRenderImages->reviewHistory = _reviewPreviewChartView->toImage();
+        _preRenderStep = PreRenderStep::DONE;
+        break;
 
-void MainWindow::parseKLines(const QByteArray &data)
-{  
-    _existKLines.clear();
+    case PreRenderStep::DONE:
+        break;
+    }
 
-    QJsonParseError error;
-    const auto doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError)
+    if (_preRenderStep == PreRenderStep::DONE)
     {
-        qDebug() << "KLINE: Error parsing json: " << error.errorString();
-        Q_ASSERT(false);
+        const auto cost = static_cast<int>((_preRenderImages->history.sizeInBytes() + _preRenderImages->reviewHistory.sizeInBytes()) / 1024);
+        _chartImageCache.insert(_preRenderID, _preRenderImages, cost);
 
-        return;
+        _preRenderImages = nullptr;
+        _preRenderID = 0;
     }
+}
 
-    const auto json = doc.object();
-    if (json["Result"].toString() != "OK")
+void MainWindow::eventList_itemDoubleClicked(QListWidgetItem *item)
+{
+    if (item->data(Qt::UserRole).isNull())
     {
-        qDebug() << "KLINE:" << json["Message"].toString();
-
         return;
     }
 
-    const auto KLineArrayJson = json["KLines"].toArray();
-    for (int i = 0; i < KLineArrayJson.count(); ++i)
+    if (item->data(Qt::UserRole + 1).toUInt() == static_cast<quint8>(EventType::INCREASE))
     {
-        const auto jsonKlines = KLineArrayJson[i].toObject();
-
-        auto& currentMoney = _existKLines[jsonKlines["StockExchange"].toString()][jsonKlines["Money"].toString()];
-        currentMoney.insert(jsonKlines["Interval"].toString());
+        item->setIcon(QIcon(":/image/img/increase_star.png"));
+    }
+    else if (item->data(Qt::UserRole + 1).toUInt() == static_cast<quint8>(EventType::DECREASE))
+    {
+        item->setIcon(QIcon(":/image/img/decrease_star.png"));
     }
-
-    makeFilterTab();
-
-    QTimer::singleShot(SEND_INTERVAL, [this](){ sendGetData(); });
 }
 
-void MainWindow::sendGetData()
+void MainWindow::chartIntervalComboBox_currentIndexChanged(int index)
 {
-    const QString url = QString("%1/data/%2").arg(SERVER_URL).arg(_sessionID);
+    HANDLER_SCOPE("MainWindow::chartIntervalComboBox_currentIndexChanged");
 
-    sendHTTPRequest(url, HTTPRequstType::DATA, QByteArray());
-}
+    _chartInterval = static_cast<KLineType>(ui->chartIntervalComboBox->itemData(index).toLongLong());
+    _chartImageCache.clear();
+    cancelPreRender();
+    _indicatorCache.clear(); //линии рассчитаны по свечам старого интервала
 
-void MainWindow::parseData(const QByteArray &data)
-{
-    QJsonParseError error;
-    const auto doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError)
+    const auto item = ui->eventsList->currentItem();
+    if (item == nullptr || item->data(Qt::UserRole).isNull())
     {
-        qDebug() << "DATA: Error parsing json: " << error.errorString();
-        Q_ASSERT(false);
-
         return;
     }
 
-    const auto json = doc.object();
-    if (json["Result"].toString() == "OK")
-    {
-        addKLines(json["DetectKLines"].toArray());
-        if (json.contains("UserMessages"))
-        {
-            parseMessage(json["UserMessages"].toArray());
-        }
+    //графики строятся в кадре, как при выборе события: быстрая смена интервала перестраивает их один раз
+    _pendingChartID = item->data(Qt::UserRole).toULongLong();
+    scheduleFrame();
+}
 
-        QTimer::singleShot(SEND_INTERVAL, [this, json](){ sendGetData(); });
-    }
-    else if (json["Result"].toString() == "LOGOUT" )
-    {
-        qDebug() << "DATA LOGOUT:" << json["Message"].toString();
+void MainWindow::indicatorComboBox_currentIndexChanged(int index)
+{
+    HANDLER_SCOPE("MainWindow::indicatorComboBox_currentIndexChanged");
 
-        QTimer::singleShot(SEND_INTERVAL,
-                           [this, json]()
-                           {
-                               sendLogin(_localCnf.user(), _localCnf.password());
-                           });
-    }
-    else
+    _indicatorType = static_cast<KLineIndicators::Type>(ui->indicatorComboBox->itemData(index).toUInt());
+    _chartImageCache.clear(); //изображения нарисованы со старым индикатором
+    cancelPreRender();
+    _indicatorCache.clear();
+    _reviewIndicatorCache.clear();
+
+    const auto item = ui->eventsList->currentItem();
+    if (item == nullptr || item->data(Qt::UserRole).isNull())
     {
-        qDebug() << "DATA:" << json["Message"].toString();
+        return;
     }
+
+    //графики строятся в кадре, как при выборе события
+    _pendingChartID = item->data(Qt::UserRole).toULongLong();
+    scheduleFrame();
 }
 
-void MainWindow::parseMessage(const QJsonArray &messages)
+void MainWindow::detectorSplitter_splitterMoved(int pos, int index)
 {
-    const auto messageCount = messages.count();
-    for (auto i = 0; i < messageCount; ++i)
-    {
-        const auto message = messages.at(i).toObject();
-        if (message["Level"].toString() == "INFO")
-        {
-            auto item = new QListWidgetItem(message["Message"].toString());
-            item->setIcon(QIcon(":/image/img/info.png"));
-            ui->eventsList->addItem(item);
-        }
-    }
+    resizeEvent(nullptr);
 }
 
-void MainWindow::sendConfig()
+void MainWindow::addPushButton_clicked()
 {
-    const QString url = QString("%1/config/%2").arg(SERVER_URL).arg(_sessionID);
+    Filter::FilterData tmp;
+    tmp.stockExchangeID.name = _session->catalog().firstKey();
+    tmp.klineID.symbol = "ALL";
+    tmp.klineID.type = KLineType::MIN1;
+    tmp.delta = 5.0;
+    tmp.volume = 1000.0;
 
-    QJsonObject json;
-    json.insert("Filter", _filter.toJSON());
+    _filterModel->addFilter(tmp);
 
-    sendHTTPRequest(url, HTTPRequstType::CONFIG, QJsonDocument(json).toJson(QJsonDocument::Compact));
+    showRemovePushButton();
 }
 
-void MainWindow::parseConfig(const QByteArray &data)
+void MainWindow::removePushButton_clicked()
 {
-    QJsonParseError error;
-    const auto doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError)
-    {
-        qDebug() << "CONFIG: Error parsing json: " << error.errorString();
-        Q_ASSERT(false);
+    _filterModel->removeFilter(ui->filterTableView->currentIndex().row());
 
-        return;
-    }
+    showRemovePushButton();
+}
 
-    const auto json = doc.object();
-    if (json["Result"].toString() != "OK")
-    {
-        qDebug() << "CONFIG:" << json["Message"].toString();
+void MainWindow::importPushButton_clicked()
+{
+    QFileDialog::getOpenFileContent("Filter (*.json *.csv)",
+        [this](const QString& fileName, const QByteArray& fileContent)
+        {
+            if (fileName.isEmpty())
+            {
+                return;
+            }
 
-        return;
-    }
-    else
-    {
-        qDebug() << "CONFIG: configuration applied successfully";
-    }
+            Filter filter;
+            if (QFileInfo(fileName).suffix().toLower() == "csv")
+            {
+                filter.fromCSV(QString::fromUtf8(fileContent));
+            }
+            else
+            {
+                QJsonParseError error;
+                const auto doc = QJsonDocument::fromJson(fileContent, &error);
+                if (error.error != QJsonParseError::NoError)
+                {
+                    qDebug() << "IMPORT: Error parsing json: " << error.errorString();
+
+                    return;
+                }
+
+                filter.fromJSON(doc.isArray() ? doc.array() : doc.object()["Filter"].toArray());
+            }
+
+            const auto removeCount = filter.normalize(_session->catalog());
+            if (filter.isError())
+            {
+                qDebug() << "IMPORT:" << filter.errorString();
+            }
+
+            auto item = new QListWidgetItem(QString("Filter imported from %1: %2 rules, %3 removed")
+                                                .arg(fileName)
+                                                .arg(filter.toList().size())
+                                                .arg(removeCount));
+            item->setIcon(QIcon(":/image/img/info.png"));
+            ui->eventsList->addItem(item);
+
+            _filterModel->setFilterList(filter.toList());
+
+            showRemovePushButton();
+        });
 }
 
-void MainWindow::sendNewUser(const QString &user, const QString &password)
+void MainWindow::exportJSONAction_triggered()
 {
-    const QString url = QString("%1/newuser/%2/%3")
-                            .arg(SERVER_URL)
-                            .arg(user.toUtf8().toBase64(QByteArray::Base64Encoding))
-                            .arg(password.toUtf8().toBase64(QByteArray::Base64Encoding));
+    Filter filter;
+    filter.fromList(_filterModel->filterList());
+
+    QJsonObject json;
+    json.insert("Filter", filter.toJSON());
 
-    sendHTTPRequest(url, HTTPRequstType::NEWUSER, QByteArray());
+    QFileDialog::saveFileContent(QJsonDocument(json).toJson(QJsonDocument::Indented), "filter.json");
 }
 
-void MainWindow::parseNewUser(const QByteArray &data)
+void MainWindow::exportCSVAction_triggered()
 {
-    QJsonParseError error;
-    const auto doc = QJsonDocument::fromJson(data, &error);
-    if (error.error != QJsonParseError::NoError)
+    Filter filter;
+    filter.fromList(_filterModel->filterList());
+
+    QFileDialog::saveFileContent(filter.toCSV().toUtf8(), "filter.csv");
+}
+
+void MainWindow::localDetectionCheckBox_toggled(bool checked)
+{
+    HANDLER_SCOPE("MainWindow::localDetectionCheckBox_toggled");
+
+    _localCnf.setLocalDetection(checked);
+
+    if (!checked)
     {
-        qDebug() << "NEW USER: Error parsing json: " << error.errorString();
-        Q_ASSERT(false);
+        _spikeDetector.clear();
 
         return;
     }
 
-    const auto json = doc.object();
-    if (json["Result"].toString() != "OK")
+    //свечи уже полученных событий - чтобы подбирать пороги сразу после включения
+    for (const auto klineData: std::as_const(_klines))
+    {
+        if (!klineData->isLocal)
+        {
+            _spikeDetector.addKLines(klineData->stockExchangeID, klineData->history, true);
+            _spikeDetector.addKLines(klineData->stockExchangeID, klineData->reviewHistory, true);
+        }
+    }
+
+    scheduleFrame();
+}
+
+void MainWindow::filterModel_changed()
+{
+    HANDLER_SCOPE("MainWindow::filterModel_changed");
+
+    _filterMatcher.compile(_filterModel->filterList());
+    _spikeDetector.setFilter(_filterModel->filterList());
+
+    applyLocalFilter();
+
+    //новые пороги проверяются локально, не дожидаясь применения фильтра сервером
+    if (ui->localDetectionCheckBox->isChecked())
     {
-        qDebug() << "NEW USER:" << json["Message"].toString();
+        scheduleFrame();
+    }
+
+    Filter filter;
+    filter.fromList(_filterModel->filterList());
+    _session->setFilter(filter);
+}
 
-        _localCnf.setUser(QString::number(QRandomGenerator64::global()->generate64()));
-        _localCnf.setPassword(QString::number(QRandomGenerator64::global()->generate64()));
+void MainWindow::mainTabWidget_currentChanged(int index)
+{
+    HANDLER_SCOPE("MainWindow::mainTabWidget_currentChanged");
 
-        sendNewUser(_localCnf.user(), _localCnf.password());
+    if (ui->mainTabWidget->widget(index) == ui->diagnosticsTab)
+    {
+        diagnosticsTimer_timeout();
+        _diagnosticsTimer->start();
     }
     else
     {
-        qDebug() << "NEW USER: user added successfully";
+        _diagnosticsTimer->stop();
+    }
 
-        sendLogin(_localCnf.user(), _localCnf.password());
+    if (index == 0 && _pendingChartID != 0)
+    {
+        scheduleFrame();
     }
+
+    if (index != 0 || !_session->isOnline())
+    {
+        return;
+    }
+
+    normalizeFilter();
+
+    //отправляем накопленные изменения сразу, не дожидаясь таймера
+    _session->flushConfig();
 }
 
-void MainWindow::addKLines(const QJsonArray &jsonKLineList)
+void MainWindow::diagnosticsTimer_timeout()
 {
-    for (int i = 0; i < jsonKLineList.count(); ++i)
+    HANDLER_SCOPE("MainWindow::diagnosticsTimer_timeout");
+
+    const auto usage = memoryUsage();
+    const QLocale locale;
+
+    QList<QPair<QString, QString>> rows;
+    for (quint8 i = 0; i < static_cast<quint8>(MemoryUsage::Subsystem::COUNT); ++i)
     {
-        addKLine(jsonKLineList.at(i).toObject());
+        const auto subsystem = static_cast<MemoryUsage::Subsystem>(i);
+        rows.push_back({MemoryUsage::subsystemToString(subsystem), locale.formattedDataSize(usage.bytes(subsystem))});
     }
 
-    if (jsonKLineList.count() != 0)
+    rows.push_back({"Total", locale.formattedDataSize(usage.total())});
+    rows.push_back({"Budget", locale.formattedDataSize(static_cast<qint64>(_localCnf.memoryBudget()) * 1024 * 1024)});
+
+    const auto heapSize = MemoryUsage::heapSize();
+    if (heapSize != 0)
     {
-        const auto item = ui->eventsList->item(ui->eventsList->count() - 1);
-        const auto id = item->data(Qt::UserRole);
-        const auto klines_it = _klines.find(id.toULongLong());
-        Q_ASSERT(klines_it != _klines.end());
+        rows.push_back({"WASM heap", locale.formattedDataSize(heapSize)});
+    }
 
-        showChart(*klines_it.value());
-        showReviewChart(*klines_it.value());
+    rows.push_back({"Events in list", QString::number(_klines.size())});
+    rows.push_back({"Dropped review histories", QString::number(_droppedReviewCount)});
+    rows.push_back({"Dropped events", QString::number(_droppedEventCount)});
 
-        ui->eventsList->setCurrentItem(item);
+    ui->memoryTableWidget->setRowCount(rows.size());
+    for (qsizetype row = 0; row < rows.size(); ++row)
+    {
+        ui->memoryTableWidget->setItem(row, 0, new QTableWidgetItem(rows.at(row).first));
+        ui->memoryTableWidget->setItem(row, 1, new QTableWidgetItem(rows.at(row).second));
+    }
+
+    //задержки цикла событий, самые долгие обработчики сверху
+    const auto& stallStats = _stallWatchdog->stats();
+    auto handlers = stallStats.keys();
+    std::sort(handlers.begin(), handlers.end(),
+        [&stallStats](const QString& handler1, const QString& handler2)
+        {
+            return stallStats.value(handler1).worstTime > stallStats.value(handler2).worstTime;
+        });
+
+    ui->stallTableWidget->setRowCount(handlers.size() + 1);
+    ui->stallTableWidget->setItem(0, 0, new QTableWidgetItem("Worst event loop latency"));
+    ui->stallTableWidget->setItem(0, 1, new QTableWidgetItem(""));
+    ui->stallTableWidget->setItem(0, 2, new QTableWidgetItem(QString::number(_stallWatchdog->worstLatency())));
+    ui->stallTableWidget->setItem(0, 3, new QTableWidgetItem(""));
+    for (qsizetype i = 0; i < handlers.size(); ++i)
+    {
+        const auto& stats = stallStats.value(handlers.at(i));
+        ui->stallTableWidget->setItem(i + 1, 0, new QTableWidgetItem(handlers.at(i)));
+        ui->stallTableWidget->setItem(i + 1, 1, new QTableWidgetItem(QString::number(stats.stallCount)));
+        ui->stallTableWidget->setItem(i + 1, 2, new QTableWidgetItem(QString::number(stats.worstTime)));
+        ui->stallTableWidget->setItem(i + 1, 3, new QTableWidgetItem(QString::number(stats.totalTime)));
     }
 }
 
-void MainWindow::addKLine(const QJsonObject &jsonKLine)
+void MainWindow::memoryBudgetSpinBox_valueChanged(int value)
 {
-    auto kline = new KLineData;
-    kline->stockExchangeID.name = jsonKLine["StockExchange"].toString();
-    kline->delta = jsonKLine["Delta"].toDouble();
-    kline->volume = jsonKLine["Volume"].toDouble();
+    _localCnf.setMemoryBudget(value);
 
-    QJsonArray history = jsonKLine["History"].toArray();
-    for (int i = 0; i < history.count(); ++i)
-    {
-        auto jsonKLine = history.at(i).toObject();
-        KLine tmp;
-        tmp.id.symbol = jsonKLine["Money"].toString();
-        tmp.id.type = stringToKLineType(jsonKLine["Interval"].toString());
-        tmp.openTime = QDateTime::fromString(jsonKLine["OpenTime"].toString(), DATETIME_FORMAT);
-        tmp.closeTime = QDateTime::fromString(jsonKLine["CloseTime"].toString(), DATETIME_FORMAT);
-        tmp.open = jsonKLine["Open"].toDouble();
-        tmp.close = jsonKLine["Close"].toDouble();
-        tmp.high = jsonKLine["High"].toDouble();
-        tmp.low = jsonKLine["Low"].toDouble();
-        tmp.volume = jsonKLine["Volume"].toDouble();
-        tmp.quoteAssetVolume = jsonKLine["QuoteAssetVolume"].toDouble();
+    updateCacheLimits();
+    enforceMemoryBudget();
+}
+
+void MainWindow::makeChart()
+{
+    //Chart
+    _chartView = new KLineChartView(HISTORY_BODY_WIDTH, HISTORY_CAPS_WIDTH, true, ui->chartFrame);
+    _chartView->resize(ui->chartFrame->size());
+    _chartView->show();
+
+    _longChartWidget = new KLineChartWidget(ui->chartFrame);
+    _longChartWidget->resize(ui->chartFrame->size());
+    _longChartWidget->hide();
+
+    //изображение предпросмотра должно оставаться поверх графика
+    _chartPreviewLabel->raise();
+}
+
+void MainWindow::makeReviewChart()
+{
+    //ReviewChart
+    _reviewChartView = new KLineChartView(REVIEW_BODY_WIDTH, REVIEW_CAPS_WIDTH, false, ui->reviewChartFrame);
+    _reviewChartView->resize(ui->reviewChartFrame->size());
+    _reviewChartView->show();
+
+    _reviewLongChartWidget = new KLineChartWidget(ui->reviewChartFrame);
+    _reviewLongChartWidget->resize(ui->reviewChartFrame->size());
+    _reviewLongChartWidget->hide();
+
+    _reviewChartPreviewLabel->raise();
+}
+
+void MainWindow::makePreviewCharts()
+{
+    //невидимые копии графиков событий: изображения предпросмотра рисуются тем же QtCharts, что и интерактивный график
+    _previewChartView = new KLineChartView(HISTORY_BODY_WIDTH, HISTORY_CAPS_WIDTH, true);
+    _previewChartView->setAttribute(Qt::WA_DontShowOnScreen);
+    _previewChartView->show();
+
+    _reviewPreviewChartView = new KLineChartView(REVIEW_BODY_WIDTH, REVIEW_CAPS_WIDTH, false);
+    _reviewPreviewChartView->setAttribute(Qt::WA_DontShowOnScreen);
+    _reviewPreviewChartView->show();
+}
+
+void MainWindow::makeFilterTab()
+{
+    HANDLER_SCOPE("MainWindow::makeFilterTab");
 
-        kline->history.emplaceBack(std::move(tmp));
+    _filterModel->setFilterList(_session->filter().toList());
+    normalizeFilter();
+
+    ui->filterTableView->setEditTriggers(QAbstractItemView::CurrentChanged | QAbstractItemView::DoubleClicked | QAbstractItemView::SelectedClicked);
+
+    showRemovePushButton();
+
+    ui->addPushButton->setEnabled(true);
+    ui->importPushButton->setEnabled(true);
+    ui->exportPushButton->setEnabled(true);
+}
+
+void MainWindow::normalizeFilter()
+{
+    Filter filter;
+    filter.fromList(_filterModel->filterList());
+
+    if (filter.normalize(_session->catalog()) == 0)
+    {
+        return;
     }
 
-    if (kline->history.isEmpty())
+    if (filter.isError())
     {
-        qDebug() << jsonKLine;
+        qDebug() << "FILTER:" << filter.errorString();
+    }
 
-        Q_ASSERT(false);
+    _filterModel->setFilterList(filter.toList());
 
+    showRemovePushButton();
+}
+
+void MainWindow::loadCachedState()
+{
+    if (_localCnf.catalog().isEmpty())
+    {
         return;
     }
 
-    QJsonArray reviewHistory = jsonKLine["ReviewHistory"].toArray();
-    for (int i = 0; i < reviewHistory.count(); ++i)
+    QJsonParseError error;
+    const auto catalogDoc = QJsonDocument::fromJson(_localCnf.catalog(), &error);
+    if (error.error != QJsonParseError::NoError || !catalogDoc.isArray())
     {
-        auto jsonKLine = reviewHistory.at(i).toObject();
-        KLine tmp;
-        tmp.id.symbol = jsonKLine["Money"].toString();
-        tmp.id.type = stringToKLineType(jsonKLine["Interval"].toString());
-        tmp.openTime = QDateTime::fromString(jsonKLine["OpenTime"].toString(), DATETIME_FORMAT);
-        tmp.closeTime = QDateTime::fromString(jsonKLine["CloseTime"].toString(), DATETIME_FORMAT);
-        tmp.open = jsonKLine["Open"].toDouble();
-        tmp.close = jsonKLine["Close"].toDouble();
-        tmp.high = jsonKLine["High"].toDouble();
-        tmp.low = jsonKLine["Low"].toDouble();
-        tmp.volume = jsonKLine["Volume"].toDouble();
-        tmp.quoteAssetVolume = jsonKLine["QuoteAssetVolume"].toDouble();
+        qDebug() << "Cached catalog is corrupted:" << error.errorString();
+
+        return;
+    }
+
+    _session->applyCatalog(catalogDoc.array());
 
-        kline->reviewHistory.emplaceBack(std::move(tmp));
+    Filter filter;
+    const auto filterDoc = QJsonDocument::fromJson(_localCnf.filter(), &error);
+    if (error.error == QJsonParseError::NoError && filterDoc.isArray())
+    {
+        filter.fromJSON(filterDoc.array());
+        if (filter.isError())
+        {
+            qDebug() << "Cached filter:" << filter.errorString();
+        }
     }
 
+    //только для просмотра: редактирование включит makeFilterTab() после ответа сервера
+    _filterModel->setFilterList(filter.toList());
+}
+
+void MainWindow::addKLine(KLineData *kline)
+{
+    HANDLER_SCOPE("MainWindow::addKLine");
+
+    Q_CHECK_PTR(kline);
+    Q_ASSERT(!kline->history.isEmpty());
+
     ++_lastIDKLine;
     _klines.insert(_lastIDKLine, kline);
 
-    const QString text = QString("%1->%2 Interval: %3 Delta=%4 Volume=%5")
+    const QString text = QString("%1%2->%3 Interval: %4 Delta=%5 Volume=%6")
+                             .arg(kline->isLocal ? "LOCAL " : "")
                              .arg(kline->stockExchangeID.name)
                              .arg(kline->history.first().id.symbol)
                              .arg(KLineTypeToString(kline->history.first().id.type))
@@ -940,215 +1021,628 @@ void MainWindow::addKLine(const QJsonObject &jsonKLine)
         item->setData(Qt::UserRole + 1, static_cast<quint8>(EventType::DECREASE));
     }
 
+    item->setHidden(!isKLineAccepted(*kline));
+
     ui->eventsList->addItem(item);
 
-    if (ui->eventsList->count() > 100)
+    addPreRender(_lastIDKLine);
+    while (_preRenderQueue.size() > PRE_RENDER_NEWEST_COUNT + 2 * PRE_RENDER_NEIGHBOURS_COUNT)
+    {
+        _preRenderQueue.removeFirst();
+    }
+
+    if (ui->eventsList->count() > MAX_EVENT_ITEMS)
     {
         for (int i = 0; i < 2; ++i)
         {
-            const auto item = ui->eventsList->takeItem(i);
-            const auto id = item->data(Qt::UserRole);
+            const auto id = ui->eventsList->item(i)->data(Qt::UserRole);
             if (!id.isNull())
             {
-                const auto klines_it = _klines.find(id.toULongLong());
-                delete klines_it.value();
-                _klines.erase(klines_it);
+                removeEvent(id.toULongLong());
+            }
+            else
+            {
+                delete ui->eventsList->takeItem(i);
             }
         }
     }
 }
 
-void MainWindow::showChart(const KLineData &klineData)
+void MainWindow::removeEvent(quint64 id)
 {
-    if (_chartView == nullptr)
+    const auto item = findEventItem(id);
+    if (item != nullptr)
     {
-        makeChart();
+        delete ui->eventsList->takeItem(ui->eventsList->row(item));
     }
 
-    Q_CHECK_PTR(_series);
-    Q_CHECK_PTR(_chartView);
+    const auto klines_it = _klines.find(id);
+    if (klines_it != _klines.end())
+    {
+        delete klines_it.value();
+        _klines.erase(klines_it);
+    }
+
+    _eventViews.remove(id);
+    _preRenderQueue.removeAll(id);
+    if (_preRenderID == id)
+    {
+        cancelPreRender();
+    }
+    _chartImageCache.remove(id);
+    _indicatorCache.remove(id);
+    _reviewIndicatorCache.remove(id);
+}
+
+void MainWindow::addPreRender(quint64 id)
+{
+    if (_chartImageCache.contains(id) || _preRenderQueue.contains(id))
+    {
+        return;
+    }
+
+    _preRenderQueue.push_back(id);
+
+    if (!_preRenderTimer->isActive())
+    {
+        _preRenderTimer->start();
+    }
+}
+
+quint64 MainWindow::takePreRender()
+{
+    while (!_preRenderQueue.isEmpty())
+    {
+        const auto id = _preRenderQueue.takeFirst();
+        if (!_chartImageCache.contains(id) && _klines.contains(id))
+        {
+            return id;
+        }
+    }
+
+    return 0;
+}
+
+void MainWindow::cancelPreRender()
+{
+    delete _preRenderImages;
+    _preRenderImages = nullptr;
+    _preRenderID = 0;
+}
+
+QImage MainWindow::preRenderHistory(quint64 id, const KLineData &klineData)
+{
+    //изображение рисуется тем же способом, что и график в showChart()
+    const auto history = chartHistory(klineData);
+    const auto title = chartTitle(klineData, history);
+
+    const auto columns = longHistoryColumns(klineData, history);
+    if (!columns.isEmpty())
+    {
+        return KLineChartWidget::render(columns, title, ui->chartFrame->size());
+    }
+
+    if (history.size() >= LONG_HISTORY_SIZE)
+    {
+        return KLineChartWidget::render(history, title, ui->chartFrame->size());
+    }
+
+    if (_previewChartView == nullptr)
+    {
+        makePreviewCharts();
+    }
+
+    _previewChartView->resize(ui->chartFrame->size());
+    _previewChartView->setKLines(title, history, indicators(_indicatorCache, id, history));
+
+    return QImage();
+}
+
+QImage MainWindow::preRenderReviewHistory(quint64 id, const KLineData &klineData)
+{
+    if (klineData.reviewHistory.size() >= LONG_HISTORY_SIZE)
+    {
+        return KLineChartWidget::render(klineData.reviewHistory, reviewChartTitle(klineData), ui->reviewChartFrame->size());
+    }
+
+    if (_reviewPreviewChartView == nullptr)
+    {
+        makePreviewCharts();
+    }
+
+    _reviewPreviewChartView->resize(ui->reviewChartFrame->size());
+    _reviewPreviewChartView->setKLines(reviewChartTitle(klineData), klineData.reviewHistory,
+                                       indicators(_reviewIndicatorCache, id, klineData.reviewHistory));
+
+    return QImage();
+}
+
+void MainWindow::addPreRenderNeighbours(int row)
+{
+    for (int i = 1; i <= PRE_RENDER_NEIGHBOURS_COUNT; ++i)
+    {
+        for (const auto neighbourRow: {row + i, row - i})
+        {
+            const auto item = ui->eventsList->item(neighbourRow);
+            if (item != nullptr && !item->data(Qt::UserRole).isNull())
+            {
+                addPreRender(item->data(Qt::UserRole).toULongLong());
+            }
+        }
+    }
+}
 
-    _series->clear();
-    _seriesVolume->clear();
+void MainWindow::showChartPreview(const ChartImages &chartImages)
+{
+    _chartPreviewLabel->setPixmap(QPixmap::fromImage(chartImages.history));
+    _chartPreviewLabel->resize(ui->chartFrame->size());
+    _chartPreviewLabel->raise();
+    _chartPreviewLabel->show();
+
+    _reviewChartPreviewLabel->setPixmap(QPixmap::fromImage(chartImages.reviewHistory));
+    _reviewChartPreviewLabel->resize(ui->reviewChartFrame->size());
+    _reviewChartPreviewLabel->raise();
+    _reviewChartPreviewLabel->show();
+}
 
-    _chartView->chart()->setTitle(QString("%1: %2 %3")
-                                            .arg(klineData.stockExchangeID.name)
-                                            .arg(klineData.history.first().id.symbol)
-                                            .arg(KLineTypeToString(klineData.history.first().id.type)));
+void MainWindow::hideChartPreview()
+{
+    if (_chartPreviewLabel != nullptr)
+    {
+        _chartPreviewLabel->hide();
+    }
 
-    double max = std::numeric_limits<double>::min();
-    double min = std::numeric_limits<double>::max();
-    double maxVolume = std::numeric_limits<double>::min();
+    if (_reviewChartPreviewLabel != nullptr)
+    {
+        _reviewChartPreviewLabel->hide();
+    }
+}
 
-    for (auto kline_it = klineData.history.begin(); kline_it != klineData.history.end(); ++kline_it)
+bool MainWindow::isKLineAccepted(const KLineData &klineData) const
+{
+    if (_filterMatcher.isEmpty())
     {
-        auto candlestick = new QCandlestickSet(kline_it->closeTime.toMSecsSinceEpoch());
-        candlestick->setHigh(kline_it->high);
-        candlestick->setLow(kline_it->low);
-        candlestick->setOpen(kline_it->open);
-        candlestick->setClose(kline_it->open != kline_it->close ? kline_it->close : kline_it->close + 0.001 * kline_it->close);
-        auto pen = _series->pen();
-        pen.setColor(kline_it->open <= kline_it->close ? QColor(Qt::green) : QColor(Qt::red));
-        candlestick->setPen(pen);
+        return true;
+    }
 
-        _series->append(candlestick);
+    //событие определяется первой свечой истории
+    return _filterMatcher.match(klineData.stockExchangeID, klineData.history.first()) != nullptr;
+}
 
-        auto candlestickVolume = new QCandlestickSet(kline_it->closeTime.toMSecsSinceEpoch());
-        candlestickVolume->setOpen(kline_it->volume);
-        candlestickVolume->setHigh(kline_it->volume);
-        candlestickVolume->setLow(0);
-        candlestickVolume->setClose(0);
-        auto penVolume = _seriesVolume->pen();
-        penVolume.setColor(QColor(61, 56, 70));
-        candlestickVolume->setPen(penVolume);
+void MainWindow::applyLocalFilter()
+{
+    for (int row = 0; row < ui->eventsList->count(); ++row)
+    {
+        auto item = ui->eventsList->item(row);
+        const auto id = item->data(Qt::UserRole);
+        if (id.isNull())
+        {
+            continue;
+        }
 
-        _seriesVolume->append(candlestickVolume);
+        const auto klines_it = _klines.find(id.toULongLong());
+        if (klines_it == _klines.end())
+        {
+            continue;
+        }
 
-        max = std::max(max, kline_it->high);
-        min = std::min(min, kline_it->low);
-        maxVolume = std::max(maxVolume, kline_it->volume);
+        item->setHidden(!isKLineAccepted(*klines_it.value()));
     }
+}
 
-    auto axisX = qobject_cast<QDateTimeAxis*>(_chartView->chart()->axes(Qt::Horizontal).at(0));
-    axisX->setMax(klineData.history.first().closeTime.addMSecs(static_cast<qint64>(klineData.history.first().id.type) * 5));
-    axisX->setMin(klineData.history.last().closeTime.addMSecs(-static_cast<qint64>(klineData.history.first().id.type)));
-    axisX->setTickCount(5);
+void MainWindow::showChart(quint64 id, const KLineData &klineData)
+{
+    HANDLER_SCOPE("MainWindow::showChart");
 
-    auto axisY = qobject_cast<QValueAxis*>(_chartView->chart()->axes(Qt::Vertical).at(0));
-    axisY->setMax(max * 1.05);
-    axisY->setMin(min * 0.95);
+    if (_chartView == nullptr)
+    {
+        makeChart();
+    }
+
+    Q_CHECK_PTR(_chartView);
+
+    const auto history = chartHistory(klineData);
+    const auto title = chartTitle(klineData, history);
+
+    //накопленная история инструмента до свечи события рисуется прямо из хранилища, без копирования в KLines
+    const auto columns = longHistoryColumns(klineData, history);
+    if (!columns.isEmpty())
+    {
+        _chartView->clear();
+        _chartView->hide();
+
+        _longChartWidget->setTitle(title);
+        _longChartWidget->setKLines(columns);
+        _longChartWidget->show();
+
+        return;
+    }
+
+    if (history.size() >= LONG_HISTORY_SIZE)
+    {
+        _chartView->clear();
+        _chartView->hide();
 
-    auto axisY2 = qobject_cast<QValueAxis*>(_chartView->chart()->axes(Qt::Vertical).at(1));
-    axisY2->setMax(maxVolume * 2);
-    axisY2->setMin(0);
+        _longChartWidget->setTitle(title);
+        _longChartWidget->setKLines(history);
+        _longChartWidget->show();
+
+        return;
+    }
+
+    _longChartWidget->hide();
+
+    _chartView->setKLines(title, history, indicators(_indicatorCache, id, history));
 
     _chartView->show();
 }
 
-void MainWindow::showReviewChart(const KLineData &klineData)
+void MainWindow::showReviewChart(quint64 id, const KLineData &klineData)
 {
+    HANDLER_SCOPE("MainWindow::showReviewChart");
+
     if (_reviewChartView == nullptr)
     {
         makeReviewChart();
     }
 
-    Q_CHECK_PTR(_reviewSeries);
     Q_CHECK_PTR(_reviewChartView);
 
-    _reviewSeries->clear();
-    _reviewSeriesVolume->clear();
+    if (klineData.reviewHistory.size() >= LONG_HISTORY_SIZE)
+    {
+        _reviewChartView->clear();
+        _reviewChartView->hide();
+
+        _reviewLongChartWidget->setTitle(reviewChartTitle(klineData));
+        _reviewLongChartWidget->setKLines(klineData.reviewHistory);
+        _reviewLongChartWidget->show();
+
+        return;
+    }
+
+    _reviewLongChartWidget->hide();
 
+    _reviewChartView->setKLines(reviewChartTitle(klineData), klineData.reviewHistory, indicators(_reviewIndicatorCache, id, klineData.reviewHistory));
+
+    _reviewChartView->show();
+}
+
+KLines MainWindow::chartHistory(const KLineData &klineData) const
+{
+    //при выбранном старшем интервале история пересчитывается из свечей события, без запроса к серверу
+    const auto sourceType = klineData.history.first().id.type;
+    if (_chartInterval != sourceType && KLineResampler::canResample(sourceType, _chartInterval))
+    {
+        const auto resampledHistory = KLineResampler::resample(klineData.history, _chartInterval);
+        if (!resampledHistory.isEmpty())
+        {
+            return resampledHistory;
+        }
+    }
+
+    return klineData.history;
+}
+
+KLineColumns MainWindow::longHistoryColumns(const KLineData &klineData, const KLines &history)
+{
+    //хранилище содержит свечи только интервала события
+    if (history.first().id.type != klineData.history.first().id.type)
+    {
+        return KLineColumns();
+    }
+
+    const auto columns = _klineStoreCache->columns(klineData.stockExchangeID, history.first().id);
+    const auto end = columns.upperBound(history.first().openTime.toMSecsSinceEpoch());
+    if (end <= history.size() || end < LONG_HISTORY_SIZE)
+    {
+        return KLineColumns();
+    }
+
+    return columns.subspan(0, end);
+}
+
+QString MainWindow::chartTitle(const KLineData &klineData, const KLines &history)
+{
+    return QString("%1: %2 %3")
+        .arg(klineData.stockExchangeID.name)
+        .arg(history.first().id.symbol)
+        .arg(KLineTypeToString(history.first().id.type));
+}
+
+QString MainWindow::reviewChartTitle(const KLineData &klineData)
+{
     if (klineData.reviewHistory.isEmpty())
     {
-        _reviewChartView->chart()->setTitle("No data");
-        _reviewChartView->show();
+        return QString("No data");
+    }
+
+    return QString("%1 %2")
+        .arg(klineData.reviewHistory.first().id.symbol)
+        .arg(KLineTypeToString(klineData.reviewHistory.first().id.type));
+}
+
+const KLineIndicators *MainWindow::indicators(IndicatorCache &cache, quint64 id, const KLines &history)
+{
+    if (_indicatorType == KLineIndicators::Type::NONE || history.isEmpty())
+    {
+        return nullptr;
+    }
+
+    //история события не меняется - линии считаются один раз и берутся из кеша
+    const auto result = cache.object(id);
+    if (result != nullptr)
+    {
+        return result;
+    }
+
+    auto indicators = new KLineIndicators(KLineIndicators::make(_indicatorType, history));
+    if (!cache.insert(id, indicators, indicators->size() + 1))
+    {
+        qDebug() << "Indicator lines too large for cache. Event ID:" << id;
+
+        return nullptr;
+    }
+
+    return cache.object(id);
+}
+
+MemoryUsage MainWindow::memoryUsage() const
+{
+    MemoryUsage result;
+
+    for (const auto klineData: _klines)
+    {
+        result.add(MemoryUsage::Subsystem::EVENTS, MemoryUsage::klineDataSize(*klineData));
+        result.add(MemoryUsage::Subsystem::REVIEW_HISTORY, MemoryUsage::klinesSize(klineData->reviewHistory));
+    }
+
+    for (const auto klineData: _pendingKLines)
+    {
+        result.add(MemoryUsage::Subsystem::PENDING_EVENTS, MemoryUsage::klineDataSize(*klineData) + MemoryUsage::klinesSize(klineData->reviewHistory));
+    }
+
+    for (int row = 0; row < ui->eventsList->count(); ++row)
+    {
+        result.add(MemoryUsage::Subsystem::EVENT_LIST, LIST_ITEM_SIZE + ui->eventsList->item(row)->text().capacity() * sizeof(QChar));
+    }
+
+    result.add(MemoryUsage::Subsystem::HTTP_RESULTS, Common::HTTPSQuery::resultsSize());
+
+    //графики создаются при первом показе события
+    for (const auto chartView: {_chartView, _reviewChartView, _previewChartView, _reviewPreviewChartView})
+    {
+        if (chartView != nullptr)
+        {
+            result.add(MemoryUsage::Subsystem::CHART_SERIES, chartView->setCount() * CANDLESTICK_SET_SIZE
+                                                             + chartView->indicatorPointCount() * sizeof(QPointF));
+        }
+    }
+
+    result.add(MemoryUsage::Subsystem::CHART_IMAGES, static_cast<qsizetype>(_chartImageCache.totalCost()) * 1024);
+    result.add(MemoryUsage::Subsystem::INDICATORS, static_cast<qsizetype>(_indicatorCache.totalCost() + _reviewIndicatorCache.totalCost()) * sizeof(QPointF));
+
+    return result;
+}
+
+//уменьшает кеш на excess единиц стоимости, вытесняя давно использованные элементы. Возвращает освобожденную стоимость
+template <typename Key, typename T>
+static qsizetype trimCache(QCache<Key, T>& cache, qsizetype excess)
+{
+    const auto maxCost = cache.maxCost();
+    const auto totalCost = cache.totalCost();
+
+    cache.setMaxCost(std::max<qsizetype>(totalCost - excess, 0));
+    cache.setMaxCost(maxCost);
+
+    return totalCost - cache.totalCost();
+}
+
+//память освобождается, только если свечи больше никто не разделяет (журнал, сеанс, графики)
+static qsizetype releasedSize(const KLines& klines)
+{
+    return klines.isDetached() ? MemoryUsage::klinesSize(klines) : 0;
+}
+
+void MainWindow::updateCacheLimits()
+{
+    //кеши занимают только часть бюджета, иначе заполненный кеш вытеснял бы события
+    const auto budget = static_cast<qsizetype>(_localCnf.memoryBudget()) * 1024 * 1024;
+
+    _chartImageCache.setMaxCost(std::min<qsizetype>(CHART_IMAGE_CACHE_SIZE, budget / CHART_IMAGE_BUDGET_SHARE / 1024));
+
+    const auto indicatorCacheSize = std::min<qsizetype>(INDICATOR_CACHE_SIZE, budget / INDICATOR_BUDGET_SHARE / static_cast<qsizetype>(sizeof(QPointF)));
+    _indicatorCache.setMaxCost(indicatorCacheSize);
+    _reviewIndicatorCache.setMaxCost(indicatorCacheSize);
+}
 
+qsizetype MainWindow::cachesSize() const
+{
+    return static_cast<qsizetype>(_chartImageCache.totalCost()) * 1024
+           + static_cast<qsizetype>(_indicatorCache.totalCost() + _reviewIndicatorCache.totalCost()) * sizeof(QPointF);
+}
+
+void MainWindow::enforceMemoryBudget()
+{
+    const auto budget = static_cast<qsizetype>(_localCnf.memoryBudget()) * 1024 * 1024;
+
+    auto total = memoryUsage().total();
+    if (total <= budget)
+    {
+        return;
+    }
+
+    //0. кеши: изображения и линии индикаторов строятся заново по историям событий
+    total -= trimCache(_chartImageCache, (total - budget + 1023) / 1024) * 1024;
+
+    for (const auto cache: {&_indicatorCache, &_reviewIndicatorCache})
+    {
+        if (total <= budget)
+        {
+            break;
+        }
+
+        const auto pointSize = static_cast<qsizetype>(sizeof(QPointF));
+        total -= trimCache(*cache, (total - budget + pointSize - 1) / pointSize) * pointSize;
+    }
+
+    if (total <= budget)
+    {
         return;
     }
 
-    _reviewChartView->chart()->setTitle(QString("%2 %3")
-                                            .arg(klineData.reviewHistory.first().id.symbol)
-                                            .arg(KLineTypeToString(klineData.reviewHistory.first().id.type)));
+    //первыми вытесняются редко просматриваемые события, среди них - старые. Показанное событие не трогаем
+    QList<quint64> ids;
+    ids.reserve(_klines.size());
+    for (auto klines_it = _klines.begin(); klines_it != _klines.end(); ++klines_it)
+    {
+        if (klines_it.key() != _currentChartID)
+        {
+            ids.push_back(klines_it.key());
+        }
+    }
+
+    std::sort(ids.begin(), ids.end(),
+        [this](quint64 id1, quint64 id2)
+        {
+            const auto views1 = _eventViews.value(id1);
+            const auto views2 = _eventViews.value(id2);
 
-    double max = std::numeric_limits<double>::min();
-    double min = std::numeric_limits<double>::max();
-    double maxVolume = std::numeric_limits<double>::min();
+            return views1 != views2 ? views1 < views2 : id1 < id2;
+        });
 
-    for (auto kline_it = klineData.reviewHistory.begin(); kline_it != klineData.reviewHistory.end(); ++kline_it)
+    //1. обзорные истории
+    for (const auto id: ids)
     {
-        auto candlestick = new QCandlestickSet(kline_it->closeTime.toMSecsSinceEpoch());
+        if (total <= budget)
+        {
+            break;
+        }
 
-        candlestick->setHigh(kline_it->high);
-        candlestick->setLow(kline_it->low);
-        candlestick->setOpen(kline_it->open);
-        candlestick->setClose(kline_it->close);
-        auto pen = _series->pen();
-        pen.setColor(kline_it->open <= kline_it->close ? QColor(Qt::green) : QColor(Qt::red));
-        candlestick->setPen(pen);
+        auto& reviewHistory = _klines.value(id)->reviewHistory;
+        if (reviewHistory.isEmpty())
+        {
+            continue;
+        }
 
-        _reviewSeries->append(candlestick);
+        const auto cacheSize = cachesSize();
 
-        auto candlestickVolume = new QCandlestickSet(kline_it->closeTime.toMSecsSinceEpoch());
-        candlestickVolume->setOpen(kline_it->volume);
-        candlestickVolume->setHigh(kline_it->volume);
-        candlestickVolume->setLow(0);
-        candlestickVolume->setClose(0);
-        auto penVolume = _seriesVolume->pen();
-        penVolume.setColor(QColor(61, 56, 70));
-        candlestickVolume->setPen(penVolume);
+        total -= releasedSize(reviewHistory);
+        reviewHistory = KLines();
 
-        _reviewSeriesVolume->append(candlestickVolume);
+        _reviewIndicatorCache.remove(id);
+        total -= cacheSize - cachesSize();
 
+        ++_droppedReviewCount;
 
-        max = std::max(max, kline_it->high);
-        min = std::min(min, kline_it->low);
-        maxVolume = std::max(maxVolume, kline_it->volume);
+        const auto item = findEventItem(id);
+        if (item != nullptr)
+        {
+            item->setToolTip("Review history was dropped to stay within the memory budget");
+        }
     }
 
-    auto axisX = qobject_cast<QDateTimeAxis*>(_reviewChartView->chart()->axes(Qt::Horizontal).at(0));
-    axisX->setMax(klineData.reviewHistory.first().closeTime.addMSecs(static_cast<qint64>(klineData.reviewHistory.first().id.type) * 5));
-    axisX->setMin(klineData.reviewHistory.last().closeTime.addMSecs(-static_cast<qint64>(klineData.reviewHistory.first().id.type)));
-    axisX->setTickCount(5);
+    //2. события целиком вместе с их изображениями и линиями индикаторов
+    qsizetype removeCount = 0;
+    for (const auto id: ids)
+    {
+        if (total <= budget)
+        {
+            break;
+        }
+
+        const auto klineData = _klines.value(id);
+        auto eventSize = MemoryUsage::klineDataSize(*klineData) - MemoryUsage::klinesSize(klineData->history)
+                         + releasedSize(klineData->history) + releasedSize(klineData->reviewHistory);
+
+        const auto item = findEventItem(id);
+        if (item != nullptr)
+        {
+            eventSize += LIST_ITEM_SIZE + item->text().capacity() * sizeof(QChar);
+        }
 
-    auto axisY = qobject_cast<QValueAxis*>(_reviewChartView->chart()->axes(Qt::Vertical).at(0));
-    axisY->setMax(max * 1.05);
-    axisY->setMin(min * 0.95);
+        const auto cacheSize = cachesSize();
 
-    auto axisY2 = qobject_cast<QValueAxis*>(_reviewChartView->chart()->axes(Qt::Vertical).at(1));
-    axisY2->setMax(maxVolume * 2);
-    axisY2->setMin(0);
+        removeEvent(id);
 
-    _reviewChartView->show();
+        total -= eventSize + cacheSize - cachesSize();
+
+        ++_droppedEventCount;
+        ++removeCount;
+    }
+
+    qDebug() << "MEMORY: Budget" << _localCnf.memoryBudget() << "Mb exceeded. Dropped review histories:" << _droppedReviewCount
+             << "events:" << removeCount << "Estimated usage:" << total / 1024 << "Kb";
+}
+
+void MainWindow::showRemovePushButton()
+{
+    ui->removePushButton->setEnabled(_filterModel->rowCount() != 0);
 }
 
-void MainWindow::sendHTTPRequest(const QUrl &url, HTTPRequstType type, const QByteArray& data)
+
+void MainWindow::changeEvent(QEvent *event)
 {
-    RequestData request;
-    request.HTTPSQuery = new HTTPSQuery();
-    request.type = type;
+    HANDLER_SCOPE("MainWindow::changeEvent");
+
+    QMainWindow::changeEvent(event);
 
-    QObject::connect(request.HTTPSQuery, SIGNAL(getAnswer(const QByteArray&, int)),
-                     SLOT(getAnswerHttp(const QByteArray&, int)));
-    QObject::connect(request.HTTPSQuery, SIGNAL(errorOccurred(quint32, const QString&, int)),
-                     SLOT(errorOccurredHttp(quint32, const QString&, int)));
+    if (event->type() == QEvent::WindowStateChange)
+    {
+        updateStallWatchdog();
+    }
 
-    _sentHTTPRequest.insert(request.HTTPSQuery->send(url, _headers, data), request);
+    //графики, отложенные пока окно было свернуто
+    if (event->type() == QEvent::WindowStateChange && _pendingChartID != 0)
+    {
+        scheduleFrame();
+    }
 }
 
-void MainWindow::addFilterRow(const QString &stockExchange, const QString &money, const QString &interval, double delta, double volume)
+void MainWindow::showEvent(QShowEvent *event)
 {
-    auto deltaSpinBox = new QDoubleSpinBox();
-    deltaSpinBox->setMinimum(2);
-    deltaSpinBox->setMaximum(1000000);
-    deltaSpinBox->setValue(delta);
-    deltaSpinBox->setSpecialValueText("MINIMUM");
+    HANDLER_SCOPE("MainWindow::showEvent");
 
-    auto volumeSpinBox = new QDoubleSpinBox();
-    volumeSpinBox->setMinimum(500);
-    volumeSpinBox->setMaximum(1000000);
-    volumeSpinBox->setSingleStep(100.0);
-    volumeSpinBox->setValue(volume);
-    volumeSpinBox->setSpecialValueText("MINIMUM");
+    QMainWindow::showEvent(event);
 
-    ui->filterTableWidget->insertRow(ui->filterTableWidget->rowCount());
-    const auto currentRow = ui->filterTableWidget->rowCount() - 1;
-    ui->filterTableWidget->setCellWidget(currentRow, 0, makeStockExchangeComboBox(stockExchange));
-    ui->filterTableWidget->setCellWidget(currentRow, 1, makeMoneyComboBox(stockExchange, money));
-    ui->filterTableWidget->setCellWidget(currentRow, 2, makeIntervalComboBox(stockExchange, money, interval));
-    ui->filterTableWidget->setCellWidget(currentRow, 3, deltaSpinBox);
-    ui->filterTableWidget->setCellWidget(currentRow, 4, volumeSpinBox);
+    updateStallWatchdog();
 
-    showRemovePushButton();
+    if (!_isFirstFrameShown)
+    {
+        _isFirstFrameShown = true;
+
+        //срабатывает после обработки событий отрисовки первого показа окна
+        QTimer::singleShot(0, this,
+            [this]()
+            {
+                qDebug() << "Startup: first interactive frame in" << _startupTimer.elapsed() << "ms."
+                         << "Cached events:" << _pendingKLines.size() + _klines.size()
+                         << "Cached filter rules:" << _filterModel->rowCount();
+            });
+    }
+
+    if (_pendingChartID != 0)
+    {
+        scheduleFrame();
+    }
 }
 
-void MainWindow::showRemovePushButton()
+void MainWindow::hideEvent(QHideEvent *event)
 {
-    ui->removePushButton->setEnabled(ui->filterTableWidget->rowCount() != 0);
+    QMainWindow::hideEvent(event);
+
+    updateStallWatchdog();
 }
 
+void MainWindow::updateStallWatchdog()
+{
+    //таймеры свернутого окна и фоновой вкладки браузера замедляются - их задержки не ошибка программы
+    _stallWatchdog->setActive(isVisible() && !isMinimized() && QGuiApplication::applicationState() == Qt::ApplicationActive);
+}
 
 void MainWindow::resizeEvent(QResizeEvent *event)
 {
+    HANDLER_SCOPE("MainWindow::resizeEvent");
+
     if (_chartView != nullptr)
     {
         _chartView->resize(ui->chartFrame->size());
@@ -1161,5 +1655,26 @@ void MainWindow::resizeEvent(QResizeEvent *event)
         _reviewChartView->update();
     }
 
+    if (_longChartWidget != nullptr)
+    {
+        _longChartWidget->resize(ui->chartFrame->size());
+    }
+
+    //изображения в кеше нарисованы под старый размер
+    if (_chartImageSize != ui->chartFrame->size() || _reviewChartImageSize != ui->reviewChartFrame->size())
+    {
+        _chartImageSize = ui->chartFrame->size();
+        _reviewChartImageSize = ui->reviewChartFrame->size();
+        _chartImageCache.clear();
+        cancelPreRender();
+
+        hideChartPreview();
+    }
+
+    if (_reviewLongChartWidget != nullptr)
+    {
+        _reviewLongChartWidget->resize(ui->reviewChartFrame->size());
+    }
+
     _localCnf.setSplitterPos(ui->detectorSplitter->saveState());
 }
@@ -5,16 +5,35 @@
 #include <QChart>
 #include <QChartView>
 #include <QCandlestickSeries>
+#include <QLineSeries>
 #include <QListWidgetItem>
 #include <QSet>
 #include <QMap>
 #include <QHash>
-#include <QComboBox>
-
-#include "httpsquery.h"
+#include <QTimer>
+#include <QCache>
+#include <QImage>
+#include <QLabel>
+#include <QElapsedTimer>
+#include <QJsonArray>
+
+#include "session.h"
 #include "localconfig.h"
 #include "types.h"
 #include "filter.h"
+#include "filtermodel.h"
+#include "filterdelegate.h"
+#include "filtermatcher.h"
+#include "spikedetector.h"
+#include "klinechartview.h"
+#include "klinechartwidget.h"
+#include "klineresampler.h"
+#include "klineindicators.h"
+#include "eventlog.h"
+#include "klinestore.h"
+#include "klinestorecache.h"
+#include "memoryusage.h"
+#include "stallwatchdog.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui {
@@ -25,17 +44,8 @@ QT_END_NAMESPACE
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
-private:
-    enum class HTTPRequstType: quint8
-    {
-        NONE = 0,
-        LOGIN = 1,
-        KLINES = 2,
-        CONFIG = 3,
-        NEWUSER = 4,
-        DATA = 5
-    };
 
+private:
     enum class EventType: quint8
     {
         INCREASE = 1,
@@ -49,78 +59,100 @@ public:
 
 protected:
     virtual void resizeEvent(QResizeEvent *event) override;
+    virtual void changeEvent(QEvent *event) override;
+    virtual void showEvent(QShowEvent *event) override;
+    virtual void hideEvent(QHideEvent *event) override;
 
 private slots:
-    void login(const QString& title);
-
-    void getAnswerHttp(const QByteArray& answer, int id);
-    void errorOccurredHttp(quint32 code, const QString& msg, int id);
+    void session_credentialsChanged(const QString& user, const QString& password);
+    void session_loggedIn();
+    void session_catalogReceived(const QJsonArray& klinesJson);
+    void session_serverFilterChanged(const QJsonArray& filterJson);
+    void session_eventsReceived(const QList<KLineData>& klines);
+    void session_messagesReceived(const QStringList& messages);
+    void session_connectionLost();
 
     void eventList_itemClicked(QListWidgetItem *item);
+    void eventList_currentItemChanged(QListWidgetItem *current, QListWidgetItem *previous);
+    void preRenderTimer_timeout();
+    void frameTimer_timeout();
     void eventList_itemDoubleClicked(QListWidgetItem *item);
     void detectorSplitter_splitterMoved(int pos, int index);
+    void chartIntervalComboBox_currentIndexChanged(int index);
+    void indicatorComboBox_currentIndexChanged(int index);
 
     void addPushButton_clicked();
     void removePushButton_clicked();
+    void importPushButton_clicked();
+    void exportJSONAction_triggered();
+    void exportCSVAction_triggered();
+    void localDetectionCheckBox_toggled(bool checked);
 
-    void stockExchangeComboBox_currentIndexChanged(int index);
+    void filterModel_changed();
 
     void mainTabWidget_currentChanged(int index);
 
+    void diagnosticsTimer_timeout();
+    void memoryBudgetSpinBox_valueChanged(int value);
+
 private:
-    struct KLineData
+    struct ChartImages //заранее нарисованные графики события
     {
-        StockExchangeID stockExchangeID;
-        double delta = 0.0;
-        double volume = 0.0;
-        KLines history;
-        KLines reviewHistory;
+        KLineType interval = KLineType::UNKNOW;
+        QImage history;
+        QImage reviewHistory;
     };
 
-    using ExistIntervals = QSet<QString>;
-    using ExistsKLines = QMap<QString, ExistIntervals>;
-    using ExistsStockExchange = QMap<QString, ExistsKLines>;
+    using IndicatorCache = QCache<quint64, KLineIndicators>;
 
-    struct RequestData
+    enum class PreRenderStep //шаги предварительной отрисовки графиков одного события
     {
-        HTTPRequstType type = HTTPRequstType::NONE;
-        Common::HTTPSQuery *HTTPSQuery = nullptr;
+        HISTORY,
+        HISTORY_IMAGE,
+        REVIEW,
+        REVIEW_IMAGE,
+        DONE
     };
 
-    using RequestInfo = QHash<int, RequestData>;
-
 private:
     void makeChart();
     void makeReviewChart();
+    void makePreviewCharts();
     void makeFilterTab();
-    QComboBox* makeStockExchangeComboBox(const QString& stockExchange) const;
-    QComboBox* makeMoneyComboBox(const QString& stockExchange, const QString& money) const;
-    QComboBox* makeIntervalComboBox(const QString& stockExchange, const QString& money, const QString& interval) const;
-
-    void addFilterRow(const QString& stockExchange, const QString& money, const QString& interval, double delta, double volume);
+    void loadCachedState();
+    void normalizeFilter();
+
+    void addKLine(KLineData *kline);
+    void removeEvent(quint64 id);
+    void showEventCharts(quint64 id);
+    QListWidgetItem* findEventItem(quint64 id) const;
+    bool isChartVisible() const;
+    void scheduleFrame();
+    void addPreRender(quint64 id);
+    void addPreRenderNeighbours(int row);
+    void showChartPreview(const ChartImages& chartImages);
+    quint64 takePreRender(); //следующее событие из очереди предварительной отрисовки. 0 - очередь пуста
+    void cancelPreRender();
+    QImage preRenderHistory(quint64 id, const KLineData& klineData); //пустое изображение - заполнен невидимый график QtCharts
+    QImage preRenderReviewHistory(quint64 id, const KLineData& klineData);
+
+    KLines chartHistory(const KLineData& klineData) const; //история события в выбранном интервале графика
+    KLineColumns longHistoryColumns(const KLineData& klineData, const KLines& history); //пусто - история из хранилища не нужна
+    static QString chartTitle(const KLineData& klineData, const KLines& history);
+    static QString reviewChartTitle(const KLineData& klineData);
+    void hideChartPreview();
+    void updateStallWatchdog(); //проверка задержек только когда окно на экране и активно
+    bool isKLineAccepted(const KLineData& klineData) const;
+    void applyLocalFilter();
+    void showChart(quint64 id, const KLineData& klineData);
+    void showReviewChart(quint64 id, const KLineData& klineData);
+    const KLineIndicators* indicators(IndicatorCache& cache, quint64 id, const KLines& history);
+
+    MemoryUsage memoryUsage() const;
+    void updateCacheLimits(); //пределы кешей по бюджету памяти
+    qsizetype cachesSize() const; //байт в кешах изображений и линий индикаторов
+    void enforceMemoryBudget();
 
-    void sendLogin(const QString& user, const QString& password);
-    void parseLogin(const QByteArray& data);
-
-    void sendGetKLines();
-    void parseKLines(const QByteArray& data);
-
-    void sendGetData();
-    void parseData(const QByteArray& data);
-    void parseMessage(const QJsonArray& messages);
-
-    void sendConfig();
-    void parseConfig(const QByteArray& data);
-
-    void sendNewUser(const QString& user, const QString& password);
-    void parseNewUser(const QByteArray& data);
-
-    void addKLines(const QJsonArray& jsonKLineList);
-    void addKLine(const QJsonObject& jsonKLine);
-    void showChart(const KLineData& klineData);
-    void showReviewChart(const KLineData& klineData);
-
-    void sendHTTPRequest(const QUrl& url, HTTPRequstType type, const QByteArray& data);
     void showRemovePushButton();
 
 private:
@@ -128,27 +160,54 @@ private:
 
     LocalConfig _localCnf;
 
-    Common::HTTPSQuery::Headers _headers; //заголовок HTTP запроса к серверу
-
-    RequestInfo _sentHTTPRequest; //информация о текущих запросах
+    Session *_session = nullptr; //вход, синхронизация фильтра и получение событий
 
     QHash<quint64, KLineData*> _klines; //список отфильтрованных свечей поступивших от сервера
-    Filter _filter; //текущий фильтр
+    FilterModel *_filterModel = nullptr; //модель таблицы фильтра
+    FilterDelegate *_filterDelegate = nullptr; //редактор ячеек таблицы фильтра
+    FilterMatcher _filterMatcher; //скомпилированный фильтр для локальной фильтрации событий
+    SpikeDetector _spikeDetector; //локальный поиск событий по свечам из историй полученных событий
 
-    quint32 _getErrorHTTPCount = 0; //поличество подряд идущих запросов к серверу закончившихся ошибкой
+    KLineChartView *_chartView = nullptr;
+    KLineChartWidget *_longChartWidget = nullptr; //график для длинной истории
+    KLineType _chartInterval = KLineType::UNKNOW; //интервал графика истории. UNKNOW - интервал события
 
-    ExistsStockExchange _existKLines; // список существующих монет
+    KLineChartView *_reviewChartView = nullptr;
+    KLineChartWidget *_reviewLongChartWidget = nullptr; //график для длинной истории
 
-    QCandlestickSeries *_series = nullptr;
-    QCandlestickSeries *_seriesVolume = nullptr;
-    QChartView *_chartView = nullptr;
+    KLineIndicators::Type _indicatorType = KLineIndicators::Type::NONE; //индикатор, рисуемый на графиках
+    IndicatorCache _indicatorCache; //рассчитанные линии индикатора по id события
+    IndicatorCache _reviewIndicatorCache;
 
-    QCandlestickSeries *_reviewSeries = nullptr;
-    QCandlestickSeries *_reviewSeriesVolume = nullptr;
-    QChartView *_reviewChartView = nullptr;
+    EventLog *_eventLog = nullptr; //сохраненные события для восстановления после перезагрузки
+    KLineStoreCache *_klineStoreCache = nullptr; //накопленная история свечей по инструментам (только нативная сборка)
+    QList<KLineData*> _pendingKLines; //разобранные события, ожидающие добавления в список
+    QTimer *_frameTimer = nullptr; //применяет накопленные изменения GUI не чаще одного раза за кадр
 
     quint64 _lastIDKLine = 0;
-
-    int _sessionID = 0;
+    quint64 _currentChartID = 0; //событие, графики которого показаны
+    quint64 _pendingChartID = 0; //событие, графики которого нужно показать в следующем кадре
+    QHash<quint64, quint32> _eventViews; //количество просмотров графиков события, для выбора вытесняемых событий
+
+    QCache<quint64, ChartImages> _chartImageCache; //LRU кеш заранее нарисованных графиков
+    QList<quint64> _preRenderQueue; //события, графики которых нужно нарисовать в свободное время
+    QTimer *_preRenderTimer = nullptr;
+    quint64 _preRenderID = 0; //событие, графики которого рисуются сейчас
+    ChartImages *_preRenderImages = nullptr; //уже нарисованные изображения события _preRenderID
+    PreRenderStep _preRenderStep = PreRenderStep::HISTORY;
+    KLineChartView *_previewChartView = nullptr; //невидимые графики QtCharts для изображений предпросмотра
+    KLineChartView *_reviewPreviewChartView = nullptr;
+    QLabel *_chartPreviewLabel = nullptr;
+    QLabel *_reviewChartPreviewLabel = nullptr;
+    QSize _chartImageSize; //размер графиков, под который нарисованы изображения в кеше
+    QSize _reviewChartImageSize;
+
+    QTimer *_diagnosticsTimer = nullptr; //обновление вкладки Diagnostics
+    StallWatchdog *_stallWatchdog = nullptr; //задержки цикла событий по обработчикам
+    quint64 _droppedReviewCount = 0; //обзорных историй удалено из-за ограничения памяти
+    quint64 _droppedEventCount = 0; //событий удалено из-за ограничения памяти
+
+    QElapsedTimer _startupTimer; //время от создания окна, для измерения скорости запуска
+    bool _isFirstFrameShown = false;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,277 @@
+//STL
+#include <algorithm>
+#include <limits>
+
+//Qt
+#include <QDir>
+
+#ifdef Q_OS_UNIX
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include "mappedklinestore.h"
+
+static const quint32 HEADER_MAGIC = 0x544B4C43; //"TKLC"
+static const quint32 HEADER_VERSION = 1;
+static const qint64 INITIAL_CAPACITY = 4096; //свечей
+static const qint64 VALUE_SIZE = 8; //размер значения любого столбца
+
+static const char* COLUMN_FILE_NAMES[] = {"open_time", "close_time", "open", "high", "low", "close", "volume", "quote_asset_volume"};
+
+//записывает измененные страницы на диск до обновления счетчика свечей
+static void syncMapped(uchar *data, qint64 offset, qint64 size)
+{
+#ifdef Q_OS_UNIX
+    static const qint64 pageSize = sysconf(_SC_PAGESIZE);
+
+    const auto begin = offset / pageSize * pageSize;
+    ::msync(data + begin, static_cast<size_t>(offset + size - begin), MS_SYNC);
+#else
+    Q_UNUSED(data);
+    Q_UNUSED(offset);
+    Q_UNUSED(size);
+#endif
+}
+
+MappedKLineStore::MappedKLineStore(const QString &rootDirName, const StockExchangeID &stockExchangeID, const KLineID &id)
+    : _dirName(QString("%1/%2_%3_%4").arg(rootDirName).arg(stockExchangeID.name).arg(id.symbol).arg(KLineTypeToString(id.type)))
+    , _id(id)
+{
+}
+
+MappedKLineStore::~MappedKLineStore()
+{
+    //QFile::close() снимает отображение
+    _headerFile.close();
+    for (auto& file: _files)
+    {
+        file.close();
+    }
+}
+
+bool MappedKLineStore::open()
+{
+    if (!QDir().mkpath(_dirName))
+    {
+        _errorString = QString("Cannot create directory %1").arg(_dirName);
+
+        return false;
+    }
+
+    //заголовок
+    _headerFile.setFileName(_dirName + "/header");
+    if (!_headerFile.open(QIODevice::ReadWrite))
+    {
+        _errorString = QString("Cannot open %1: %2").arg(_headerFile.fileName()).arg(_headerFile.errorString());
+
+        return false;
+    }
+
+    const bool isNew = _headerFile.size() < static_cast<qint64>(sizeof(Header));
+    if (isNew && !_headerFile.resize(sizeof(Header)))
+    {
+        _errorString = QString("Cannot resize %1: %2").arg(_headerFile.fileName()).arg(_headerFile.errorString());
+
+        return false;
+    }
+
+    _header = reinterpret_cast<Header*>(_headerFile.map(0, sizeof(Header)));
+    if (_header == nullptr)
+    {
+        _errorString = QString("Cannot map %1: %2").arg(_headerFile.fileName()).arg(_headerFile.errorString());
+
+        return false;
+    }
+
+    if (isNew)
+    {
+        _header->magic = HEADER_MAGIC;
+        _header->version = HEADER_VERSION;
+        _header->count = 0;
+    }
+    else if (_header->magic != HEADER_MAGIC || _header->version != HEADER_VERSION)
+    {
+        _errorString = QString("Unsupported candle store format: %1").arg(_dirName);
+
+        return false;
+    }
+
+    //столбцы
+    _capacity = std::numeric_limits<qint64>::max();
+    for (int column = 0; column < Column::COUNT; ++column)
+    {
+        auto& file = _files[column];
+        file.setFileName(_dirName + "/" + COLUMN_FILE_NAMES[column]);
+        if (!file.open(QIODevice::ReadWrite))
+        {
+            _errorString = QString("Cannot open %1: %2").arg(file.fileName()).arg(file.errorString());
+
+            return false;
+        }
+
+        _capacity = std::min(_capacity, file.size() / VALUE_SIZE);
+    }
+
+    //файлы столбцов короче, чем указано в заголовке - учитываем только целые свечи
+    if (_header->count > _capacity)
+    {
+        _header->count = _capacity;
+    }
+
+    const auto capacity = std::max(_capacity, INITIAL_CAPACITY);
+    _capacity = 0;
+
+    return reserve(capacity);
+}
+
+const QString &MappedKLineStore::errorString() const
+{
+    return _errorString;
+}
+
+const KLineID &MappedKLineStore::id() const
+{
+    return _id;
+}
+
+qsizetype MappedKLineStore::append(const KLines &klines)
+{
+    Q_CHECK_PTR(_header);
+
+    const auto count = _header->count;
+    const auto lastOpenTime = count > 0 ? column<const qint64>(Column::OPEN_TIME)[count - 1] : std::numeric_limits<qint64>::min();
+
+    //история события идет от новых свечей к старым - выбираем новые и последнюю сохраненную
+    //(незакрытая свеча обновляется на месте) и сортируем по времени
+    QList<const KLine*> newKLines;
+    for (const auto& kline: klines)
+    {
+        if (kline.openTime.toMSecsSinceEpoch() >= lastOpenTime)
+        {
+            newKLines.push_back(&kline);
+        }
+    }
+
+    if (newKLines.isEmpty())
+    {
+        return 0;
+    }
+
+    //одна свеча в нескольких историях - остается версия, полученная последней
+    std::stable_sort(newKLines.begin(), newKLines.end(),
+                     [](const KLine* kline1, const KLine* kline2){ return kline1->openTime < kline2->openTime; });
+    const auto uniqueEnd = std::unique(newKLines.rbegin(), newKLines.rend(),
+                                       [](const KLine* kline1, const KLine* kline2){ return kline1->openTime == kline2->openTime; });
+    newKLines.erase(newKLines.begin(), uniqueEnd.base());
+
+    //первая свеча совпадает с последней сохраненной - перезаписываем ее строку
+    const auto first = newKLines.first()->openTime.toMSecsSinceEpoch() == lastOpenTime ? count - 1 : count;
+
+    if (!reserve(first + newKLines.size()))
+    {
+        return 0;
+    }
+
+    auto openTime = column<qint64>(Column::OPEN_TIME) + first;
+    auto closeTime = column<qint64>(Column::CLOSE_TIME) + first;
+    auto open = column<double>(Column::OPEN) + first;
+    auto high = column<double>(Column::HIGH) + first;
+    auto low = column<double>(Column::LOW) + first;
+    auto close = column<double>(Column::CLOSE) + first;
+    auto volume = column<double>(Column::VOLUME) + first;
+    auto quoteAssetVolume = column<double>(Column::QUOTE_ASSET_VOLUME) + first;
+
+    for (qsizetype i = 0; i < newKLines.size(); ++i)
+    {
+        const auto kline = newKLines.at(i);
+        openTime[i] = kline->openTime.toMSecsSinceEpoch();
+        closeTime[i] = kline->closeTime.toMSecsSinceEpoch();
+        open[i] = kline->open;
+        high[i] = kline->high;
+        low[i] = kline->low;
+        close[i] = kline->close;
+        volume[i] = kline->volume;
+        quoteAssetVolume[i] = kline->quoteAssetVolume;
+    }
+
+    //сначала данные, затем счетчик: после сбоя заголовок не ссылается на недописанные свечи
+    for (auto data: _data)
+    {
+        syncMapped(data, first * VALUE_SIZE, newKLines.size() * VALUE_SIZE);
+    }
+
+    //только перезапись последней свечи - счетчик не меняется
+    if (first + newKLines.size() != count)
+    {
+        _header->count = first + newKLines.size();
+        syncMapped(reinterpret_cast<uchar*>(_header), 0, sizeof(Header));
+    }
+
+    return newKLines.size();
+}
+
+KLineColumns MappedKLineStore::columns() const
+{
+    KLineColumns result;
+    if (_header == nullptr || std::find(_data.begin(), _data.end(), nullptr) != _data.end())
+    {
+        return result;
+    }
+
+    const auto count = static_cast<size_t>(_header->count);
+    result.openTime = std::span<const qint64>(column<const qint64>(Column::OPEN_TIME), count);
+    result.closeTime = std::span<const qint64>(column<const qint64>(Column::CLOSE_TIME), count);
+    result.open = std::span<const double>(column<const double>(Column::OPEN), count);
+    result.high = std::span<const double>(column<const double>(Column::HIGH), count);
+    result.low = std::span<const double>(column<const double>(Column::LOW), count);
+    result.close = std::span<const double>(column<const double>(Column::CLOSE), count);
+    result.volume = std::span<const double>(column<const double>(Column::VOLUME), count);
+    result.quoteAssetVolume = std::span<const double>(column<const double>(Column::QUOTE_ASSET_VOLUME), count);
+
+    return result;
+}
+
+bool MappedKLineStore::reserve(qint64 count)
+{
+    if (count <= _capacity)
+    {
+        return true;
+    }
+
+    auto capacity = std::max(_capacity, INITIAL_CAPACITY);
+    while (capacity < count)
+    {
+        capacity *= 2;
+    }
+
+    //размер отображения фиксирован - при росте файла отображение создается заново
+    for (int column = 0; column < Column::COUNT; ++column)
+    {
+        auto& file = _files[column];
+        if (_data[column] != nullptr)
+        {
+            file.unmap(_data[column]);
+            _data[column] = nullptr;
+        }
+
+        if (file.size() < capacity * VALUE_SIZE && !file.resize(capacity * VALUE_SIZE))
+        {
+            _errorString = QString("Cannot resize %1: %2").arg(file.fileName()).arg(file.errorString());
+
+            return false;
+        }
+
+        _data[column] = file.map(0, capacity * VALUE_SIZE);
+        if (_data[column] == nullptr)
+        {
+            _errorString = QString("Cannot map %1: %2").arg(file.fileName()).arg(file.errorString());
+
+            return false;
+        }
+    }
+
+    _capacity = capacity;
+
+    return true;
+}
@@ -0,0 +1,76 @@
+#ifndef MAPPEDKLINESTORE_H
+#define MAPPEDKLINESTORE_H
+
+//STL
+#include <array>
+
+//Qt
+#include <QFile>
+#include <QString>
+
+#include "klinestore.h"
+
+//История свечей инструмента в файлах, отображенных в память. Каждый столбец - отдельный файл,
+//поэтому читатели получают непрерывные массивы без копирования, а вытеснение страниц выполняет ОС.
+//Количество свечей хранится в заголовке и обновляется после записи данных - при сбое
+//недописанные свечи просто не учитываются
+class MappedKLineStore final : public KLineStore
+{
+public:
+    MappedKLineStore(const QString& rootDirName, const StockExchangeID& stockExchangeID, const KLineID& id);
+    ~MappedKLineStore() override;
+
+    bool open();
+    const QString& errorString() const;
+
+    const KLineID& id() const override;
+    qsizetype append(const KLines& klines) override;
+    KLineColumns columns() const override;
+
+private:
+    Q_DISABLE_COPY_MOVE(MappedKLineStore)
+
+    enum Column: int
+    {
+        OPEN_TIME = 0,
+        CLOSE_TIME = 1,
+        OPEN = 2,
+        HIGH = 3,
+        LOW = 4,
+        CLOSE = 5,
+        VOLUME = 6,
+        QUOTE_ASSET_VOLUME = 7,
+        COUNT = 8
+    };
+
+    struct Header
+    {
+        quint32 magic = 0;
+        quint32 version = 0;
+        qint64 count = 0; //количество записанных свечей
+    };
+
+private:
+    bool reserve(qint64 count); //увеличивает файлы столбцов, чтобы в них поместилось count свечей
+
+    template <typename T>
+    T* column(Column column) const
+    {
+        return reinterpret_cast<T*>(_data[column]);
+    }
+
+private:
+    const QString _dirName;
+    const KLineID _id;
+
+    QFile _headerFile;
+    Header *_header = nullptr;
+
+    std::array<QFile, Column::COUNT> _files;
+    std::array<uchar*, Column::COUNT> _data{};
+    qint64 _capacity = 0; //количество свечей, помещающихся в отображенные файлы
+
+    QString _errorString;
+};
+
+#endif // MAPPEDKLINESTORE_H
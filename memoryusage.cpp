@@ -0,0 +1,80 @@
+#ifdef __EMSCRIPTEN__
+#include <emscripten/heap.h>
+#endif
+
+#include "memoryusage.h"
+
+static const qsizetype STRING_HEADER_SIZE = 32; //заголовок данных QString вместе с выравниванием аллокатора
+
+void MemoryUsage::add(Subsystem subsystem, qsizetype bytes)
+{
+    Q_ASSERT(subsystem != Subsystem::COUNT);
+
+    _bytes[static_cast<size_t>(subsystem)] += bytes;
+}
+
+qsizetype MemoryUsage::bytes(Subsystem subsystem) const
+{
+    Q_ASSERT(subsystem != Subsystem::COUNT);
+
+    return _bytes[static_cast<size_t>(subsystem)];
+}
+
+qsizetype MemoryUsage::total() const
+{
+    qsizetype result = 0;
+    for (const auto bytes: _bytes)
+    {
+        result += bytes;
+    }
+
+    return result;
+}
+
+QString MemoryUsage::subsystemToString(Subsystem subsystem)
+{
+    switch (subsystem)
+    {
+    case Subsystem::EVENTS: return "Event histories";
+    case Subsystem::REVIEW_HISTORY: return "Review histories";
+    case Subsystem::PENDING_EVENTS: return "Pending events";
+    case Subsystem::EVENT_LIST: return "Event list items";
+    case Subsystem::HTTP_RESULTS: return "HTTP results";
+    case Subsystem::CHART_SERIES: return "Chart series";
+    case Subsystem::CHART_IMAGES: return "Chart images";
+    case Subsystem::INDICATORS: return "Indicators";
+    case Subsystem::COUNT:
+    default:
+        Q_ASSERT(false);
+    }
+
+    return "Unknown";
+}
+
+qsizetype MemoryUsage::klinesSize(const KLines &klines)
+{
+    if (klines.isEmpty())
+    {
+        return klines.capacity() * sizeof(KLine);
+    }
+
+    //название монеты разбирается из JSON отдельно для каждой свечи
+    const auto symbolSize = STRING_HEADER_SIZE + klines.first().id.symbol.capacity() * static_cast<qsizetype>(sizeof(QChar));
+
+    return klines.capacity() * sizeof(KLine) + klines.size() * symbolSize;
+}
+
+qsizetype MemoryUsage::klineDataSize(const KLineData &klineData)
+{
+    return sizeof(KLineData) + STRING_HEADER_SIZE + klineData.stockExchangeID.name.capacity() * sizeof(QChar)
+           + klinesSize(klineData.history);
+}
+
+qsizetype MemoryUsage::heapSize()
+{
+#ifdef __EMSCRIPTEN__
+    return static_cast<qsizetype>(emscripten_get_heap_size());
+#else
+    return 0;
+#endif
+}
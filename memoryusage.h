@@ -0,0 +1,45 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+//STL
+#include <array>
+
+//Qt
+#include <QString>
+
+#include "types.h"
+
+//Учет памяти по подсистемам клиента. Размеры оцениваются по содержимому контейнеров,
+//накладные расходы аллокатора не учитываются
+class MemoryUsage
+{
+public:
+    enum class Subsystem: quint8
+    {
+        EVENTS = 0,         //истории событий в списке
+        REVIEW_HISTORY = 1, //обзорные истории событий в списке
+        PENDING_EVENTS = 2, //события, ожидающие добавления в список
+        EVENT_LIST = 3,     //элементы списка событий
+        HTTP_RESULTS = 4,   //ответы и ошибки HTTP, еще не забранные запросами
+        CHART_SERIES = 5,   //наборы свечей и точки индикаторов QtCharts
+        CHART_IMAGES = 6,   //кеш заранее нарисованных графиков
+        INDICATORS = 7,     //кеш рассчитанных индикаторов
+        COUNT = 8
+    };
+
+public:
+    void add(Subsystem subsystem, qsizetype bytes);
+    qsizetype bytes(Subsystem subsystem) const;
+    qsizetype total() const;
+
+    static QString subsystemToString(Subsystem subsystem);
+
+    static qsizetype klinesSize(const KLines& klines);
+    static qsizetype klineDataSize(const KLineData& klineData); //без обзорной истории
+    static qsizetype heapSize(); //текущий размер кучи WASM. 0 - нативная сборка
+
+private:
+    std::array<qsizetype, static_cast<size_t>(Subsystem::COUNT)> _bytes = {};
+};
+
+#endif // MEMORYUSAGE_H
@@ -0,0 +1,650 @@
+//STL
+#include <algorithm>
+#include <optional>
+
+//Qt
+#include <QDebug>
+#include <QUrl>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QRandomGenerator64>
+
+#include "tracer.h"
+#include "stallwatchdog.h"
+
+#include "session.h"
+
+using namespace Common;
+
+static const quint64 SEND_INTERVAL = 5000;
+static const quint64 CONFIG_SEND_DELAY = 1000; //ms задержка отправки изменений фильтра после последней правки
+static const quint64 MAX_CONFIG_RETRY_DELAY = 60000; //ms предел задержки повторной отправки отклоненного фильтра
+static const quint32 MAX_ERROR_COUNT = 10; //ошибок подряд до повторного входа
+
+Session::Session(const QString &serverURL, QObject *parent)
+    : QObject{parent}
+    , _serverURL(serverURL)
+{
+    _headers.insert(QByteArray{"Content-Type"}, QByteArray{"application/json"});
+
+    _configTimer = new QTimer(this);
+    _configTimer->setSingleShot(true);
+    _configTimer->setInterval(CONFIG_SEND_DELAY);
+    QObject::connect(_configTimer, SIGNAL(timeout()), SLOT(configTimer_timeout()));
+
+    _dataParser = new DataParser(this);
+}
+
+Session::~Session()
+{
+    for (const auto& request: _sentHTTPRequest)
+    {
+        delete request.HTTPSQuery;
+    }
+
+    delete _dataParser;
+}
+
+void Session::start(const QString &user, const QString &password)
+{
+    _user = user;
+    _password = password;
+
+    login();
+}
+
+Session::State Session::state() const
+{
+    return _state;
+}
+
+bool Session::isOnline() const
+{
+    return _state == State::ONLINE;
+}
+
+int Session::sessionID() const
+{
+    return _sessionID;
+}
+
+const QString &Session::user() const
+{
+    return _user;
+}
+
+const QString &Session::password() const
+{
+    return _password;
+}
+
+const ExistsStockExchange &Session::catalog() const
+{
+    return _existKLines;
+}
+
+void Session::applyCatalog(const QJsonArray &klinesJson)
+{
+    _existKLines.clear();
+
+    for (int i = 0; i < klinesJson.count(); ++i)
+    {
+        const auto jsonKlines = klinesJson[i].toObject();
+
+        auto& currentMoney = _existKLines[jsonKlines["StockExchange"].toString()][jsonKlines["Money"].toString()];
+        currentMoney.insert(jsonKlines["Interval"].toString());
+    }
+}
+
+const Filter &Session::filter() const
+{
+    return _filter;
+}
+
+void Session::setFilter(const Filter &filter)
+{
+    _filter = filter;
+    ++_filterVersion;
+
+    if (isOnline())
+    {
+        _configTimer->start(CONFIG_SEND_DELAY);
+    }
+}
+
+void Session::flushConfig()
+{
+    if (!isOnline())
+    {
+        return;
+    }
+
+    _configTimer->stop();
+
+    sendConfig();
+}
+
+void Session::holdDataPoll()
+{
+    _isDataPollHeld = true;
+}
+
+void Session::releaseDataPoll()
+{
+    _isDataPollHeld = false;
+
+    if (_isDataPollDelayed)
+    {
+        _isDataPollDelayed = false;
+
+        QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendGetData(); });
+    }
+}
+
+void Session::setParserPool(QThreadPool *pool)
+{
+    Q_ASSERT(_dataParser->inProgressCount() == 0);
+
+    delete _dataParser;
+
+    _dataParser = new DataParser(this, pool);
+}
+
+QString Session::requestTypeName(HTTPRequstType type)
+{
+    switch (type)
+    {
+    case HTTPRequstType::LOGIN: return "login";
+    case HTTPRequstType::KLINES: return "klines";
+    case HTTPRequstType::CONFIG: return "config";
+    case HTTPRequstType::NEWUSER: return "newuser";
+    case HTTPRequstType::DATA: return "data";
+    default:
+        break;
+    }
+
+    return "unknown";
+}
+
+void Session::configTimer_timeout()
+{
+    HANDLER_SCOPE("Session::configTimer_timeout");
+
+    sendConfig();
+}
+
+void Session::login()
+{
+    if (_user.isEmpty() || _password.isEmpty())
+    {
+        makeCredentials();
+
+        sendNewUser();
+    }
+    else
+    {
+        sendLogin();
+    }
+}
+
+void Session::makeCredentials()
+{
+    _user = QString::number(QRandomGenerator64::global()->generate64());
+    _password = QString::number(QRandomGenerator64::global()->generate64());
+
+    emit credentialsChanged(_user, _password);
+}
+
+void Session::sendLogin()
+{
+    _state = State::LOGIN;
+
+    const QString url = QString("%1/login/%2/%3")
+                            .arg(_serverURL)
+                            .arg(_user.toUtf8().toBase64(QByteArray::Base64Encoding))
+                            .arg(_password.toUtf8().toBase64(QByteArray::Base64Encoding));
+
+    sendHTTPRequest(url, HTTPRequstType::LOGIN, QByteArray());
+}
+
+void Session::parseLogin(const QByteArray &data)
+{
+    TRACE_SPAN("Session::parseLogin");
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        qDebug() << "LOGIN: Error parsing json: " << error.errorString();
+        Q_ASSERT(false);
+
+        return;
+    }
+
+    const auto json = doc.object();
+    if (json["Result"] == "OK")
+    {
+        _sessionID = json["SessionID"].toInt(0);
+        _state = State::ONLINE;
+
+        _filter.fromJSON(json["Filter"].toArray());
+        if (_filter.isError())
+        {
+            qDebug() << _filter.errorString();
+        }
+
+        _serverFilter = _filter;
+        _isServerFilterSynced = true;
+        _sentFilterVersion = _filterVersion;
+
+        //изменения фильтра (FilterDiff) принимает только сервер, объявивший их поддержку при входе
+        _isFilterDiffSupported = json["FilterDiff"].toBool(false);
+
+        emit loggedIn();
+        emit serverFilterChanged(_serverFilter.toJSON());
+
+        //события не зависят от каталога монет - запрашиваем их сразу, параллельно с /klines
+        QTimer::singleShot(1, this, [this](){ sendGetKLines(); });
+        QTimer::singleShot(1, this, [this](){ sendGetData(); });
+    }
+    else
+    {
+        qDebug() << "LOGIN:" << json["Message"].toString();
+        QTimer::singleShot(1, this, [this](){ login(); });
+    }
+}
+
+void Session::sendGetKLines()
+{
+    const QString url = QString("%1/klines/%2").arg(_serverURL).arg(_sessionID);
+
+    sendHTTPRequest(url, HTTPRequstType::KLINES, QByteArray());
+}
+
+void Session::parseKLines(const QByteArray &data)
+{
+    TRACE_SPAN("Session::parseKLines");
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        qDebug() << "KLINE: Error parsing json: " << error.errorString();
+        Q_ASSERT(false);
+
+        return;
+    }
+
+    const auto json = doc.object();
+    if (json["Result"].toString() != "OK")
+    {
+        qDebug() << "KLINE:" << json["Message"].toString();
+
+        return;
+    }
+
+    const auto KLineArrayJson = json["KLines"].toArray();
+    applyCatalog(KLineArrayJson);
+
+    emit catalogReceived(KLineArrayJson);
+}
+
+void Session::sendGetData()
+{
+    const QString url = QString("%1/data/%2").arg(_serverURL).arg(_sessionID);
+
+    sendHTTPRequest(url, HTTPRequstType::DATA, QByteArray());
+}
+
+void Session::parseData(const QByteArray &data)
+{
+    TRACE_SPAN("Session::parseData");
+
+    _dataParser->parse(data, [this](DataParser::Result&& result){ applyData(std::move(result)); });
+}
+
+void Session::applyData(DataParser::Result &&result)
+{
+    HANDLER_SCOPE("Session::applyData");
+
+    switch (result.status)
+    {
+    case DataParser::Status::OK:
+    {
+        if (!result.klines.isEmpty())
+        {
+            emit eventsReceived(result.klines);
+        }
+
+        if (!result.infoMessages.isEmpty())
+        {
+            emit messagesReceived(result.infoMessages);
+        }
+
+        //получатель не успевает обрабатывать события - следующий запрос отправим после releaseDataPoll()
+        if (_isDataPollHeld)
+        {
+            _isDataPollDelayed = true;
+        }
+        else
+        {
+            QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendGetData(); });
+        }
+
+        break;
+    }
+    case DataParser::Status::LOGOUT:
+        qDebug() << "DATA LOGOUT:" << result.message;
+
+        _state = State::LOGIN;
+
+        QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendLogin(); });
+        break;
+    case DataParser::Status::SERVER_ERROR:
+        qDebug() << "DATA:" << result.message;
+        break;
+    case DataParser::Status::PARSE_ERROR:
+        qDebug() << "DATA: Error parsing json: " << result.message;
+        Q_ASSERT(false);
+        break;
+    default:
+        Q_ASSERT(false);
+        break;
+    }
+}
+
+void Session::sendConfig()
+{
+    if (_isConfigSending)
+    {
+        //изменения будут отправлены после ответа на текущий запрос
+        return;
+    }
+
+    if (_isServerFilterSynced && _filterVersion == _sentFilterVersion)
+    {
+        return;
+    }
+
+    std::optional<Filter::FilterDiff> filterDiff;
+    if (_isServerFilterSynced)
+    {
+        filterDiff = _serverFilter.diff(_filter);
+        if (filterDiff.has_value() && filterDiff->isEmpty())
+        {
+            _sentFilterVersion = _filterVersion;
+
+            return;
+        }
+    }
+
+    //сервер без поддержки FilterDiff прочитал бы отсутствующий Filter как пустой и удалил правила пользователя
+    QJsonObject json;
+    if (filterDiff.has_value() && _isFilterDiffSupported)
+    {
+        json.insert("FilterDiff", filterDiff->toJSON());
+    }
+    else
+    {
+        json.insert("Filter", _filter.toJSON());
+    }
+
+    _sendingFilter = _filter;
+    _sentFilterVersion = _filterVersion;
+    _isConfigSending = true;
+
+    const QString url = QString("%1/config/%2").arg(_serverURL).arg(_sessionID);
+
+    sendHTTPRequest(url, HTTPRequstType::CONFIG, QJsonDocument(json).toJson(QJsonDocument::Compact));
+}
+
+void Session::parseConfig(const QByteArray &data)
+{
+    TRACE_SPAN("Session::parseConfig");
+
+    _isConfigSending = false;
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        qDebug() << "CONFIG: Error parsing json: " << error.errorString();
+        Q_ASSERT(false);
+
+        _isServerFilterSynced = false;
+        retryConfig();
+
+        return;
+    }
+
+    const auto json = doc.object();
+    if (json["Result"].toString() != "OK")
+    {
+        qDebug() << "CONFIG:" << json["Message"].toString();
+
+        _isServerFilterSynced = false;
+        retryConfig();
+
+        return;
+    }
+    else
+    {
+        qDebug() << "CONFIG: configuration applied successfully";
+    }
+
+    _serverFilter = _sendingFilter;
+    _isServerFilterSynced = true;
+    _configRejectCount = 0;
+
+    emit serverFilterChanged(_serverFilter.toJSON());
+
+    //пока запрос был в пути фильтр могли изменить
+    if (_filterVersion != _sentFilterVersion)
+    {
+        _configTimer->start(CONFIG_SEND_DELAY);
+    }
+}
+
+void Session::retryConfig()
+{
+    //сервер отклоняет фильтр - повторяем с удвоением задержки, а не каждую секунду
+    const auto delay = std::min(CONFIG_SEND_DELAY << std::min<quint32>(_configRejectCount, 6), MAX_CONFIG_RETRY_DELAY);
+    ++_configRejectCount;
+
+    _configTimer->start(delay);
+}
+
+void Session::sendNewUser()
+{
+    _state = State::NEWUSER;
+
+    const QString url = QString("%1/newuser/%2/%3")
+                            .arg(_serverURL)
+                            .arg(_user.toUtf8().toBase64(QByteArray::Base64Encoding))
+                            .arg(_password.toUtf8().toBase64(QByteArray::Base64Encoding));
+
+    sendHTTPRequest(url, HTTPRequstType::NEWUSER, QByteArray());
+}
+
+void Session::parseNewUser(const QByteArray &data)
+{
+    TRACE_SPAN("Session::parseNewUser");
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(data, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        qDebug() << "NEW USER: Error parsing json: " << error.errorString();
+        Q_ASSERT(false);
+
+        return;
+    }
+
+    const auto json = doc.object();
+    if (json["Result"].toString() != "OK")
+    {
+        qDebug() << "NEW USER:" << json["Message"].toString();
+
+        makeCredentials();
+
+        sendNewUser();
+    }
+    else
+    {
+        qDebug() << "NEW USER: user added successfully";
+
+        sendLogin();
+    }
+}
+
+void Session::getAnswerHttp(const QByteArray &answer, int id)
+{
+    const auto sendHTTPRequest_it = _sentHTTPRequest.find(id);
+    if (sendHTTPRequest_it == _sentHTTPRequest.end())
+    {
+        qDebug() << "GET ANSWER UNDEFINE REQUEST WITH ID:" << id;
+
+        return;
+    }
+
+    emit requestFinished(sendHTTPRequest_it.value().type, sendHTTPRequest_it.value().sendTime.nsecsElapsed() / 1000, false);
+
+    HANDLER_SCOPE(answerHandlerName(sendHTTPRequest_it.value().type));
+
+    switch (sendHTTPRequest_it.value().type)
+    {
+    case HTTPRequstType::LOGIN:
+        parseLogin(answer);
+        break;
+    case HTTPRequstType::KLINES:
+        parseKLines(answer);
+        break;
+    case HTTPRequstType::DATA:
+        parseData(answer);
+        break;
+    case HTTPRequstType::CONFIG:
+        parseConfig(answer);
+        break;
+    case HTTPRequstType::NEWUSER:
+        parseNewUser(answer);
+        break;
+    default:
+        Q_ASSERT(false);
+        break;
+    }
+
+    delete sendHTTPRequest_it.value().HTTPSQuery;
+
+    _sentHTTPRequest.erase(sendHTTPRequest_it);
+
+    _getErrorHTTPCount= 0;
+}
+
+void Session::errorOccurredHttp(quint32 code, const QString &msg, int id)
+{
+    HANDLER_SCOPE("Session::errorOccurredHttp");
+
+    const auto sendHTTPRequest_it = _sentHTTPRequest.find(id);
+    if (sendHTTPRequest_it == _sentHTTPRequest.end())
+    {
+        qDebug() << "ERROR UNDEFINE REQUEST WITH ID:" << id;
+
+        return;
+    }
+
+    emit requestFinished(sendHTTPRequest_it.value().type, sendHTTPRequest_it.value().sendTime.nsecsElapsed() / 1000, true);
+
+    if (sendHTTPRequest_it.value().type == HTTPRequstType::CONFIG)
+    {
+        //неизвестно, применил ли сервер изменения - в следующий раз отправляем фильтр целиком
+        _isConfigSending = false;
+        _isServerFilterSynced = false;
+    }
+
+    if (_getErrorHTTPCount > MAX_ERROR_COUNT)
+    {
+        qDebug() << "SERVER ERROR. Relogin";
+
+        if (sendHTTPRequest_it.value().type == HTTPRequstType::NEWUSER)
+        {
+            QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendNewUser(); });
+        }
+        else
+        {
+            _state = State::LOGIN;
+
+            QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendLogin(); });
+        }
+
+        _getErrorHTTPCount = 0;
+
+        delete sendHTTPRequest_it.value().HTTPSQuery;
+
+        _sentHTTPRequest.erase(sendHTTPRequest_it);
+
+        emit connectionLost();
+
+        return;
+    }
+
+    switch (sendHTTPRequest_it.value().type)
+    {
+    case HTTPRequstType::LOGIN:
+        QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendLogin(); });
+        break;
+    case HTTPRequstType::KLINES:
+        QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendGetKLines(); });
+        break;
+    case HTTPRequstType::DATA:
+        QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendGetData(); });
+        break;
+    case HTTPRequstType::CONFIG:
+        QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendConfig(); });
+        break;
+    case HTTPRequstType::NEWUSER:
+        QTimer::singleShot(SEND_INTERVAL, this, [this](){ sendNewUser(); });
+        break;
+    default:
+        Q_ASSERT(false);
+        break;
+    }
+
+    delete sendHTTPRequest_it.value().HTTPSQuery;
+
+    _sentHTTPRequest.erase(sendHTTPRequest_it);
+
+    ++_getErrorHTTPCount;
+}
+
+void Session::sendHTTPRequest(const QUrl &url, HTTPRequstType type, const QByteArray& data)
+{
+    RequestData request;
+    request.HTTPSQuery = new HTTPSQuery();
+    request.type = type;
+    request.sendTime.start();
+
+    QObject::connect(request.HTTPSQuery, SIGNAL(getAnswer(const QByteArray&, int)),
+                     SLOT(getAnswerHttp(const QByteArray&, int)));
+    QObject::connect(request.HTTPSQuery, SIGNAL(errorOccurred(quint32, const QString&, int)),
+                     SLOT(errorOccurredHttp(quint32, const QString&, int)));
+
+    _sentHTTPRequest.insert(request.HTTPSQuery->send(url, _headers, data), request);
+}
+
+const char *Session::answerHandlerName(HTTPRequstType type)
+{
+    switch (type)
+    {
+    case HTTPRequstType::LOGIN: return "Session::getAnswerHttp LOGIN";
+    case HTTPRequstType::KLINES: return "Session::getAnswerHttp KLINES";
+    case HTTPRequstType::CONFIG: return "Session::getAnswerHttp CONFIG";
+    case HTTPRequstType::NEWUSER: return "Session::getAnswerHttp NEWUSER";
+    case HTTPRequstType::DATA: return "Session::getAnswerHttp DATA";
+    case HTTPRequstType::NONE:
+    default:
+        break;
+    }
+
+    return "Session::getAnswerHttp";
+}
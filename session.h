@@ -0,0 +1,152 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+//Qt
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QThreadPool>
+#include <QJsonArray>
+
+#include "httpsquery.h"
+#include "types.h"
+#include "filter.h"
+#include "dataparser.h"
+
+//Сеанс работы с сервером: регистрация, вход, каталог монет, синхронизация фильтра и опрос событий.
+//Не зависит от виджетов - окно клиента и консольные клиенты подписываются на сигналы
+class Session : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum class State: quint8
+    {
+        DISCONNECTED = 0, //вход не выполнялся
+        NEWUSER = 1,      //регистрация нового пользователя
+        LOGIN = 2,        //ожидание ответа на вход
+        ONLINE = 3        //вход выполнен, идет опрос событий
+    };
+
+    enum class HTTPRequstType: quint8
+    {
+        NONE = 0,
+        LOGIN = 1,
+        KLINES = 2,
+        CONFIG = 3,
+        NEWUSER = 4,
+        DATA = 5
+    };
+
+public:
+    explicit Session(const QString& serverURL, QObject *parent = nullptr);
+    ~Session();
+
+    void start(const QString& user, const QString& password); //пустой user или password - регистрация нового пользователя
+
+    State state() const;
+    bool isOnline() const;
+    int sessionID() const;
+    const QString& user() const;
+    const QString& password() const;
+
+    const ExistsStockExchange& catalog() const; //список существующих монет
+    void applyCatalog(const QJsonArray& klinesJson); //заменяет каталог без сигналов (сохраненный каталог)
+
+    const Filter& filter() const; //текущий фильтр пользователя
+    void setFilter(const Filter& filter); //изменения отправляются на сервер с задержкой
+    void flushConfig(); //отправляет изменения фильтра не дожидаясь задержки
+
+    void holdDataPoll(); //получатель не успевает обрабатывать события - следующий /data ждет releaseDataPoll()
+    void releaseDataPoll();
+
+    void setParserPool(QThreadPool *pool); //общий пул разбора /data для многих сеансов в одном процессе, вызывается до start()
+
+    static QString requestTypeName(HTTPRequstType type); //имя метода сервера: login, data, ...
+
+signals:
+    void credentialsChanged(const QString& user, const QString& password); //сгенерирован новый пользователь
+    void loggedIn(); //фильтр сервера доступен через filter()
+    void catalogReceived(const QJsonArray& klinesJson); //каталог обновлен сервером
+    void serverFilterChanged(const QJsonArray& filterJson); //фильтр подтвержден сервером
+    void eventsReceived(const QList<KLineData>& klines);
+    void messagesReceived(const QStringList& messages);
+    void connectionLost(); //много ошибок подряд, выполняется повторный вход
+    void requestFinished(Session::HTTPRequstType type, qint64 latency, bool isError); //latency - мкс от отправки до ответа
+
+private slots:
+    void getAnswerHttp(const QByteArray& answer, int id);
+    void errorOccurredHttp(quint32 code, const QString& msg, int id);
+    void configTimer_timeout();
+
+private:
+    struct RequestData
+    {
+        HTTPRequstType type = HTTPRequstType::NONE;
+        Common::HTTPSQuery *HTTPSQuery = nullptr;
+        QElapsedTimer sendTime; //время от отправки до ответа
+    };
+
+    using RequestInfo = QHash<int, RequestData>;
+
+private:
+    Q_DISABLE_COPY_MOVE(Session)
+
+    void login();
+    void makeCredentials();
+
+    void sendLogin();
+    void parseLogin(const QByteArray& data);
+
+    void sendGetKLines();
+    void parseKLines(const QByteArray& data);
+
+    void sendGetData();
+    void parseData(const QByteArray& data);
+    void applyData(DataParser::Result&& result);
+
+    void sendConfig();
+    void parseConfig(const QByteArray& data);
+    void retryConfig(); //повторная отправка отклоненного фильтра с растущей задержкой
+
+    void sendNewUser();
+    void parseNewUser(const QByteArray& data);
+
+    void sendHTTPRequest(const QUrl& url, HTTPRequstType type, const QByteArray& data);
+    static const char* answerHandlerName(HTTPRequstType type); //имя обработчика ответа для StallWatchdog
+
+private:
+    const QString _serverURL;
+
+    State _state = State::DISCONNECTED;
+    QString _user;
+    QString _password;
+    int _sessionID = 0;
+
+    Common::HTTPSQuery::Headers _headers; //заголовок HTTP запроса к серверу
+    RequestInfo _sentHTTPRequest; //информация о текущих запросах
+    quint32 _getErrorHTTPCount = 0; //поличество подряд идущих запросов к серверу закончившихся ошибкой
+
+    ExistsStockExchange _existKLines; // список существующих монет
+
+    Filter _filter; //текущий фильтр
+    quint64 _filterVersion = 0; //номер изменения фильтра
+    Filter _serverFilter; //фильтр, примененный на сервере
+    Filter _sendingFilter; //фильтр, отправленный на сервер и ожидающий подтверждения
+    bool _isServerFilterSynced = false; //false - при следующей отправке передается фильтр целиком
+    bool _isConfigSending = false; //запрос CONFIG уже отправлен и ожидает ответа
+    bool _isFilterDiffSupported = false; //сервер принимает FilterDiff (флаг из ответа /login)
+    quint32 _configRejectCount = 0; //отклоненных подряд запросов CONFIG
+    quint64 _sentFilterVersion = 0; //версия фильтра на момент последней синхронизации
+    QTimer *_configTimer = nullptr; //таймер отложенной отправки изменений фильтра
+
+    DataParser *_dataParser = nullptr; //разбор ответов /data в рабочем потоке
+    bool _isDataPollHeld = false; //получатель событий попросил приостановить опрос
+    bool _isDataPollDelayed = false; //следующий запрос /data отложен до releaseDataPoll()
+};
+
+#endif // SESSION_H
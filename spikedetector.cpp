@@ -0,0 +1,360 @@
+//STL
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+#include "tracer.h"
+
+#include "spikedetector.h"
+
+static const double NO_THRESHOLD = std::numeric_limits<double>::infinity(); //правила нет - порог недостижим
+
+SpikeDetector::SpikeDetector(qsizetype windowSize /* = DEFAULT_WINDOW_SIZE */)
+    : _windowSize(std::max<qsizetype>(windowSize, 1))
+{
+}
+
+void SpikeDetector::setFilter(const Filter::FilterDataList &filterDataList)
+{
+    _filterMatcher.compile(filterDataList);
+
+    _deltaThresholds.clear();
+    _volumeThresholds.clear();
+
+    for (qsizetype i = 0; i < _instruments.size(); ++i)
+    {
+        setThresholds(i);
+    }
+
+    //новые пороги сразу применяются ко всем свечам окон - подбор фильтра без ожидания новых свечей
+    clearCandidates();
+
+    for (qsizetype i = 0; i < _instruments.size(); ++i)
+    {
+        auto& instrument = _instruments[i];
+
+        for (qsizetype slot = 0; slot < instrument.window.size(); ++slot)
+        {
+            if (instrument.isDetected[slot] != 0)
+            {
+                continue;
+            }
+
+            const auto candidate = addCandidate(i, slot);
+            if (slot == instrument.windowHead)
+            {
+                instrument.headCandidate = candidate;
+            }
+        }
+    }
+}
+
+void SpikeDetector::addKLine(const StockExchangeID &stockExchangeID, const KLine &kline, bool isDetected /* = false */)
+{
+    const auto index = instrumentIndex(stockExchangeID, kline.id);
+    auto& instrument = _instruments[index];
+    auto& window = instrument.window;
+
+    if (!window.isEmpty())
+    {
+        const auto& lastKLine = window[instrument.windowHead];
+        if (kline.openTime < lastKLine.openTime)
+        {
+            return;
+        }
+
+        if (kline.openTime == lastKLine.openTime)
+        {
+            window[instrument.windowHead] = kline;
+            instrument.isDetected[instrument.windowHead] |= static_cast<quint8>(isDetected);
+        }
+        else if (window.size() < _windowSize)
+        {
+            window.push_back(kline);
+            instrument.isDetected.push_back(static_cast<quint8>(isDetected));
+            instrument.windowHead = window.size() - 1;
+            instrument.headCandidate = -1;
+        }
+        else
+        {
+            instrument.windowHead = (instrument.windowHead + 1) % _windowSize;
+            window[instrument.windowHead] = kline;
+            instrument.isDetected[instrument.windowHead] = static_cast<quint8>(isDetected);
+            instrument.headCandidate = -1;
+        }
+    }
+    else
+    {
+        window.reserve(_windowSize);
+        window.push_back(kline);
+        instrument.isDetected.reserve(_windowSize);
+        instrument.isDetected.push_back(static_cast<quint8>(isDetected));
+        instrument.windowHead = 0;
+        instrument.headCandidate = -1;
+    }
+
+    if (instrument.isDetected[instrument.windowHead] != 0)
+    {
+        return;
+    }
+
+    //незакрытая свеча обновляется много раз - до такта проверяется только ее последнее состояние
+    if (instrument.headCandidate < 0)
+    {
+        instrument.headCandidate = addCandidate(index, instrument.windowHead);
+    }
+    else
+    {
+        setCandidate(instrument.headCandidate, kline);
+    }
+}
+
+void SpikeDetector::addKLines(const StockExchangeID &stockExchangeID, const KLines &klines, bool isDetected /* = false */)
+{
+    if (klines.isEmpty())
+    {
+        return;
+    }
+
+    auto sortedKLines = klines;
+    std::sort(sortedKLines.begin(), sortedKLines.end(),
+        [](const KLine& kline1, const KLine& kline2)
+        {
+            return kline1.openTime < kline2.openTime;
+        });
+
+    for (qsizetype i = 0; i < sortedKLines.size(); ++i)
+    {
+        addKLine(stockExchangeID, sortedKLines[i], isDetected && i == sortedKLines.size() - 1);
+    }
+}
+
+bool SpikeDetector::hasUpdates() const
+{
+    return !_candidateInstrument.isEmpty();
+}
+
+QList<KLineData> SpikeDetector::detect()
+{
+    TRACE_SPAN("SpikeDetector::detect");
+
+    QList<KLineData> result;
+
+    const auto count = _candidateInstrument.size();
+    if (count == 0)
+    {
+        return result;
+    }
+
+    _delta.resize(count);
+    _quoteVolume.resize(count);
+    _isHit.resize(count);
+
+    //1. delta и объем всех кандидатов (формулы deltaKLine и volumeKLine).
+    //Циклы без ветвлений по подряд идущим столбцам - компилятор векторизует их
+    {
+        const auto open = _open.constData();
+        const auto high = _high.constData();
+        const auto low = _low.constData();
+        const auto close = _close.constData();
+        const auto volume = _volume.constData();
+        const auto candidateInstrument = _candidateInstrument.constData();
+        auto delta = _delta.data();
+        auto quoteVolume = _quoteVolume.data();
+        auto isHit = _isHit.data();
+
+        for (qsizetype i = 0; i < count; ++i)
+        {
+            delta[i] = ((high[i] - low[i]) / low[i]) * 100.0;
+            quoteVolume[i] = ((open[i] + close[i]) / 2) * volume[i];
+            isHit[i] = 0;
+        }
+
+        //2. пороги: столбец на каждое правило, событие - выполнено хотя бы одно правило
+        for (qsizetype k = 0; k < _deltaThresholds.size(); ++k)
+        {
+            const auto deltaThreshold = _deltaThresholds[k].constData();
+            const auto volumeThreshold = _volumeThresholds[k].constData();
+
+            for (qsizetype i = 0; i < count; ++i)
+            {
+                const auto index = candidateInstrument[i];
+                isHit[i] |= static_cast<quint8>((delta[i] >= deltaThreshold[index]) & (quoteVolume[i] >= volumeThreshold[index]));
+            }
+        }
+    }
+
+    //3. события. Срабатываний мало по сравнению с количеством кандидатов
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        if (_isHit[i] == 0)
+        {
+            continue;
+        }
+
+        auto& instrument = _instruments[_candidateInstrument[i]];
+        const auto slot = _candidateSlot[i];
+        const auto& kline = instrument.window[slot];
+
+        //окно прокрутилось после добавления свечи или свеча уже найдена
+        if (kline.openTime.toMSecsSinceEpoch() != _candidateOpenTime[i] || instrument.isDetected[slot] != 0)
+        {
+            continue;
+        }
+
+        instrument.isDetected[slot] = 1;
+
+        KLineData klineData;
+        klineData.stockExchangeID = instrument.stockExchangeID;
+        klineData.delta = _delta[i];
+        klineData.volume = _quoteVolume[i];
+        klineData.history = history(instrument, slot);
+
+        result.push_back(std::move(klineData));
+    }
+
+    clearCandidates();
+
+    return result;
+}
+
+qsizetype SpikeDetector::instrumentCount() const
+{
+    return _instruments.size();
+}
+
+void SpikeDetector::clear()
+{
+    _instrumentIndexes.clear();
+    _instruments.clear();
+
+    _deltaThresholds.clear();
+    _volumeThresholds.clear();
+
+    _candidateInstrument.clear();
+    _candidateSlot.clear();
+    _candidateOpenTime.clear();
+    _open.clear();
+    _high.clear();
+    _low.clear();
+    _close.clear();
+    _volume.clear();
+
+    _delta.clear();
+    _quoteVolume.clear();
+    _isHit.clear();
+}
+
+qsizetype SpikeDetector::instrumentIndex(const StockExchangeID &stockExchangeID, const KLineID &id)
+{
+    auto& indexes = _instrumentIndexes[stockExchangeID.name];
+    const auto indexes_it = indexes.find(id);
+    if (indexes_it != indexes.end())
+    {
+        return indexes_it.value();
+    }
+
+    const auto index = _instruments.size();
+    indexes.insert(id, index);
+
+    Instrument instrument;
+    instrument.stockExchangeID = stockExchangeID;
+    instrument.id = id;
+    _instruments.push_back(std::move(instrument));
+
+    for (qsizetype k = 0; k < _deltaThresholds.size(); ++k)
+    {
+        _deltaThresholds[k].push_back(NO_THRESHOLD);
+        _volumeThresholds[k].push_back(NO_THRESHOLD);
+    }
+
+    setThresholds(index);
+
+    return index;
+}
+
+void SpikeDetector::addThresholdColumns(qsizetype count)
+{
+    while (_deltaThresholds.size() < count)
+    {
+        _deltaThresholds.push_back(QList<double>(_instruments.size(), NO_THRESHOLD));
+        _volumeThresholds.push_back(QList<double>(_instruments.size(), NO_THRESHOLD));
+    }
+}
+
+void SpikeDetector::setThresholds(qsizetype index)
+{
+    const auto& instrument = _instruments[index];
+    const auto rules = _filterMatcher.rules(instrument.stockExchangeID, instrument.id);
+
+    addThresholdColumns(rules.size());
+
+    for (qsizetype k = 0; k < _deltaThresholds.size(); ++k)
+    {
+        _deltaThresholds[k][index] = k < rules.size() ? rules[k].delta : NO_THRESHOLD;
+        _volumeThresholds[k][index] = k < rules.size() ? rules[k].volume : NO_THRESHOLD;
+    }
+}
+
+qsizetype SpikeDetector::addCandidate(qsizetype index, qsizetype slot)
+{
+    const auto candidate = _candidateInstrument.size();
+
+    _candidateInstrument.push_back(index);
+    _candidateSlot.push_back(slot);
+    _candidateOpenTime.push_back(0);
+    _open.push_back(0.0);
+    _high.push_back(0.0);
+    _low.push_back(0.0);
+    _close.push_back(0.0);
+    _volume.push_back(0.0);
+
+    setCandidate(candidate, _instruments[index].window[slot]);
+
+    return candidate;
+}
+
+void SpikeDetector::setCandidate(qsizetype candidate, const KLine &kline)
+{
+    _candidateOpenTime[candidate] = kline.openTime.toMSecsSinceEpoch();
+    _open[candidate] = kline.open;
+    _high[candidate] = kline.high;
+    _low[candidate] = kline.low;
+    _close[candidate] = kline.close;
+    _volume[candidate] = kline.volume;
+}
+
+void SpikeDetector::clearCandidates()
+{
+    for (const auto index: std::as_const(_candidateInstrument))
+    {
+        _instruments[index].headCandidate = -1;
+    }
+
+    _candidateInstrument.clear();
+    _candidateSlot.clear();
+    _candidateOpenTime.clear();
+    _open.clear();
+    _high.clear();
+    _low.clear();
+    _close.clear();
+    _volume.clear();
+}
+
+KLines SpikeDetector::history(const Instrument &instrument, qsizetype slot) const
+{
+    //от свечи slot к самой старой свече окна
+    const auto& window = instrument.window;
+    const auto oldest = window.size() < _windowSize ? 0 : (instrument.windowHead + 1) % window.size();
+    const auto count = (slot - oldest + window.size()) % window.size() + 1;
+
+    KLines result;
+    result.reserve(count);
+
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        result.push_back(window[(slot - i + window.size()) % window.size()]);
+    }
+
+    return result;
+}
@@ -0,0 +1,91 @@
+#ifndef SPIKEDETECTOR_H
+#define SPIKEDETECTOR_H
+
+//Qt
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <QDateTime>
+
+#include "types.h"
+#include "filter.h"
+#include "filtermatcher.h"
+
+//Локальный поиск событий по потоку свечей без участия сервера.
+//Для каждого инструмента (биржа, монета, интервал) хранится скользящее окно последних свечей.
+//Свечи, добавленные после прошлого такта (кандидаты), лежат по столбцам, поэтому пороги delta/volume
+//фильтра проверяются за один проход по подряд идущей памяти на каждом такте detect()
+class SpikeDetector
+{
+public:
+    static const qsizetype DEFAULT_WINDOW_SIZE = 60; //свечей в истории найденного события
+
+public:
+    explicit SpikeDetector(qsizetype windowSize = DEFAULT_WINDOW_SIZE);
+
+    void setFilter(const Filter::FilterDataList& filterDataList); //все окна будут проверены заново на следующем такте
+
+    //свеча с тем же временем открытия заменяет последнюю (незакрытая свеча), более старые свечи пропускаются.
+    //isDetected - свеча уже найдена сервером и локально не сообщается
+    void addKLine(const StockExchangeID& stockExchangeID, const KLine& kline, bool isDetected = false);
+    //порядок klines любой (история события хранится от новых к старым), isDetected относится к самой новой свече
+    void addKLines(const StockExchangeID& stockExchangeID, const KLines& klines, bool isDetected = false);
+
+    bool hasUpdates() const; //есть свечи, не проверенные detect()
+
+    //проверяет все свечи, добавленные после прошлого такта. Возвращает новые события,
+    //history - окно инструмента от найденной свечи к старым, как у событий сервера
+    QList<KLineData> detect();
+
+    qsizetype instrumentCount() const;
+    void clear();
+
+private:
+    struct Instrument //данные инструмента, которые не нужны при проверке порогов
+    {
+        StockExchangeID stockExchangeID;
+        KLineID id;
+        KLines window; //кольцевой буфер последних свечей
+        QList<quint8> isDetected; //свеча окна уже найдена сервером или локально
+        qsizetype windowHead = 0; //индекс самой новой свечи в window
+        qsizetype headCandidate = -1; //кандидат самой новой свечи, -1 - свеча уже проверена
+    };
+
+private:
+    qsizetype instrumentIndex(const StockExchangeID& stockExchangeID, const KLineID& id);
+    void addThresholdColumns(qsizetype count);
+    void setThresholds(qsizetype index);
+    qsizetype addCandidate(qsizetype index, qsizetype slot);
+    void setCandidate(qsizetype candidate, const KLine& kline);
+    void clearCandidates();
+    KLines history(const Instrument& instrument, qsizetype slot) const;
+
+private:
+    const qsizetype _windowSize = DEFAULT_WINDOW_SIZE;
+
+    FilterMatcher _filterMatcher;
+
+    QHash<QString, QHash<KLineID, qsizetype>> _instrumentIndexes; //биржа -> свеча -> индекс инструмента
+    QList<Instrument> _instruments;
+
+    //столбец k - порог k-го правила каждого инструмента, у инструментов с меньшим числом правил - недостижимый порог
+    QList<QList<double>> _deltaThresholds;
+    QList<QList<double>> _volumeThresholds;
+
+    //кандидаты - свечи, добавленные после прошлого такта, по столбцам
+    QList<qsizetype> _candidateInstrument;
+    QList<qsizetype> _candidateSlot; //индекс свечи в окне инструмента
+    QList<qint64> _candidateOpenTime; //ms - слот могла занять более новая свеча, если окно прокрутилось
+    QList<double> _open;
+    QList<double> _high;
+    QList<double> _low;
+    QList<double> _close;
+    QList<double> _volume;
+
+    //рабочие столбцы такта, память переиспользуется
+    QList<double> _delta;
+    QList<double> _quoteVolume;
+    QList<quint8> _isHit;
+};
+
+#endif // SPIKEDETECTOR_H
@@ -0,0 +1,151 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDebug>
+#include <QLoggingCategory>
+
+#include "stallwatchdog.h"
+
+static const qint64 STALL_TIME = 16; //ms задержка дольше одного кадра
+static const int CHECK_INTERVAL = 16; //ms
+
+static StallWatchdog *instance = nullptr;
+
+//каждая задержка в журнал - только по запросу: QT_LOGGING_RULES="tradingcat.stall.debug=true".
+//Итоги всегда доступны в статистике
+Q_LOGGING_CATEGORY(stallLog, "tradingcat.stall", QtWarningMsg)
+
+StallWatchdog::Scope::Scope(const char *name)
+    : _watchdog(instance)
+{
+    if (_watchdog != nullptr)
+    {
+        _watchdog->enter(name);
+    }
+}
+
+StallWatchdog::Scope::~Scope()
+{
+    if (_watchdog != nullptr)
+    {
+        _watchdog->leave();
+    }
+}
+
+StallWatchdog::StallWatchdog(QObject *parent)
+    : QObject{parent}
+{
+    Q_ASSERT(instance == nullptr);
+
+    instance = this;
+
+    _clock.start();
+
+    _timer = new QTimer(this);
+    _timer->setTimerType(Qt::PreciseTimer);
+    _timer->setInterval(CHECK_INTERVAL);
+
+    QObject::connect(_timer, SIGNAL(timeout()), SLOT(timer_timeout()));
+
+    _timer->start();
+}
+
+StallWatchdog::~StallWatchdog()
+{
+    instance = nullptr;
+}
+
+const StallWatchdog::Stats &StallWatchdog::stats() const
+{
+    return _stats;
+}
+
+qint64 StallWatchdog::worstLatency() const
+{
+    return _worstLatency;
+}
+
+void StallWatchdog::setActive(bool isActive)
+{
+    if (isActive == _timer->isActive())
+    {
+        return;
+    }
+
+    if (isActive)
+    {
+        //время в фоне - не задержка цикла событий
+        _lastTick = _clock.elapsed();
+        _isStallRecorded = false;
+
+        _timer->start();
+    }
+    else
+    {
+        _timer->stop();
+    }
+}
+
+void StallWatchdog::timer_timeout()
+{
+    const auto now = _clock.elapsed();
+    const auto latency = now - _lastTick - CHECK_INTERVAL;
+    _lastTick = now;
+
+    _worstLatency = std::max(_worstLatency, latency);
+
+    //задержку вызвал код без отметки: отрисовка, раскладка виджетов, обработчики Qt
+    if (latency > STALL_TIME && !_isStallRecorded)
+    {
+        addStall(_lastHandler != nullptr ? QString("unattributed after %1").arg(_lastHandler) : QString("unattributed"), latency);
+    }
+
+    _isStallRecorded = false;
+}
+
+void StallWatchdog::enter(const char *name)
+{
+    Frame frame;
+    frame.name = name;
+    frame.start = _clock.elapsed();
+
+    _frames.push_back(frame);
+}
+
+void StallWatchdog::leave()
+{
+    Q_ASSERT(!_frames.isEmpty());
+
+    const auto frame = _frames.takeLast();
+    const auto time = _clock.elapsed() - frame.start;
+
+    //задержка приписывается самому глубокому обработчику, который сам по себе занял больше кадра
+    qint64 stallTime = frame.childStall;
+    if (time - frame.childStall > STALL_TIME)
+    {
+        addStall(frame.name, time - frame.childStall);
+        stallTime = time;
+    }
+
+    if (!_frames.isEmpty())
+    {
+        _frames.last().childStall += stallTime;
+    }
+    else
+    {
+        _lastHandler = frame.name;
+    }
+}
+
+void StallWatchdog::addStall(const QString &handler, qint64 time)
+{
+    _isStallRecorded = true;
+
+    auto& stats = _stats[handler];
+    ++stats.stallCount;
+    stats.worstTime = std::max(stats.worstTime, time);
+    stats.totalTime += time;
+
+    qCDebug(stallLog) << "STALL:" << handler << "took" << time << "ms";
+}
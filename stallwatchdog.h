@@ -0,0 +1,87 @@
+#ifndef STALLWATCHDOG_H
+#define STALLWATCHDOG_H
+
+//Qt
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "tracer.h"
+
+//Контроль задержек цикла событий GUI потока. Каждая задержка дольше кадра записывается
+//вместе с обработчиком, который в это время выполнялся. Обработчики отмечаются объектами Scope
+class StallWatchdog : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct HandlerStats
+    {
+        quint64 stallCount = 0;
+        qint64 worstTime = 0; //ms
+        qint64 totalTime = 0; //ms
+    };
+
+    using Stats = QHash<QString, HandlerStats>;
+
+    //отмечает выполнение обработчика до выхода из области видимости. Только для GUI потока
+    class Scope
+    {
+    public:
+        explicit Scope(const char *name);
+        ~Scope();
+
+    private:
+        Q_DISABLE_COPY_MOVE(Scope)
+
+        StallWatchdog *_watchdog = nullptr;
+    };
+
+public:
+    explicit StallWatchdog(QObject *parent = nullptr);
+    ~StallWatchdog();
+
+    const Stats& stats() const;
+    qint64 worstLatency() const; //ms наибольшая задержка цикла событий
+
+    //браузер и ОС замедляют таймеры свернутого окна и фоновой вкладки - такие задержки не считаются
+    void setActive(bool isActive);
+
+private slots:
+    void timer_timeout();
+
+private:
+    struct Frame
+    {
+        const char *name = nullptr;
+        qint64 start = 0;      //ms
+        qint64 childStall = 0; //ms время вложенных обработчиков, уже записанное как задержка
+    };
+
+private:
+    void enter(const char *name);
+    void leave();
+    void addStall(const QString& handler, qint64 time);
+
+private:
+    QTimer *_timer = nullptr;
+    QElapsedTimer _clock;
+    qint64 _lastTick = 0;
+    qint64 _worstLatency = 0;
+    bool _isStallRecorded = false; //задержка с момента последней проверки уже записана обработчиком
+    const char *_lastHandler = nullptr; //последний завершившийся обработчик верхнего уровня
+
+    QList<Frame> _frames; //выполняющиеся обработчики, вложенные друг в друга
+    Stats _stats;
+};
+
+//отмечает обработчик GUI потока для StallWatchdog и для трассы (TRACE_SPAN).
+//name - строковый литерал или другая строка, живущая до конца работы программы
+#define HANDLER_SCOPE(name) \
+    TRACE_SPAN(name); \
+    const StallWatchdog::Scope TRACE_SPAN_CONCAT(stallScope_, __LINE__)(name)
+
+#endif // STALLWATCHDOG_H
@@ -0,0 +1,176 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDateTime>
+
+#include "Common/common.h"
+
+#include "eventgenerator.h"
+
+using namespace Common;
+
+static const KLineType INTERVALS[] = {KLineType::MIN1, KLineType::MIN5, KLineType::MIN15, KLineType::MIN30, KLineType::MIN60,
+                                      KLineType::HOUR4, KLineType::HOUR8, KLineType::DAY1, KLineType::WEEK1};
+static const double MIN_DELTA = 2.0;   //минимальные значения, которые клиент позволяет указать в фильтре
+static const double MIN_VOLUME = 500.0;
+
+EventGenerator::EventGenerator(qsizetype moneyCount, qsizetype historySize, quint32 seed)
+    : _historySize(std::max<qsizetype>(historySize, 1))
+    , _stockExchanges({"MEXC", "KUCOIN", "GATE", "BYBIT", "BINANCE"})
+    , _random(seed)
+{
+    for (qsizetype i = 0; i < moneyCount; ++i)
+    {
+        _moneys.push_back(QString("COIN%1USDT").arg(i));
+    }
+
+    for (const auto& stockExchange: _stockExchanges)
+    {
+        auto& moneys = _catalog[stockExchange];
+        for (const auto& money: _moneys)
+        {
+            auto& intervals = moneys[money];
+            for (const auto type: INTERVALS)
+            {
+                intervals.insert(KLineTypeToString(type));
+            }
+        }
+    }
+}
+
+const ExistsStockExchange &EventGenerator::catalog() const
+{
+    return _catalog;
+}
+
+QJsonArray EventGenerator::catalogJSON() const
+{
+    QJsonArray result;
+
+    for (auto catalog_it = _catalog.begin(); catalog_it != _catalog.end(); ++catalog_it)
+    {
+        for (auto moneys_it = catalog_it.value().begin(); moneys_it != catalog_it.value().end(); ++moneys_it)
+        {
+            for (const auto& interval: moneys_it.value())
+            {
+                QJsonObject kline;
+                kline.insert("StockExchange", catalog_it.key());
+                kline.insert("Money", moneys_it.key());
+                kline.insert("Interval", interval);
+
+                result.push_back(kline);
+            }
+        }
+    }
+
+    return result;
+}
+
+QJsonObject EventGenerator::makeEvent(const Filter::FilterDataList &filter)
+{
+    QString stockExchange;
+    QString money;
+    KLineType type = KLineType::UNKNOW;
+    double delta = MIN_DELTA;
+    double volume = MIN_VOLUME;
+
+    if (!filter.isEmpty())
+    {
+        //событие строится с запасом над порогами случайного правила
+        const auto& rule = filter.at(_random.bounded(static_cast<int>(filter.size())));
+        stockExchange = rule.stockExchangeID.name;
+        money = rule.klineID.symbol == "ALL" ? _moneys.at(_random.bounded(static_cast<int>(_moneys.size()))) : rule.klineID.symbol;
+        type = rule.klineID.type;
+        delta = std::max(rule.delta, MIN_DELTA);
+        volume = std::max(rule.volume, MIN_VOLUME);
+    }
+    else
+    {
+        stockExchange = _stockExchanges.at(_random.bounded(static_cast<int>(_stockExchanges.size())));
+        money = _moneys.at(_random.bounded(static_cast<int>(_moneys.size())));
+        type = INTERVALS[_random.bounded(static_cast<int>(std::size(INTERVALS)))];
+    }
+
+    delta *= 1.0 + _random.generateDouble() * 0.5;
+    volume *= 1.0 + _random.generateDouble();
+
+    const auto history = makeHistory(money, type, delta, volume);
+
+    //обзорная история - минутные свечи той же монеты
+    KLines reviewHistory;
+    if (type != KLineType::MIN1)
+    {
+        reviewHistory = makeHistory(money, KLineType::MIN1, 0.0, 0.0);
+    }
+
+    QJsonObject result;
+    result.insert("StockExchange", stockExchange);
+    result.insert("Delta", deltaKLine(history.first()));
+    result.insert("Volume", volumeKLine(history.first()));
+    result.insert("History", historyToJSON(history));
+    result.insert("ReviewHistory", historyToJSON(reviewHistory));
+
+    return result;
+}
+
+KLines EventGenerator::makeHistory(const QString &money, KLineType type, double delta, double volume)
+{
+    const auto interval = static_cast<qint64>(type);
+    const auto now = QDateTime::currentMSecsSinceEpoch();
+    const auto lastOpenTime = now - now % interval;
+
+    KLines result;
+    result.reserve(_historySize);
+
+    //история от новых свечей к старым, как у сервера: первая свеча - обнаруженная
+    auto price = 0.01 + _random.generateDouble() * 100.0;
+    for (qsizetype i = 0; i < _historySize; ++i)
+    {
+        KLine kline;
+        kline.id.symbol = money;
+        kline.id.type = type;
+        kline.openTime = QDateTime::fromMSecsSinceEpoch(lastOpenTime - i * interval);
+        kline.closeTime = QDateTime::fromMSecsSinceEpoch(lastOpenTime - i * interval + interval - 1);
+
+        const auto candleDelta = (i == 0 && delta > 0.0) ? delta : _random.generateDouble();
+        kline.low = price;
+        kline.high = price * (1.0 + candleDelta / 100.0);
+        kline.open = _random.bounded(2) == 0 ? kline.low : kline.high;
+        kline.close = kline.open == kline.low ? kline.high : kline.low;
+
+        const auto averagePrice = (kline.open + kline.close) / 2.0;
+        kline.volume = (i == 0 && volume > 0.0) ? volume / averagePrice * 1.01 : (_random.generateDouble() * MIN_VOLUME) / averagePrice;
+        kline.quoteAssetVolume = kline.volume * averagePrice;
+
+        result.push_back(std::move(kline));
+
+        price *= 1.0 + (_random.generateDouble() - 0.5) / 100.0;
+    }
+
+    return result;
+}
+
+QJsonArray EventGenerator::historyToJSON(const KLines &history)
+{
+    QJsonArray result;
+
+    for (const auto& kline: history)
+    {
+        QJsonObject jsonKLine;
+        jsonKLine.insert("Money", kline.id.symbol);
+        jsonKLine.insert("Interval", KLineTypeToString(kline.id.type));
+        jsonKLine.insert("OpenTime", kline.openTime.toString(DATETIME_FORMAT));
+        jsonKLine.insert("CloseTime", kline.closeTime.toString(DATETIME_FORMAT));
+        jsonKLine.insert("Open", kline.open);
+        jsonKLine.insert("Close", kline.close);
+        jsonKLine.insert("High", kline.high);
+        jsonKLine.insert("Low", kline.low);
+        jsonKLine.insert("Volume", kline.volume);
+        jsonKLine.insert("QuoteAssetVolume", kline.quoteAssetVolume);
+
+        result.push_back(jsonKLine);
+    }
+
+    return result;
+}
@@ -0,0 +1,37 @@
+#ifndef EVENTGENERATOR_H
+#define EVENTGENERATOR_H
+
+//Qt
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QRandomGenerator>
+#include <QStringList>
+
+#include "types.h"
+#include "filter.h"
+
+//Синтетический каталог монет и события DetectKLines для тестового сервера
+class EventGenerator
+{
+public:
+    EventGenerator(qsizetype moneyCount, qsizetype historySize, quint32 seed);
+
+    const ExistsStockExchange& catalog() const;
+    QJsonArray catalogJSON() const; //массив KLines ответа /klines
+
+    //событие, удовлетворяющее одному из правил filter. При пустом фильтре - событие по случайной монете
+    QJsonObject makeEvent(const Filter::FilterDataList& filter);
+
+private:
+    KLines makeHistory(const QString& money, KLineType type, double delta, double volume);
+    static QJsonArray historyToJSON(const KLines& history);
+
+private:
+    const qsizetype _historySize = 0;
+    QStringList _stockExchanges;
+    QStringList _moneys;
+    ExistsStockExchange _catalog;
+    QRandomGenerator _random;
+};
+
+#endif // EVENTGENERATOR_H
@@ -0,0 +1,47 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+
+#include "standinserver.h"
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    QCoreApplication::setApplicationName("TradingCatStandInServer");
+    QCoreApplication::setOrganizationName("Cat software development");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Local stand-in for the TradingCat server with synthetic events");
+    parser.addHelpOption();
+    parser.addOption(QCommandLineOption("port", "Listen port.", "port", "59923"));
+    parser.addOption(QCommandLineOption("events", "Events per second for each session.", "rate", "1"));
+    parser.addOption(QCommandLineOption("history", "Candles in event history.", "count", "60"));
+    parser.addOption(QCommandLineOption("moneys", "Moneys of each stock exchange in catalog.", "count", "50"));
+    parser.addOption(QCommandLineOption("latency", "Answer latency, ms.", "ms", "0"));
+    parser.addOption(QCommandLineOption("jitter", "Random addition to latency, ms.", "ms", "0"));
+    parser.addOption(QCommandLineOption("error-rate", "Share of requests answered with HTTP 503 (0..1).", "rate", "0"));
+    parser.addOption(QCommandLineOption("logout-rate", "Share of /data requests that close the session (0..1).", "rate", "0"));
+    parser.addOption(QCommandLineOption("session-timeout", "Close sessions without /data requests for this time, s.", "s", "60"));
+    parser.addOption(QCommandLineOption("seed", "Random seed.", "seed", "0"));
+    parser.process(a);
+
+    StandInServer::Config config;
+    config.port = parser.value("port").toUShort();
+    config.eventsPerSecond = parser.value("events").toDouble();
+    config.historySize = parser.value("history").toLongLong();
+    config.moneyCount = parser.value("moneys").toLongLong();
+    config.latency = parser.value("latency").toInt();
+    config.latencyJitter = parser.value("jitter").toInt();
+    config.errorRate = parser.value("error-rate").toDouble();
+    config.logoutRate = parser.value("logout-rate").toDouble();
+    config.sessionTimeout = parser.value("session-timeout").toInt() * 1000;
+    config.seed = parser.value("seed").toUInt();
+
+    StandInServer server(config);
+    if (!server.start())
+    {
+        return 1;
+    }
+
+    return a.exec();
+}
@@ -0,0 +1,411 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonArray>
+#include <QJsonParseError>
+
+#include "standinserver.h"
+
+static const qsizetype MAX_REQUEST_SIZE = 1024 * 1024; //запросы больше отклоняются
+static const double MAX_EVENTS_PER_ANSWER = 1000.0;    //ограничение размера ответа /data после долгой паузы
+static const int STATISTIC_INTERVAL = 10000; //ms
+static const int SESSION_CHECK_INTERVAL = 5000; //ms
+
+StandInServer::StandInServer(const Config &config, QObject *parent)
+    : QObject{parent}
+    , _config(config)
+    , _generator(config.moneyCount, config.historySize, config.seed)
+    , _random(config.seed)
+{
+    QObject::connect(&_server, SIGNAL(newConnection()), SLOT(newConnection()));
+
+    _statisticTimer.setInterval(STATISTIC_INTERVAL);
+    QObject::connect(&_statisticTimer, SIGNAL(timeout()), SLOT(printStatistic()));
+
+    _sessionTimer.setInterval(SESSION_CHECK_INTERVAL);
+    QObject::connect(&_sessionTimer, SIGNAL(timeout()), SLOT(removeExpiredSessions()));
+}
+
+bool StandInServer::start()
+{
+    if (!_server.listen(QHostAddress::Any, _config.port))
+    {
+        qDebug() << "Cannot listen port" << _config.port << _server.errorString();
+
+        return false;
+    }
+
+    _statisticTimer.start();
+    _sessionTimer.start();
+
+    qDebug() << "Stand-in server started on port" << _config.port
+             << "Events/s:" << _config.eventsPerSecond
+             << "History:" << _config.historySize
+             << "Moneys:" << _config.moneyCount
+             << "Latency:" << _config.latency << "+-" << _config.latencyJitter << "ms"
+             << "Error rate:" << _config.errorRate
+             << "Logout rate:" << _config.logoutRate
+             << "Session timeout:" << _config.sessionTimeout << "ms";
+
+    return true;
+}
+
+void StandInServer::newConnection()
+{
+    while (_server.hasPendingConnections())
+    {
+        auto socket = _server.nextPendingConnection();
+
+        QObject::connect(socket, &QTcpSocket::readyRead, this, [this, socket](){ readRequest(socket); });
+        QObject::connect(socket, &QTcpSocket::disconnected, this,
+            [this, socket]()
+            {
+                _buffers.remove(socket);
+                socket->deleteLater();
+            });
+    }
+}
+
+void StandInServer::printStatistic()
+{
+    qDebug() << "Requests:" << _requestCount << "Errors:" << _errorCount << "Events:" << _eventCount
+             << "Sessions:" << _sessions.size() << "Expired sessions:" << _expiredSessionCount;
+}
+
+void StandInServer::removeExpiredSessions()
+{
+    //закрытая вкладка или остановленный генератор нагрузки не выходят из сессии - без удаления сессии копятся
+    for (auto sessions_it = _sessions.begin(); sessions_it != _sessions.end();)
+    {
+        if (sessions_it->lastPoll.hasExpired(_config.sessionTimeout))
+        {
+            sessions_it = _sessions.erase(sessions_it);
+            ++_expiredSessionCount;
+        }
+        else
+        {
+            ++sessions_it;
+        }
+    }
+}
+
+void StandInServer::readRequest(QTcpSocket *socket)
+{
+    auto& buffer = _buffers[socket];
+    buffer.append(socket->readAll());
+
+    if (buffer.size() > MAX_REQUEST_SIZE)
+    {
+        //остаток запроса не читаем: буфер освобождается, ответ отправляется без задержки и соединение закрывается
+        _buffers.remove(socket);
+        QObject::disconnect(socket, &QTcpSocket::readyRead, this, nullptr);
+
+        ++_errorCount;
+
+        socket->write(makeResponse(413, QByteArray()));
+        socket->disconnectFromHost();
+
+        return;
+    }
+
+    const auto headerEnd = buffer.indexOf("\r\n\r\n");
+    if (headerEnd == -1)
+    {
+        return;
+    }
+
+    const auto lines = buffer.left(headerEnd).split('\n');
+    const auto requestLine = lines.first().trimmed().split(' ');
+    if (requestLine.size() < 2)
+    {
+        sendResponse(socket, 400, QByteArray());
+
+        return;
+    }
+
+    qsizetype contentLength = 0;
+    for (qsizetype i = 1; i < lines.size(); ++i)
+    {
+        const auto line = lines.at(i).trimmed();
+        if (line.toLower().startsWith("content-length:"))
+        {
+            contentLength = line.mid(line.indexOf(':') + 1).trimmed().toLongLong();
+        }
+    }
+
+    //тело запроса еще не пришло целиком
+    if (buffer.size() < headerEnd + 4 + contentLength)
+    {
+        return;
+    }
+
+    Request request;
+    request.method = requestLine.at(0);
+    request.path = QString::fromUtf8(requestLine.at(1));
+    request.body = buffer.mid(headerEnd + 4, contentLength);
+
+    _buffers.remove(socket);
+
+    ++_requestCount;
+
+    //предварительный запрос CORS браузера
+    if (request.method == "OPTIONS")
+    {
+        sendResponse(socket, 204, QByteArray());
+
+        return;
+    }
+
+    if (_random.generateDouble() < _config.errorRate)
+    {
+        ++_errorCount;
+
+        sendResponse(socket, 503, QByteArray());
+
+        return;
+    }
+
+    sendResponse(socket, 200, QJsonDocument(handle(request)).toJson(QJsonDocument::Compact));
+}
+
+void StandInServer::sendResponse(QTcpSocket *socket, int code, const QByteArray &body)
+{
+    auto delay = _config.latency;
+    if (_config.latencyJitter > 0)
+    {
+        delay += _random.bounded(_config.latencyJitter + 1);
+    }
+
+    const auto response = makeResponse(code, body);
+
+    //соединение могли закрыть, пока ответ ждал задержки
+    QTimer::singleShot(std::max(delay, 0), socket,
+        [socket, response]()
+        {
+            socket->write(response);
+            socket->disconnectFromHost();
+        });
+}
+
+QByteArray StandInServer::makeResponse(int code, const QByteArray &body)
+{
+    QByteArray response;
+    response.append(QString("HTTP/1.1 %1 %2\r\n").arg(code).arg(code == 200 ? "OK" : (code == 204 ? "No Content" : "Error")).toUtf8());
+    response.append("Content-Type: application/json\r\n");
+    response.append("Access-Control-Allow-Origin: *\r\n");
+    response.append("Access-Control-Allow-Headers: *\r\n");
+    response.append("Access-Control-Allow-Methods: GET, POST, OPTIONS\r\n");
+    response.append(QString("Content-Length: %1\r\n").arg(body.size()).toUtf8());
+    response.append("Connection: close\r\n\r\n");
+    response.append(body);
+
+    return response;
+}
+
+QJsonObject StandInServer::handle(const Request &request)
+{
+    auto args = request.path.split('/', Qt::SkipEmptyParts);
+    if (args.isEmpty())
+    {
+        return makeResult("ERROR", "Empty request");
+    }
+
+    const auto method = args.takeFirst();
+
+    if (method == "newuser")
+    {
+        return newUser(args);
+    }
+    else if (method == "login")
+    {
+        return login(args);
+    }
+    else if (method == "klines")
+    {
+        return klines(args);
+    }
+    else if (method == "config")
+    {
+        return config(args, request.body);
+    }
+    else if (method == "data")
+    {
+        return data(args);
+    }
+
+    return makeResult("ERROR", QString("Unknown method: %1").arg(method));
+}
+
+QJsonObject StandInServer::newUser(const QStringList &args)
+{
+    if (args.size() < 2)
+    {
+        return makeResult("ERROR", "User or password is empty");
+    }
+
+    const auto user = QString::fromUtf8(QByteArray::fromBase64(args.at(0).toUtf8()));
+    if (_users.contains(user))
+    {
+        return makeResult("ERROR", "User already exists");
+    }
+
+    User tmp;
+    tmp.password = QString::fromUtf8(QByteArray::fromBase64(args.at(1).toUtf8()));
+    _users.insert(user, tmp);
+
+    return makeResult("OK");
+}
+
+QJsonObject StandInServer::login(const QStringList &args)
+{
+    if (args.size() < 2)
+    {
+        return makeResult("ERROR", "User or password is empty");
+    }
+
+    const auto user = QString::fromUtf8(QByteArray::fromBase64(args.at(0).toUtf8()));
+    const auto password = QString::fromUtf8(QByteArray::fromBase64(args.at(1).toUtf8()));
+
+    //сервер хранит пользователей только в памяти - после перезапуска клиенты входят без повторной регистрации
+    auto users_it = _users.find(user);
+    if (users_it == _users.end())
+    {
+        User tmp;
+        tmp.password = password;
+        users_it = _users.insert(user, tmp);
+    }
+
+    if (users_it.value().password != password)
+    {
+        return makeResult("ERROR", "Wrong password");
+    }
+
+    Session session;
+    session.user = user;
+    session.lastPoll.start();
+
+    const auto sessionID = ++_lastSessionID;
+    _sessions.insert(sessionID, session);
+
+    auto result = makeResult("OK");
+    result.insert("SessionID", sessionID);
+    result.insert("Filter", users_it.value().filter.toJSON());
+    result.insert("FilterDiff", true); //клиент может отправлять в /config только изменения фильтра
+
+    return result;
+}
+
+QJsonObject StandInServer::klines(const QStringList &args)
+{
+    if (findSession(args) == nullptr)
+    {
+        return makeResult("LOGOUT", "Session not found");
+    }
+
+    auto result = makeResult("OK");
+    result.insert("KLines", _generator.catalogJSON());
+
+    return result;
+}
+
+QJsonObject StandInServer::config(const QStringList &args, const QByteArray &body)
+{
+    const auto session = findSession(args);
+    if (session == nullptr)
+    {
+        return makeResult("LOGOUT", "Session not found");
+    }
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(body, &error);
+    if (error.error != QJsonParseError::NoError)
+    {
+        return makeResult("ERROR", error.errorString());
+    }
+
+    auto& filter = _users[session->user].filter;
+
+    const auto json = doc.object();
+    if (json.contains("FilterDiff"))
+    {
+        filter.applyDiff(json["FilterDiff"].toObject());
+    }
+    else
+    {
+        filter.fromJSON(json["Filter"].toArray());
+    }
+
+    if (filter.isError())
+    {
+        return makeResult("ERROR", filter.errorString());
+    }
+
+    return makeResult("OK");
+}
+
+QJsonObject StandInServer::data(const QStringList &args)
+{
+    auto session = findSession(args);
+    if (session == nullptr)
+    {
+        return makeResult("LOGOUT", "Session not found");
+    }
+
+    if (_random.generateDouble() < _config.logoutRate)
+    {
+        _sessions.remove(args.first().toInt());
+
+        return makeResult("LOGOUT", "Session closed by server");
+    }
+
+    //количество событий пропорционально времени с прошлого запроса
+    session->pendingEvents = std::min(session->pendingEvents + session->lastPoll.restart() / 1000.0 * _config.eventsPerSecond,
+                                      MAX_EVENTS_PER_ANSWER);
+
+    const auto& filter = _users[session->user].filter.toList();
+
+    QJsonArray detectKLines;
+    while (session->pendingEvents >= 1.0)
+    {
+        detectKLines.push_back(_generator.makeEvent(filter));
+        session->pendingEvents -= 1.0;
+    }
+
+    _eventCount += detectKLines.size();
+
+    auto result = makeResult("OK");
+    result.insert("DetectKLines", detectKLines);
+
+    return result;
+}
+
+StandInServer::Session *StandInServer::findSession(const QStringList &args)
+{
+    if (args.isEmpty())
+    {
+        return nullptr;
+    }
+
+    const auto sessions_it = _sessions.find(args.first().toInt());
+    if (sessions_it == _sessions.end())
+    {
+        return nullptr;
+    }
+
+    return &sessions_it.value();
+}
+
+QJsonObject StandInServer::makeResult(const QString &result, const QString &message)
+{
+    QJsonObject json;
+    json.insert("Result", result);
+    if (!message.isEmpty())
+    {
+        json.insert("Message", message);
+    }
+
+    return json;
+}
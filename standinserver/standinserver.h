@@ -0,0 +1,107 @@
+#ifndef STANDINSERVER_H
+#define STANDINSERVER_H
+
+//Qt
+#include <QObject>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QHash>
+#include <QByteArray>
+#include <QJsonObject>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTimer>
+
+#include "filter.h"
+#include "eventgenerator.h"
+
+//Тестовый сервер для локальной нагрузки клиента: /login, /newuser, /klines, /config и /data
+//с теми же JSON ответами, что у основного сервера. Умеет добавлять задержку и ошибки
+class StandInServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config
+    {
+        quint16 port = 59923;
+        double eventsPerSecond = 1.0;  //частота событий на сессию
+        qsizetype historySize = 60;    //количество свечей в истории события
+        qsizetype moneyCount = 50;     //количество монет каждой биржи в каталоге
+        int latency = 0;               //ms задержка ответа
+        int latencyJitter = 0;         //ms случайная добавка к задержке
+        double errorRate = 0.0;        //доля запросов, завершающихся ошибкой HTTP 503
+        double logoutRate = 0.0;       //доля запросов /data, завершающих сессию
+        int sessionTimeout = 60000;    //ms сессия без запросов /data удаляется
+        quint32 seed = 0;
+    };
+
+public:
+    explicit StandInServer(const Config& config, QObject *parent = nullptr);
+
+    bool start();
+
+private slots:
+    void newConnection();
+    void printStatistic();
+    void removeExpiredSessions();
+
+private:
+    struct User
+    {
+        QString password;
+        Filter filter;
+    };
+
+    struct Session
+    {
+        QString user;
+        QElapsedTimer lastPoll; //время последнего запроса /data
+        double pendingEvents = 0.0; //дробная часть событий, не отданных в прошлых ответах
+    };
+
+    struct Request
+    {
+        QByteArray method;
+        QString path;
+        QByteArray body;
+    };
+
+private:
+    void readRequest(QTcpSocket *socket);
+    void sendResponse(QTcpSocket *socket, int code, const QByteArray& body);
+    static QByteArray makeResponse(int code, const QByteArray& body);
+
+    QJsonObject handle(const Request& request);
+    QJsonObject newUser(const QStringList& args);
+    QJsonObject login(const QStringList& args);
+    QJsonObject klines(const QStringList& args);
+    QJsonObject config(const QStringList& args, const QByteArray& body);
+    QJsonObject data(const QStringList& args);
+
+    Session* findSession(const QStringList& args);
+
+    static QJsonObject makeResult(const QString& result, const QString& message = QString());
+
+private:
+    const Config _config;
+
+    QTcpServer _server;
+    QHash<QTcpSocket*, QByteArray> _buffers; //принятые, но еще не разобранные данные соединений
+
+    EventGenerator _generator;
+    QRandomGenerator _random;
+
+    QHash<QString, User> _users;
+    QHash<int, Session> _sessions;
+    int _lastSessionID = 0;
+
+    QTimer _statisticTimer;
+    QTimer _sessionTimer; //проверка сессий, которые клиент бросил без выхода
+    quint64 _expiredSessionCount = 0;
+    quint64 _requestCount = 0;
+    quint64 _errorCount = 0;
+    quint64 _eventCount = 0;
+};
+
+#endif // STANDINSERVER_H
@@ -0,0 +1,209 @@
+//STL
+#include <algorithm>
+
+//Qt
+#include <QtTest>
+
+#include "types.h"
+#include "filter.h"
+
+static const QString STOCK_EXCHANGE = "BINANCE";
+
+//Нормализация фильтра и построение разности, отправляемой на сервер
+class FilterTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void normalize_data();
+    void normalize();
+
+    void diff_data();
+    void diff();
+
+    void applyDiffUnknownChanged();
+
+private:
+    static Filter::FilterData makeRule(const QString& symbol, KLineType type, double delta, double volume,
+                                       const QString& stockExchange = STOCK_EXCHANGE);
+    static QString toString(const Filter::FilterDataList& rules); //без учета порядка правил
+};
+
+void FilterTest::normalize_data()
+{
+    QTest::addColumn<Filter::FilterDataList>("rules");
+    QTest::addColumn<ExistsStockExchange>("catalog");
+    QTest::addColumn<Filter::FilterDataList>("expected");
+
+    const auto strong = makeRule("BTCUSDT", KLineType::MIN1, 5.0, 1000.0);
+    const auto weak = makeRule("BTCUSDT", KLineType::MIN1, 10.0, 2000.0);
+    const auto lowDelta = makeRule("BTCUSDT", KLineType::MIN1, 5.0, 2000.0);
+    const auto lowVolume = makeRule("BTCUSDT", KLineType::MIN1, 10.0, 1000.0);
+    const auto all = makeRule("ALL", KLineType::MIN1, 5.0, 1000.0);
+
+    QTest::newRow("exact duplicate") << Filter::FilterDataList{strong, strong} << ExistsStockExchange{} << Filter::FilterDataList{strong};
+    QTest::newRow("dominated rule after") << Filter::FilterDataList{strong, weak} << ExistsStockExchange{} << Filter::FilterDataList{strong};
+    QTest::newRow("dominated rule before") << Filter::FilterDataList{weak, strong} << ExistsStockExchange{} << Filter::FilterDataList{strong};
+    QTest::newRow("incomparable rules") << Filter::FilterDataList{lowDelta, lowVolume} << ExistsStockExchange{}
+                                        << Filter::FilterDataList{lowDelta, lowVolume};
+    QTest::newRow("dominates both") << Filter::FilterDataList{lowDelta, lowVolume, strong} << ExistsStockExchange{}
+                                    << Filter::FilterDataList{strong};
+
+    QTest::newRow("ALL subsumes money") << Filter::FilterDataList{weak, all} << ExistsStockExchange{} << Filter::FilterDataList{all};
+    QTest::newRow("ALL subsumes equal rule") << Filter::FilterDataList{all, strong} << ExistsStockExchange{} << Filter::FilterDataList{all};
+    QTest::newRow("weaker ALL") << Filter::FilterDataList{strong, makeRule("ALL", KLineType::MIN1, 10.0, 1000.0)} << ExistsStockExchange{}
+                                << Filter::FilterDataList{strong, makeRule("ALL", KLineType::MIN1, 10.0, 1000.0)};
+    QTest::newRow("ALL of other interval") << Filter::FilterDataList{weak, makeRule("ALL", KLineType::MIN5, 5.0, 1000.0)} << ExistsStockExchange{}
+                                           << Filter::FilterDataList{weak, makeRule("ALL", KLineType::MIN5, 5.0, 1000.0)};
+    QTest::newRow("ALL of other stock exchange") << Filter::FilterDataList{weak, makeRule("ALL", KLineType::MIN1, 5.0, 1000.0, "KUCOIN")}
+                                                 << ExistsStockExchange{}
+                                                 << Filter::FilterDataList{weak, makeRule("ALL", KLineType::MIN1, 5.0, 1000.0, "KUCOIN")};
+
+    ExistsStockExchange catalog;
+    catalog[STOCK_EXCHANGE]["BTCUSDT"].insert(KLineTypeToString(KLineType::MIN1));
+
+    QTest::newRow("unknown money") << Filter::FilterDataList{strong, makeRule("ETHUSDT", KLineType::MIN1, 5.0, 1000.0)} << catalog
+                                   << Filter::FilterDataList{strong};
+    QTest::newRow("unknown interval") << Filter::FilterDataList{strong, makeRule("BTCUSDT", KLineType::MIN5, 5.0, 1000.0)} << catalog
+                                      << Filter::FilterDataList{strong};
+    QTest::newRow("unknown stock exchange") << Filter::FilterDataList{strong, makeRule("BTCUSDT", KLineType::MIN1, 5.0, 1000.0, "KUCOIN")} << catalog
+                                            << Filter::FilterDataList{strong};
+    QTest::newRow("ALL in catalog check") << Filter::FilterDataList{all, weak} << catalog << Filter::FilterDataList{all};
+}
+
+void FilterTest::normalize()
+{
+    QFETCH(Filter::FilterDataList, rules);
+    QFETCH(ExistsStockExchange, catalog);
+    QFETCH(Filter::FilterDataList, expected);
+
+    Filter filter;
+    filter.fromList(rules);
+
+    QCOMPARE(filter.normalize(catalog), rules.size() - expected.size());
+    QCOMPARE(toString(filter.toList()), toString(expected));
+
+    //повторная нормализация ничего не меняет
+    QCOMPARE(filter.normalize(catalog), 0);
+}
+
+void FilterTest::diff_data()
+{
+    QTest::addColumn<Filter::FilterDataList>("oldRules");
+    QTest::addColumn<Filter::FilterDataList>("newRules");
+    QTest::addColumn<bool>("isValid");
+    QTest::addColumn<qsizetype>("addedCount");
+    QTest::addColumn<qsizetype>("changedCount");
+    QTest::addColumn<qsizetype>("removedCount");
+
+    const auto btc = makeRule("BTCUSDT", KLineType::MIN1, 5.0, 1000.0);
+    const auto btcChanged = makeRule("BTCUSDT", KLineType::MIN1, 7.0, 1000.0);
+    const auto btc5m = makeRule("BTCUSDT", KLineType::MIN5, 5.0, 1000.0);
+    const auto eth = makeRule("ETHUSDT", KLineType::MIN1, 5.0, 1000.0);
+
+    QTest::newRow("equal") << Filter::FilterDataList{btc, eth} << Filter::FilterDataList{eth, btc} << true
+                           << qsizetype(0) << qsizetype(0) << qsizetype(0);
+    QTest::newRow("added") << Filter::FilterDataList{btc} << Filter::FilterDataList{btc, eth, btc5m} << true
+                           << qsizetype(2) << qsizetype(0) << qsizetype(0);
+    QTest::newRow("changed") << Filter::FilterDataList{btc, eth} << Filter::FilterDataList{btcChanged, eth} << true
+                             << qsizetype(0) << qsizetype(1) << qsizetype(0);
+    QTest::newRow("removed") << Filter::FilterDataList{btc, eth} << Filter::FilterDataList{eth} << true
+                             << qsizetype(0) << qsizetype(0) << qsizetype(1);
+    QTest::newRow("all kinds") << Filter::FilterDataList{btc, eth} << Filter::FilterDataList{btcChanged, btc5m} << true
+                               << qsizetype(1) << qsizetype(1) << qsizetype(1);
+    QTest::newRow("from empty") << Filter::FilterDataList{} << Filter::FilterDataList{btc, eth} << true
+                                << qsizetype(2) << qsizetype(0) << qsizetype(0);
+
+    //правила с одинаковым ключом: по разности нельзя понять, какое из них изменилось
+    QTest::newRow("duplicate key in old") << Filter::FilterDataList{btc, btcChanged} << Filter::FilterDataList{btc} << false
+                                          << qsizetype(0) << qsizetype(0) << qsizetype(0);
+    QTest::newRow("duplicate key in new") << Filter::FilterDataList{btc} << Filter::FilterDataList{btc, btcChanged} << false
+                                          << qsizetype(0) << qsizetype(0) << qsizetype(0);
+    QTest::newRow("exact duplicate in new") << Filter::FilterDataList{btc} << Filter::FilterDataList{eth, eth} << false
+                                            << qsizetype(0) << qsizetype(0) << qsizetype(0);
+}
+
+void FilterTest::diff()
+{
+    QFETCH(Filter::FilterDataList, oldRules);
+    QFETCH(Filter::FilterDataList, newRules);
+    QFETCH(bool, isValid);
+    QFETCH(qsizetype, addedCount);
+    QFETCH(qsizetype, changedCount);
+    QFETCH(qsizetype, removedCount);
+
+    Filter oldFilter;
+    oldFilter.fromList(oldRules);
+    Filter newFilter;
+    newFilter.fromList(newRules);
+
+    const auto filterDiff = oldFilter.diff(newFilter);
+    QCOMPARE(filterDiff.has_value(), isValid);
+    if (!isValid)
+    {
+        return;
+    }
+
+    QCOMPARE(filterDiff->added.size(), addedCount);
+    QCOMPARE(filterDiff->changed.size(), changedCount);
+    QCOMPARE(filterDiff->removed.size(), removedCount);
+    QCOMPARE(filterDiff->isEmpty(), addedCount + changedCount + removedCount == 0);
+
+    //сервер применяет разность в JSON к своей копии фильтра и получает новый фильтр
+    Filter serverFilter;
+    serverFilter.fromList(oldRules);
+    serverFilter.applyDiff(filterDiff->toJSON());
+
+    QVERIFY2(!serverFilter.isError(), qPrintable(serverFilter.errorString()));
+    QCOMPARE(toString(serverFilter.toList()), toString(newRules));
+}
+
+void FilterTest::applyDiffUnknownChanged()
+{
+    //измененное правило отсутствует в фильтре - ошибка, правило добавляется
+    Filter filter;
+    filter.fromList({makeRule("BTCUSDT", KLineType::MIN1, 5.0, 1000.0)});
+
+    Filter::FilterDiff filterDiff;
+    filterDiff.changed.push_back(makeRule("ETHUSDT", KLineType::MIN1, 5.0, 1000.0));
+
+    filter.applyDiff(filterDiff.toJSON());
+
+    QVERIFY(filter.isError());
+    QCOMPARE(filter.toList().size(), 2);
+}
+
+Filter::FilterData FilterTest::makeRule(const QString &symbol, KLineType type, double delta, double volume,
+                                        const QString &stockExchange /* = STOCK_EXCHANGE */)
+{
+    Filter::FilterData filterData;
+    filterData.stockExchangeID = StockExchangeID{stockExchange};
+    filterData.klineID.symbol = symbol;
+    filterData.klineID.type = type;
+    filterData.delta = delta;
+    filterData.volume = volume;
+
+    return filterData;
+}
+
+QString FilterTest::toString(const Filter::FilterDataList &rules)
+{
+    QStringList result;
+    for (const auto& filterData: rules)
+    {
+        result.push_back(QString("%1 %2 %3 %4 %5")
+                             .arg(filterData.stockExchangeID.name)
+                             .arg(filterData.klineID.symbol)
+                             .arg(KLineTypeToString(filterData.klineID.type))
+                             .arg(filterData.delta)
+                             .arg(filterData.volume));
+    }
+
+    result.sort();
+
+    return result.join("; ");
+}
+
+QTEST_APPLESS_MAIN(FilterTest)
+
+#include "tst_filter.moc"
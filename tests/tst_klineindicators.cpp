@@ -0,0 +1,335 @@
+//STL
+#include <algorithm>
+#include <cmath>
+
+//Qt
+#include <QtTest>
+#include <QRandomGenerator>
+
+#include "types.h"
+#include "klineindicators.h"
+
+static const qsizetype CHECK_KLINE_COUNT = 1000; //свечей в проверке - эталон пересчитывается с начала для каждой свечи
+static const double TOLERANCE = 1e-9; //относительная погрешность инкрементального расчета
+static const double DEVIATION_TOLERANCE = 1e-7; //стандартное отклонение считается через разность сумм
+
+//Инкрементальные индикаторы сравниваются с полным пересчетом по определению на каждой свече
+class KLineIndicatorsTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+
+    void sma();
+    void ema();
+    void rsi();
+    void bollinger();
+    void atr();
+    void vwap();
+    void makeOrder();
+
+private:
+    static KLines makeKLines(qsizetype count, quint32 seed);
+    static bool isClose(double value, double expected, double tolerance = TOLERANCE);
+
+    static QList<double> closes(const KLines& klines, qsizetype count);
+    static double mean(const QList<double>& values, qsizetype first, qsizetype count);
+    static double expectedEMA(const QList<double>& values, qsizetype period);
+    static double expectedRSI(const QList<double>& values, qsizetype period);
+    static double expectedATR(const KLines& klines, qsizetype count, qsizetype period);
+
+private:
+    KLines _klines;
+};
+
+void KLineIndicatorsTest::initTestCase()
+{
+    _klines = makeKLines(CHECK_KLINE_COUNT, 1);
+}
+
+void KLineIndicatorsTest::sma()
+{
+    const auto period = KLineIndicators::PERIOD;
+    const auto values = closes(_klines, _klines.size());
+
+    SMAIndicator indicator(period);
+    for (qsizetype i = 0; i < values.size(); ++i)
+    {
+        indicator.append(values[i]);
+
+        QCOMPARE(indicator.isReady(), i + 1 >= period);
+
+        const auto count = std::min(i + 1, period);
+        QVERIFY2(isClose(indicator.value(), mean(values, i + 1 - count, count)), qPrintable(QString("kline %1").arg(i)));
+    }
+}
+
+void KLineIndicatorsTest::ema()
+{
+    const auto period = KLineIndicators::PERIOD;
+    const auto values = closes(_klines, _klines.size());
+
+    EMAIndicator indicator(period);
+    for (qsizetype i = 0; i < values.size(); ++i)
+    {
+        indicator.append(values[i]);
+
+        QCOMPARE(indicator.isReady(), i + 1 >= period);
+        if (indicator.isReady())
+        {
+            QVERIFY2(isClose(indicator.value(), expectedEMA(values.first(i + 1), period)), qPrintable(QString("kline %1").arg(i)));
+        }
+    }
+}
+
+void KLineIndicatorsTest::rsi()
+{
+    const auto period = KLineIndicators::WILDER_PERIOD;
+    const auto values = closes(_klines, _klines.size());
+
+    RSIIndicator indicator(period);
+    for (qsizetype i = 0; i < values.size(); ++i)
+    {
+        indicator.append(_klines[i]);
+
+        //первая свеча дает только цену закрытия, готовность - после period изменений цены
+        QCOMPARE(indicator.isReady(), i >= period);
+        if (indicator.isReady())
+        {
+            QVERIFY2(isClose(indicator.value(), expectedRSI(values.first(i + 1), period)), qPrintable(QString("kline %1").arg(i)));
+        }
+    }
+}
+
+void KLineIndicatorsTest::bollinger()
+{
+    const auto period = KLineIndicators::PERIOD;
+    const auto values = closes(_klines, _klines.size());
+
+    BollingerIndicator indicator(period, 2.0);
+    for (qsizetype i = 0; i < values.size(); ++i)
+    {
+        indicator.append(values[i]);
+
+        QCOMPARE(indicator.isReady(), i + 1 >= period);
+        if (!indicator.isReady())
+        {
+            continue;
+        }
+
+        const auto middle = mean(values, i + 1 - period, period);
+
+        double variance = 0.0;
+        for (qsizetype j = i + 1 - period; j <= i; ++j)
+        {
+            variance += (values[j] - middle) * (values[j] - middle);
+        }
+        const auto deviation = std::sqrt(variance / static_cast<double>(period));
+
+        QVERIFY2(isClose(indicator.middle(), middle), qPrintable(QString("kline %1").arg(i)));
+        QVERIFY2(isClose(indicator.upper(), middle + 2.0 * deviation, DEVIATION_TOLERANCE), qPrintable(QString("kline %1").arg(i)));
+        QVERIFY2(isClose(indicator.lower(), middle - 2.0 * deviation, DEVIATION_TOLERANCE), qPrintable(QString("kline %1").arg(i)));
+    }
+}
+
+void KLineIndicatorsTest::atr()
+{
+    const auto period = KLineIndicators::WILDER_PERIOD;
+
+    ATRIndicator indicator(period);
+    for (qsizetype i = 0; i < _klines.size(); ++i)
+    {
+        indicator.append(_klines[i]);
+
+        QCOMPARE(indicator.isReady(), i + 1 >= period);
+        if (indicator.isReady())
+        {
+            QVERIFY2(isClose(indicator.value(), expectedATR(_klines, i + 1, period)), qPrintable(QString("kline %1").arg(i)));
+        }
+    }
+}
+
+void KLineIndicatorsTest::vwap()
+{
+    VWAPIndicator indicator;
+    QVERIFY(!indicator.isReady());
+
+    for (qsizetype i = 0; i < _klines.size(); ++i)
+    {
+        indicator.append(_klines[i]);
+
+        QVERIFY(indicator.isReady());
+
+        double sumPriceVolume = 0.0;
+        double sumVolume = 0.0;
+        for (qsizetype j = 0; j <= i; ++j)
+        {
+            const auto& kline = _klines[j];
+            sumPriceVolume += (kline.high + kline.low + kline.close) / 3.0 * kline.volume;
+            sumVolume += kline.volume;
+        }
+
+        //пока объема нет - типичная цена последней свечи
+        const auto& kline = _klines[i];
+        const auto expected = sumVolume > 0.0 ? sumPriceVolume / sumVolume : (kline.high + kline.low + kline.close) / 3.0;
+
+        QVERIFY2(isClose(indicator.value(), expected), qPrintable(QString("kline %1").arg(i)));
+    }
+}
+
+void KLineIndicatorsTest::makeOrder()
+{
+    //история события хранится от новых свечей к старым - линии должны совпадать с расчетом по возрастанию времени
+    KLines reversedKLines(_klines.rbegin(), _klines.rend());
+
+    for (const auto type: {KLineIndicators::Type::SMA, KLineIndicators::Type::EMA, KLineIndicators::Type::BOLLINGER,
+                           KLineIndicators::Type::VWAP, KLineIndicators::Type::RSI, KLineIndicators::Type::ATR})
+    {
+        const auto indicators = KLineIndicators::make(type, _klines);
+        const auto reversedIndicators = KLineIndicators::make(type, reversedKLines);
+
+        QCOMPARE(reversedIndicators.line(), indicators.line());
+        QCOMPARE(reversedIndicators.upper(), indicators.upper());
+        QCOMPARE(reversedIndicators.lower(), indicators.lower());
+
+        QVERIFY(indicators.isReady());
+        QCOMPARE(indicators.line().last().x(), static_cast<qreal>(_klines.last().closeTime.toMSecsSinceEpoch()));
+    }
+}
+
+KLines KLineIndicatorsTest::makeKLines(qsizetype count, quint32 seed)
+{
+    //случайное блуждание цены. Первые свечи без объема проверяют VWAP до появления объема
+    QRandomGenerator generator(seed);
+
+    const auto startTime = QDateTime::fromMSecsSinceEpoch(1700000000000);
+    const auto interval = static_cast<qint64>(KLineType::MIN1);
+
+    KLines result;
+    result.reserve(count);
+
+    double price = 100.0;
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        KLine kline;
+        kline.id.symbol = "TESTUSDT";
+        kline.id.type = KLineType::MIN1;
+        kline.openTime = startTime.addMSecs(i * interval);
+        kline.closeTime = kline.openTime.addMSecs(interval - 1);
+        kline.open = price;
+        price = std::max(price + (generator.generateDouble() - 0.5) * 2.0, 1.0);
+        kline.close = price;
+        kline.high = std::max(kline.open, kline.close) + generator.generateDouble();
+        kline.low = std::max(std::min(kline.open, kline.close) - generator.generateDouble(), 0.5);
+        kline.volume = i < 5 ? 0.0 : generator.generateDouble() * 1000.0;
+        kline.quoteAssetVolume = kline.volume * price;
+
+        result.push_back(kline);
+    }
+
+    return result;
+}
+
+bool KLineIndicatorsTest::isClose(double value, double expected, double tolerance /* = TOLERANCE */)
+{
+    return std::abs(value - expected) <= tolerance * std::max(1.0, std::abs(expected));
+}
+
+QList<double> KLineIndicatorsTest::closes(const KLines &klines, qsizetype count)
+{
+    QList<double> result;
+    result.reserve(count);
+
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        result.push_back(klines[i].close);
+    }
+
+    return result;
+}
+
+double KLineIndicatorsTest::mean(const QList<double> &values, qsizetype first, qsizetype count)
+{
+    double sum = 0.0;
+    for (qsizetype i = first; i < first + count; ++i)
+    {
+        sum += values[i];
+    }
+
+    return sum / static_cast<double>(count);
+}
+
+double KLineIndicatorsTest::expectedEMA(const QList<double> &values, qsizetype period)
+{
+    //первое значение - SMA первых period значений, далее сглаживание с alpha = 2 / (period + 1)
+    const auto alpha = 2.0 / (static_cast<double>(period) + 1.0);
+
+    auto result = mean(values, 0, period);
+    for (qsizetype i = period; i < values.size(); ++i)
+    {
+        result += alpha * (values[i] - result);
+    }
+
+    return result;
+}
+
+double KLineIndicatorsTest::expectedRSI(const QList<double> &values, qsizetype period)
+{
+    //средние первых period изменений цены, далее сглаживание Уайлдера
+    double avgGain = 0.0;
+    double avgLoss = 0.0;
+    for (qsizetype i = 1; i <= period; ++i)
+    {
+        const auto change = values[i] - values[i - 1];
+        avgGain += std::max(change, 0.0);
+        avgLoss += std::max(-change, 0.0);
+    }
+    avgGain /= static_cast<double>(period);
+    avgLoss /= static_cast<double>(period);
+
+    for (qsizetype i = period + 1; i < values.size(); ++i)
+    {
+        const auto change = values[i] - values[i - 1];
+        avgGain = (avgGain * static_cast<double>(period - 1) + std::max(change, 0.0)) / static_cast<double>(period);
+        avgLoss = (avgLoss * static_cast<double>(period - 1) + std::max(-change, 0.0)) / static_cast<double>(period);
+    }
+
+    if (avgLoss == 0.0)
+    {
+        return avgGain == 0.0 ? 50.0 : 100.0;
+    }
+
+    return 100.0 - 100.0 / (1.0 + avgGain / avgLoss);
+}
+
+double KLineIndicatorsTest::expectedATR(const KLines &klines, qsizetype count, qsizetype period)
+{
+    QList<double> trueRanges;
+    trueRanges.reserve(count);
+
+    for (qsizetype i = 0; i < count; ++i)
+    {
+        const auto& kline = klines[i];
+        auto trueRange = kline.high - kline.low;
+        if (i > 0)
+        {
+            const auto prevClose = klines[i - 1].close;
+            trueRange = std::max({trueRange, std::abs(kline.high - prevClose), std::abs(kline.low - prevClose)});
+        }
+
+        trueRanges.push_back(trueRange);
+    }
+
+    auto result = mean(trueRanges, 0, period);
+    for (qsizetype i = period; i < count; ++i)
+    {
+        result = (result * static_cast<double>(period - 1) + trueRanges[i]) / static_cast<double>(period);
+    }
+
+    return result;
+}
+
+QTEST_APPLESS_MAIN(KLineIndicatorsTest)
+
+#include "tst_klineindicators.moc"
@@ -0,0 +1,193 @@
+//STL
+#include <algorithm>
+#include <limits>
+
+//Qt
+#include <QtTest>
+
+#include "types.h"
+#include "klineresampler.h"
+
+//Границы свечей старшего интервала: UTC, недельные свечи начинаются с понедельника
+class KLineResamplerTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void bucketStart_data();
+    void bucketStart();
+
+    void resample_data();
+    void resample();
+
+private:
+    static qint64 toMSecs(const QString& time); //ISO время UTC
+    static KLines makeKLines(qint64 begin, qint64 end, KLineType type);
+};
+
+void KLineResamplerTest::bucketStart_data()
+{
+    QTest::addColumn<QString>("time");
+    QTest::addColumn<KLineType>("type");
+    QTest::addColumn<QString>("expected");
+
+    QTest::newRow("1h") << "2024-01-03T10:37:12Z" << KLineType::MIN60 << "2024-01-03T10:00:00Z";
+    QTest::newRow("4h") << "2024-01-03T10:37:12Z" << KLineType::HOUR4 << "2024-01-03T08:00:00Z";
+    QTest::newRow("8h") << "2024-01-03T07:59:59Z" << KLineType::HOUR8 << "2024-01-03T00:00:00Z";
+    QTest::newRow("1d") << "2024-01-03T23:59:59Z" << KLineType::DAY1 << "2024-01-03T00:00:00Z";
+    QTest::newRow("1d start") << "2024-01-03T00:00:00Z" << KLineType::DAY1 << "2024-01-03T00:00:00Z";
+
+    //2024-01-01 - понедельник
+    QTest::newRow("1w wednesday") << "2024-01-03T10:37:12Z" << KLineType::WEEK1 << "2024-01-01T00:00:00Z";
+    QTest::newRow("1w monday start") << "2024-01-01T00:00:00Z" << KLineType::WEEK1 << "2024-01-01T00:00:00Z";
+    QTest::newRow("1w sunday end") << "2024-01-07T23:59:59Z" << KLineType::WEEK1 << "2024-01-01T00:00:00Z";
+    QTest::newRow("1w next monday") << "2024-01-08T00:00:00Z" << KLineType::WEEK1 << "2024-01-08T00:00:00Z";
+    QTest::newRow("1w across year") << "2023-12-31T12:00:00Z" << KLineType::WEEK1 << "2023-12-25T00:00:00Z";
+
+    //1970-01-01 - четверг: неделя начинается до эпохи
+    QTest::newRow("1w epoch") << "1970-01-01T00:00:00Z" << KLineType::WEEK1 << "1969-12-29T00:00:00Z";
+    QTest::newRow("1w before epoch") << "1969-12-31T12:00:00Z" << KLineType::WEEK1 << "1969-12-29T00:00:00Z";
+    QTest::newRow("1d before epoch") << "1969-12-31T12:00:00Z" << KLineType::DAY1 << "1969-12-31T00:00:00Z";
+}
+
+void KLineResamplerTest::bucketStart()
+{
+    QFETCH(QString, time);
+    QFETCH(KLineType, type);
+    QFETCH(QString, expected);
+
+    const auto start = KLineResampler::bucketStart(toMSecs(time), type);
+    QCOMPARE(QDateTime::fromMSecsSinceEpoch(start).toUTC().toString(Qt::ISODate), expected);
+}
+
+void KLineResamplerTest::resample_data()
+{
+    QTest::addColumn<KLineType>("from");
+    QTest::addColumn<KLineType>("to");
+    QTest::addColumn<QString>("begin");
+    QTest::addColumn<QString>("end");
+    QTest::addColumn<bool>("isDescending");
+    QTest::addColumn<qsizetype>("expectedCount");
+
+    //пятница - среда: неполная первая и последняя неделя
+    QTest::newRow("1h to 1w") << KLineType::MIN60 << KLineType::WEEK1 << "2024-01-05T00:00:00Z" << "2024-01-10T00:00:00Z" << false << qsizetype(2);
+    QTest::newRow("1h to 1w descending") << KLineType::MIN60 << KLineType::WEEK1 << "2024-01-05T00:00:00Z" << "2024-01-10T00:00:00Z" << true << qsizetype(2);
+    QTest::newRow("4h to 1w, 3 weeks") << KLineType::HOUR4 << KLineType::WEEK1 << "2023-12-27T00:00:00Z" << "2024-01-16T00:00:00Z" << false << qsizetype(4);
+    QTest::newRow("1d to 1w") << KLineType::DAY1 << KLineType::WEEK1 << "2023-12-01T00:00:00Z" << "2024-01-01T00:00:00Z" << false << qsizetype(5);
+    QTest::newRow("15m to 1d") << KLineType::MIN15 << KLineType::DAY1 << "2024-01-03T18:00:00Z" << "2024-01-05T06:00:00Z" << false << qsizetype(3);
+    QTest::newRow("1m to 4h descending") << KLineType::MIN1 << KLineType::HOUR4 << "2024-01-03T07:00:00Z" << "2024-01-03T13:00:00Z" << true << qsizetype(3);
+}
+
+void KLineResamplerTest::resample()
+{
+    QFETCH(KLineType, from);
+    QFETCH(KLineType, to);
+    QFETCH(QString, begin);
+    QFETCH(QString, end);
+    QFETCH(bool, isDescending);
+    QFETCH(qsizetype, expectedCount);
+
+    QVERIFY(KLineResampler::canResample(from, to));
+
+    auto klines = makeKLines(toMSecs(begin), toMSecs(end), from);
+    if (isDescending)
+    {
+        std::reverse(klines.begin(), klines.end());
+    }
+
+    auto result = KLineResampler::resample(klines, to);
+    QCOMPARE(result.size(), expectedCount);
+
+    //порядок результата как у исходных свечей
+    if (isDescending)
+    {
+        std::reverse(result.begin(), result.end());
+    }
+
+    const auto interval = static_cast<qint64>(to);
+    qint64 previousOpenTime = std::numeric_limits<qint64>::min();
+    for (const auto& kline: result)
+    {
+        const auto openTime = kline.openTime.toMSecsSinceEpoch();
+        QVERIFY(openTime > previousOpenTime);
+        previousOpenTime = openTime;
+
+        QVERIFY(kline.id.type == to);
+        QCOMPARE(kline.closeTime.toMSecsSinceEpoch(), openTime + interval - 1);
+
+        const auto openDateTime = QDateTime::fromMSecsSinceEpoch(openTime).toUTC();
+        QCOMPARE(openDateTime.time(), QTime(0, 0));
+        if (to == KLineType::WEEK1)
+        {
+            QCOMPARE(openDateTime.date().dayOfWeek(), int(Qt::Monday));
+        }
+
+        //свеча собрана из всех исходных свечей своего интервала
+        KLines sources;
+        for (const auto& source: klines)
+        {
+            const auto sourceOpenTime = source.openTime.toMSecsSinceEpoch();
+            if (sourceOpenTime >= openTime && sourceOpenTime < openTime + interval)
+            {
+                sources.push_back(source);
+            }
+        }
+
+        if (isDescending)
+        {
+            std::reverse(sources.begin(), sources.end());
+        }
+
+        QVERIFY(!sources.isEmpty());
+        QCOMPARE(kline.open, sources.first().open);
+        QCOMPARE(kline.close, sources.last().close);
+        QCOMPARE(kline.high, std::max_element(sources.begin(), sources.end(), [](const KLine& kline1, const KLine& kline2){ return kline1.high < kline2.high; })->high);
+        QCOMPARE(kline.low, std::min_element(sources.begin(), sources.end(), [](const KLine& kline1, const KLine& kline2){ return kline1.low < kline2.low; })->low);
+
+        double volume = 0.0;
+        for (const auto& source: sources)
+        {
+            volume += source.volume;
+        }
+        QCOMPARE(kline.volume, volume);
+    }
+}
+
+qint64 KLineResamplerTest::toMSecs(const QString &time)
+{
+    const auto result = QDateTime::fromString(time, Qt::ISODate);
+    Q_ASSERT(result.isValid());
+
+    return result.toMSecsSinceEpoch();
+}
+
+KLines KLineResamplerTest::makeKLines(qint64 begin, qint64 end, KLineType type)
+{
+    //значения различаются у каждой свечи, объем - целый, чтобы сумма не зависела от порядка сложения
+    const auto interval = static_cast<qint64>(type);
+
+    KLines result;
+    qsizetype index = 0;
+    for (auto openTime = begin; openTime < end; openTime += interval, ++index)
+    {
+        KLine kline;
+        kline.id.symbol = "TESTUSDT";
+        kline.id.type = type;
+        kline.openTime = QDateTime::fromMSecsSinceEpoch(openTime);
+        kline.closeTime = QDateTime::fromMSecsSinceEpoch(openTime + interval - 1);
+        kline.open = 100.0 + index % 17;
+        kline.close = 100.0 + index % 13;
+        kline.high = std::max(kline.open, kline.close) + index % 7;
+        kline.low = std::min(kline.open, kline.close) - index % 5;
+        kline.volume = 1.0 + index % 11;
+        kline.quoteAssetVolume = kline.volume * kline.close;
+
+        result.push_back(kline);
+    }
+
+    return result;
+}
+
+QTEST_APPLESS_MAIN(KLineResamplerTest)
+
+#include "tst_klineresampler.moc"
@@ -0,0 +1,179 @@
+//Qt
+#include <QtTest>
+
+#include "types.h"
+#include "filter.h"
+#include "spikedetector.h"
+
+static const qsizetype HISTORY_SIZE = 10; //свечей в истории события
+static const qsizetype SPIKE_INDEX = 3; //индекс всплеска в истории от новых свечей к старым
+static const double SPIKE_DELTA = 10.0; //% delta свечи-всплеска, у остальных свечей 0.5%
+static const double CANDLE_QUOTE_VOLUME = 1000.0; //объем каждой свечи
+
+//Локальный поиск проверяет все новые свечи окна, а не только последнюю
+class SpikeDetectorTest : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void olderCandleInHistory();
+    void detectedCandleNotReported();
+    void setFilterRechecksWindow();
+    void openCandleReportedOnce();
+    void windowOverflow();
+
+private:
+    static KLine makeKLine(qsizetype minute, double delta);
+    static KLines makeHistory(qsizetype size, qsizetype spikeIndex); //от новых свечей к старым, как у событий сервера
+    static Filter::FilterDataList makeFilter(double delta);
+
+private:
+    const StockExchangeID _stockExchangeID{"BINANCE"};
+};
+
+void SpikeDetectorTest::olderCandleInHistory()
+{
+    SpikeDetector spikeDetector;
+    spikeDetector.setFilter(makeFilter(5.0));
+
+    const auto history = makeHistory(HISTORY_SIZE, SPIKE_INDEX);
+    spikeDetector.addKLines(_stockExchangeID, history, true);
+
+    QVERIFY(spikeDetector.hasUpdates());
+
+    const auto events = spikeDetector.detect();
+    QCOMPARE(events.size(), 1);
+
+    const auto& event = events.first();
+    QCOMPARE(event.stockExchangeID.name, _stockExchangeID.name);
+    QVERIFY(qAbs(event.delta - SPIKE_DELTA) < 1e-9);
+    QCOMPARE(event.history.size(), HISTORY_SIZE - SPIKE_INDEX);
+    QCOMPARE(event.history.first().openTime, history[SPIKE_INDEX].openTime);
+    QCOMPARE(event.history.last().openTime, history.last().openTime);
+
+    QVERIFY(!spikeDetector.hasUpdates());
+    QVERIFY(spikeDetector.detect().isEmpty());
+}
+
+void SpikeDetectorTest::detectedCandleNotReported()
+{
+    //всплеск в самой новой свече уже найден сервером
+    SpikeDetector spikeDetector;
+    spikeDetector.setFilter(makeFilter(5.0));
+
+    spikeDetector.addKLines(_stockExchangeID, makeHistory(HISTORY_SIZE, 0), true);
+    QVERIFY(spikeDetector.detect().isEmpty());
+
+    //то же событие пришло повторно
+    spikeDetector.addKLines(_stockExchangeID, makeHistory(HISTORY_SIZE, 0), true);
+    QVERIFY(spikeDetector.detect().isEmpty());
+
+    spikeDetector.setFilter(makeFilter(1.0));
+    QVERIFY(spikeDetector.detect().isEmpty());
+}
+
+void SpikeDetectorTest::setFilterRechecksWindow()
+{
+    SpikeDetector spikeDetector;
+    spikeDetector.setFilter(makeFilter(20.0));
+
+    spikeDetector.addKLines(_stockExchangeID, makeHistory(HISTORY_SIZE, SPIKE_INDEX), true);
+    QVERIFY(spikeDetector.detect().isEmpty());
+
+    //более низкий порог находит свечу, проверенную на прошлом такте
+    spikeDetector.setFilter(makeFilter(5.0));
+    QVERIFY(spikeDetector.hasUpdates());
+
+    const auto events = spikeDetector.detect();
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events.first().history.size(), HISTORY_SIZE - SPIKE_INDEX);
+
+    //найденная свеча не сообщается повторно
+    spikeDetector.setFilter(makeFilter(1.0));
+    QVERIFY(spikeDetector.detect().isEmpty());
+}
+
+void SpikeDetectorTest::openCandleReportedOnce()
+{
+    SpikeDetector spikeDetector;
+    spikeDetector.setFilter(makeFilter(5.0));
+
+    spikeDetector.addKLine(_stockExchangeID, makeKLine(0, 0.5));
+    QVERIFY(spikeDetector.detect().isEmpty());
+
+    //незакрытая свеча выросла выше порога между тактами
+    spikeDetector.addKLine(_stockExchangeID, makeKLine(0, 2.0));
+    spikeDetector.addKLine(_stockExchangeID, makeKLine(0, SPIKE_DELTA));
+    QCOMPARE(spikeDetector.detect().size(), 1);
+
+    spikeDetector.addKLine(_stockExchangeID, makeKLine(0, SPIKE_DELTA * 2));
+    QVERIFY(spikeDetector.detect().isEmpty());
+
+    //более старая свеча пропускается
+    spikeDetector.addKLine(_stockExchangeID, makeKLine(-1, SPIKE_DELTA));
+    QVERIFY(!spikeDetector.hasUpdates());
+}
+
+void SpikeDetectorTest::windowOverflow()
+{
+    //между тактами пришло больше свечей, чем помещается в окно: проверяются свечи, оставшиеся в окне
+    const qsizetype windowSize = 5;
+    SpikeDetector spikeDetector(windowSize);
+    spikeDetector.setFilter(makeFilter(5.0));
+
+    for (qsizetype i = 0; i < windowSize * 2; ++i)
+    {
+        spikeDetector.addKLine(_stockExchangeID, makeKLine(i, i == 1 || i == windowSize * 2 - 2 ? SPIKE_DELTA : 0.5));
+    }
+
+    const auto events = spikeDetector.detect();
+    QCOMPARE(events.size(), 1);
+    QCOMPARE(events.first().history.first().openTime, makeKLine(windowSize * 2 - 2, 0.5).openTime);
+    QCOMPARE(events.first().history.size(), windowSize - 1);
+}
+
+KLine SpikeDetectorTest::makeKLine(qsizetype minute, double delta)
+{
+    const auto interval = static_cast<qint64>(KLineType::MIN1);
+
+    KLine kline;
+    kline.id.symbol = "TESTUSDT";
+    kline.id.type = KLineType::MIN1;
+    kline.openTime = QDateTime::fromMSecsSinceEpoch(1700000000000 + minute * interval);
+    kline.closeTime = kline.openTime.addMSecs(interval - 1);
+    kline.low = 100.0;
+    kline.high = kline.low * (1.0 + delta / 100.0);
+    kline.open = kline.low;
+    kline.close = kline.low;
+    kline.volume = CANDLE_QUOTE_VOLUME / kline.low;
+    kline.quoteAssetVolume = CANDLE_QUOTE_VOLUME;
+
+    return kline;
+}
+
+KLines SpikeDetectorTest::makeHistory(qsizetype size, qsizetype spikeIndex)
+{
+    KLines result;
+    for (qsizetype i = 0; i < size; ++i)
+    {
+        result.push_back(makeKLine(size - 1 - i, i == spikeIndex ? SPIKE_DELTA : 0.5));
+    }
+
+    return result;
+}
+
+Filter::FilterDataList SpikeDetectorTest::makeFilter(double delta)
+{
+    Filter::FilterData filterData;
+    filterData.stockExchangeID = StockExchangeID{"BINANCE"};
+    filterData.klineID.symbol = "TESTUSDT";
+    filterData.klineID.type = KLineType::MIN1;
+    filterData.delta = delta;
+    filterData.volume = CANDLE_QUOTE_VOLUME / 2;
+
+    return {filterData};
+}
+
+QTEST_APPLESS_MAIN(SpikeDetectorTest)
+
+#include "tst_spikedetector.moc"
@@ -0,0 +1,172 @@
+//STL
+#include <algorithm>
+#include <chrono>
+
+//Qt
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QList>
+#include <QThread>
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonArray>
+
+#include "tracer.h"
+
+static const auto startTime = std::chrono::steady_clock::now();
+
+//буферы всех потоков. Мьютекс нужен только при первой записи потока, его завершении и при выгрузке.
+//Буферы не удаляются: поток пула может завершиться раньше, чем трасса будет выгружена.
+//Буфер завершившегося потока получает следующий новый поток, поэтому память не растет с числом потоков
+static QMutex buffersMutex;
+static QList<Tracer::ThreadBuffer*> buffers;
+
+//при завершении потока отдает его буфер следующему потоку
+struct ThreadBufferOwner
+{
+    Tracer::ThreadBuffer *buffer = nullptr;
+
+    ~ThreadBufferOwner()
+    {
+        if (buffer != nullptr)
+        {
+            QMutexLocker<QMutex> locker(&buffersMutex);
+
+            buffer->isFree = true;
+        }
+    }
+};
+
+qint64 Tracer::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+void Tracer::record(const char *name, qint64 begin, qint64 end)
+{
+    auto& buffer = threadBuffer();
+
+    const auto head = buffer.head.load(std::memory_order_relaxed);
+    auto& event = buffer.events[head % ThreadBuffer::CAPACITY];
+    event.name = name;
+    event.begin = begin;
+    event.duration = end - begin;
+
+    buffer.head.store(head + 1, std::memory_order_release);
+}
+
+Tracer::ThreadBuffer &Tracer::threadBuffer()
+{
+    thread_local ThreadBufferOwner owner;
+
+    if (owner.buffer == nullptr)
+    {
+        const auto thread = QThread::currentThread();
+        const auto app = QCoreApplication::instance();
+        auto threadName = app != nullptr && thread == app->thread() ? QString("GUI") : thread->objectName();
+
+        QMutexLocker<QMutex> locker(&buffersMutex);
+
+        //события завершившегося потока остаются в буфере и вытесняются новыми, как в кольце одного потока
+        const auto buffers_it = std::find_if(buffers.begin(), buffers.end(),
+            [](const ThreadBuffer* buffer)
+            {
+                return buffer->isFree;
+            });
+
+        if (buffers_it != buffers.end())
+        {
+            owner.buffer = *buffers_it;
+            owner.buffer->isFree = false;
+        }
+        else
+        {
+            owner.buffer = new ThreadBuffer;
+            owner.buffer->threadID = buffers.size() + 1;
+
+            buffers.push_back(owner.buffer);
+        }
+
+        owner.buffer->threadName = threadName.isEmpty() ? QString("Thread %1").arg(owner.buffer->threadID) : threadName;
+    }
+
+    return *owner.buffer;
+}
+
+QByteArray Tracer::toChromeTrace()
+{
+    const auto pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+
+    QMutexLocker<QMutex> locker(&buffersMutex);
+
+    for (const auto buffer: buffers)
+    {
+        QJsonObject threadName;
+        threadName.insert("name", "thread_name");
+        threadName.insert("ph", "M");
+        threadName.insert("pid", pid);
+        threadName.insert("tid", static_cast<qint64>(buffer->threadID));
+        threadName.insert("args", QJsonObject({{"name", buffer->threadName}}));
+        traceEvents.push_back(threadName);
+
+        //поток продолжает писать во время выгрузки. Событие берется, только если после копирования
+        //его слот еще не был перезаписан
+        const auto head = buffer->head.load(std::memory_order_acquire);
+        const auto first = head > ThreadBuffer::CAPACITY ? head - ThreadBuffer::CAPACITY : 0;
+
+        QList<Event> events;
+        events.reserve(head - first);
+        for (auto i = first; i < head; ++i)
+        {
+            events.push_back(buffer->events[i % ThreadBuffer::CAPACITY]);
+        }
+
+        //чтение слотов выше не должно переместиться после повторного чтения head
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        //слот события headAfter мог уже записываться в момент копирования
+        const auto headAfter = buffer->head.load(std::memory_order_relaxed) + 1;
+        const auto overwritten = headAfter > ThreadBuffer::CAPACITY ? headAfter - ThreadBuffer::CAPACITY : 0;
+
+        for (auto i = std::max(first, overwritten); i < head; ++i)
+        {
+            const auto& event = events[i - first];
+
+            QJsonObject jsonEvent;
+            jsonEvent.insert("name", event.name);
+            jsonEvent.insert("cat", "client");
+            jsonEvent.insert("ph", "X");
+            jsonEvent.insert("ts", static_cast<double>(event.begin) / 1000.0);  //us
+            jsonEvent.insert("dur", static_cast<double>(event.duration) / 1000.0);
+            jsonEvent.insert("pid", pid);
+            jsonEvent.insert("tid", static_cast<qint64>(buffer->threadID));
+
+            traceEvents.push_back(jsonEvent);
+        }
+    }
+
+    QJsonObject json;
+    json.insert("traceEvents", traceEvents);
+    json.insert("displayTimeUnit", "ms");
+
+    return QJsonDocument(json).toJson(QJsonDocument::Compact);
+}
+
+bool Tracer::writeChromeTrace(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "Cannot write trace:" << fileName << file.errorString();
+
+        return false;
+    }
+
+    file.write(toChromeTrace());
+
+    return true;
+}
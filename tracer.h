@@ -0,0 +1,79 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+//STL
+#include <array>
+#include <atomic>
+
+//Qt
+#include <QtGlobal>
+#include <QByteArray>
+#include <QString>
+
+//Трассировка этапов обработки в формате Chrome trace event (открывается в Perfetto и chrome://tracing).
+//Включается опцией сборки TRADINGCAT_TRACE, без нее TRACE_SPAN ничего не компилирует
+class Tracer
+{
+public:
+    struct Event
+    {
+        const char *name = nullptr; //имя этапа, строковый литерал
+        qint64 begin = 0;           //ns от старта приложения
+        qint64 duration = 0;        //ns
+    };
+
+    //кольцевой буфер одного потока. Пишет только поток-владелец, поэтому запись не требует блокировок
+    struct ThreadBuffer
+    {
+        static constexpr quint64 CAPACITY = 16384; //последние события потока
+
+        std::array<Event, CAPACITY> events;
+        std::atomic<quint64> head = 0; //количество записанных событий за все время
+        quint32 threadID = 0;
+        QString threadName;
+        bool isFree = false; //поток-владелец завершился, буфер достанется следующему новому потоку
+    };
+
+public:
+    static qint64 now(); //ns от старта приложения
+    static void record(const char *name, qint64 begin, qint64 end);
+
+    static QByteArray toChromeTrace(); //JSON для Perfetto
+    static bool writeChromeTrace(const QString& fileName);
+
+private:
+    static ThreadBuffer& threadBuffer();
+};
+
+//замеряет время от создания до выхода из области видимости
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+        : _name(name)
+        , _begin(Tracer::now())
+    {
+    }
+
+    ~TraceSpan()
+    {
+        Tracer::record(_name, _begin, Tracer::now());
+    }
+
+private:
+    Q_DISABLE_COPY_MOVE(TraceSpan)
+
+    const char *_name = nullptr;
+    const qint64 _begin = 0;
+};
+
+#define TRACE_SPAN_CONCAT_IMPL(a, b) a##b
+#define TRACE_SPAN_CONCAT(a, b) TRACE_SPAN_CONCAT_IMPL(a, b)
+
+#ifdef TRADINGCAT_TRACE
+    #define TRACE_SPAN(name) const TraceSpan TRACE_SPAN_CONCAT(traceSpan_, __LINE__)(name)
+#else
+    #define TRACE_SPAN(name) do {} while (false)
+#endif
+
+#endif // TRACER_H
@@ -1,3 +1,7 @@
+//STL
+#include <algorithm>
+#include <cmath>
+
 #include "types.h"
 
 QString KLineTypeToString(KLineType type)
@@ -72,6 +76,309 @@ double volumeKLine(const KLine &kline)
     return ((kline.open + kline.close) / 2) * kline.volume;
 }
 
+SMAIndicator::SMAIndicator(qsizetype period)
+    : _window(std::max<qsizetype>(period, 1), 0.0)
+{
+}
+
+void SMAIndicator::append(double value)
+{
+    _sum += value - _window[_pos];
+    _window[_pos] = value;
+    _pos = (_pos + 1) % _window.size();
+    ++_count;
+
+    //раз в period значений пересчитываем сумму - в среднем O(1) на значение
+    if (_pos == 0)
+    {
+        resum();
+    }
+}
+
+void SMAIndicator::clear()
+{
+    _window.fill(0.0);
+    _pos = 0;
+    _count = 0;
+    _sum = 0.0;
+}
+
+bool SMAIndicator::isReady() const
+{
+    return _count >= _window.size();
+}
+
+double SMAIndicator::value() const
+{
+    if (_count == 0)
+    {
+        return 0.0;
+    }
+
+    return _sum / static_cast<double>(std::min(_count, _window.size()));
+}
+
+void SMAIndicator::resum()
+{
+    _sum = 0.0;
+    for (const auto value: _window)
+    {
+        _sum += value;
+    }
+}
+
+EMAIndicator::EMAIndicator(qsizetype period)
+    : _period(std::max<qsizetype>(period, 1))
+    , _alpha(2.0 / (static_cast<double>(_period) + 1.0))
+{
+}
+
+void EMAIndicator::append(double value)
+{
+    ++_count;
+
+    if (_count <= _period)
+    {
+        //пока не накоплено period значений - считаем простое среднее
+        _value += (value - _value) / static_cast<double>(_count);
+
+        return;
+    }
+
+    _value += _alpha * (value - _value);
+}
+
+void EMAIndicator::clear()
+{
+    _count = 0;
+    _value = 0.0;
+}
+
+bool EMAIndicator::isReady() const
+{
+    return _count >= _period;
+}
+
+double EMAIndicator::value() const
+{
+    return _value;
+}
+
+RSIIndicator::RSIIndicator(qsizetype period)
+    : _period(std::max<qsizetype>(period, 1))
+{
+}
+
+void RSIIndicator::append(const KLine &kline)
+{
+    //первая свеча задает только цену закрытия для расчета изменения
+    if (!_hasPrevClose)
+    {
+        _prevClose = kline.close;
+        _hasPrevClose = true;
+
+        return;
+    }
+
+    const auto change = kline.close - _prevClose;
+    const auto gain = std::max(change, 0.0);
+    const auto loss = std::max(-change, 0.0);
+    _prevClose = kline.close;
+
+    ++_count;
+
+    if (_count <= _period)
+    {
+        _avgGain += (gain - _avgGain) / static_cast<double>(_count);
+        _avgLoss += (loss - _avgLoss) / static_cast<double>(_count);
+
+        return;
+    }
+
+    _avgGain = (_avgGain * static_cast<double>(_period - 1) + gain) / static_cast<double>(_period);
+    _avgLoss = (_avgLoss * static_cast<double>(_period - 1) + loss) / static_cast<double>(_period);
+}
+
+void RSIIndicator::clear()
+{
+    _count = 0;
+    _hasPrevClose = false;
+    _prevClose = 0.0;
+    _avgGain = 0.0;
+    _avgLoss = 0.0;
+}
+
+bool RSIIndicator::isReady() const
+{
+    return _count >= _period;
+}
+
+double RSIIndicator::value() const
+{
+    if (_avgLoss == 0.0)
+    {
+        return _avgGain == 0.0 ? 50.0 : 100.0;
+    }
+
+    return 100.0 - 100.0 / (1.0 + _avgGain / _avgLoss);
+}
+
+BollingerIndicator::BollingerIndicator(qsizetype period, double k)
+    : _k(k)
+    , _window(std::max<qsizetype>(period, 1), 0.0)
+{
+}
+
+void BollingerIndicator::append(double value)
+{
+    const auto old = _window[_pos];
+    _sum += value - old;
+    _sumSq += value * value - old * old;
+    _window[_pos] = value;
+    _pos = (_pos + 1) % _window.size();
+    ++_count;
+
+    if (_pos == 0)
+    {
+        resum();
+    }
+}
+
+void BollingerIndicator::clear()
+{
+    _window.fill(0.0);
+    _pos = 0;
+    _count = 0;
+    _sum = 0.0;
+    _sumSq = 0.0;
+}
+
+bool BollingerIndicator::isReady() const
+{
+    return _count >= _window.size();
+}
+
+double BollingerIndicator::middle() const
+{
+    if (_count == 0)
+    {
+        return 0.0;
+    }
+
+    return _sum / static_cast<double>(std::min(_count, _window.size()));
+}
+
+double BollingerIndicator::upper() const
+{
+    return middle() + _k * deviation();
+}
+
+double BollingerIndicator::lower() const
+{
+    return middle() - _k * deviation();
+}
+
+void BollingerIndicator::resum()
+{
+    _sum = 0.0;
+    _sumSq = 0.0;
+    for (const auto value: _window)
+    {
+        _sum += value;
+        _sumSq += value * value;
+    }
+}
+
+double BollingerIndicator::deviation() const
+{
+    if (_count == 0)
+    {
+        return 0.0;
+    }
+
+    const auto count = static_cast<double>(std::min(_count, _window.size()));
+    const auto mean = _sum / count;
+
+    //из-за округления дисперсия может получиться чуть меньше нуля
+    return std::sqrt(std::max(_sumSq / count - mean * mean, 0.0));
+}
+
+ATRIndicator::ATRIndicator(qsizetype period)
+    : _period(std::max<qsizetype>(period, 1))
+{
+}
+
+void ATRIndicator::append(const KLine &kline)
+{
+    auto trueRange = kline.high - kline.low;
+    if (_count > 0)
+    {
+        trueRange = std::max({trueRange, std::abs(kline.high - _prevClose), std::abs(kline.low - _prevClose)});
+    }
+    _prevClose = kline.close;
+
+    ++_count;
+
+    if (_count <= _period)
+    {
+        _value += (trueRange - _value) / static_cast<double>(_count);
+
+        return;
+    }
+
+    _value = (_value * static_cast<double>(_period - 1) + trueRange) / static_cast<double>(_period);
+}
+
+void ATRIndicator::clear()
+{
+    _count = 0;
+    _prevClose = 0.0;
+    _value = 0.0;
+}
+
+bool ATRIndicator::isReady() const
+{
+    return _count >= _period;
+}
+
+double ATRIndicator::value() const
+{
+    return _value;
+}
+
+void VWAPIndicator::append(const KLine &kline)
+{
+    const auto price = (kline.high + kline.low + kline.close) / 3.0;
+
+    _sumPriceVolume += price * kline.volume;
+    _sumVolume += kline.volume;
+    _lastPrice = price;
+    _isReady = true;
+}
+
+void VWAPIndicator::clear()
+{
+    _sumPriceVolume = 0.0;
+    _sumVolume = 0.0;
+    _lastPrice = 0.0;
+    _isReady = false;
+}
+
+bool VWAPIndicator::isReady() const
+{
+    return _isReady;
+}
+
+double VWAPIndicator::value() const
+{
+    if (_sumVolume <= 0.0)
+    {
+        return _lastPrice;
+    }
+
+    return _sumPriceVolume / _sumVolume;
+}
+
 size_t qHash(const KLineID &key, size_t seed)
 {
     return qHash(key.symbol) + 47 * static_cast<quint64>(key.type);
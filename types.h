@@ -6,6 +6,7 @@
 #include <QVector>
 #include <QString>
 #include <QSet>
+#include <QMap>
 #include <QHostAddress>
 
 enum class KLineType: qint64 //Тип свечи
@@ -74,4 +75,139 @@ double volumeKLine(const KLine &kline);
 
 using KLines = QVector<KLine>;
 
+//Индикаторы. Состояние обновляется за O(1) на каждую новую свечу, свечи подаются по возрастанию времени
+
+class SMAIndicator //простая скользящая средняя
+{
+public:
+    explicit SMAIndicator(qsizetype period);
+
+    void append(double value);
+    void clear();
+
+    bool isReady() const; //накоплено period значений
+    double value() const;
+
+private:
+    void resum(); //пересчет суммы окна, чтобы не накапливалась ошибка округления
+
+private:
+    QVector<double> _window; //кольцевой буфер последних period значений
+    qsizetype _pos = 0;
+    qsizetype _count = 0;
+    double _sum = 0.0;
+};
+
+class EMAIndicator //экспоненциальная скользящая средняя. Первое значение - SMA первых period значений
+{
+public:
+    explicit EMAIndicator(qsizetype period);
+
+    void append(double value);
+    void clear();
+
+    bool isReady() const;
+    double value() const;
+
+private:
+    const qsizetype _period = 0;
+    const double _alpha = 0.0;
+    qsizetype _count = 0;
+    double _value = 0.0;
+};
+
+class RSIIndicator //индекс относительной силы со сглаживанием Уайлдера
+{
+public:
+    explicit RSIIndicator(qsizetype period = 14);
+
+    void append(const KLine& kline);
+    void clear();
+
+    bool isReady() const;
+    double value() const; //0..100
+
+private:
+    const qsizetype _period = 0;
+    qsizetype _count = 0; //количество изменений цены
+    bool _hasPrevClose = false;
+    double _prevClose = 0.0;
+    double _avgGain = 0.0;
+    double _avgLoss = 0.0;
+};
+
+class BollingerIndicator //полосы Боллинджера: SMA +- k стандартных отклонений
+{
+public:
+    explicit BollingerIndicator(qsizetype period = 20, double k = 2.0);
+
+    void append(double value);
+    void clear();
+
+    bool isReady() const;
+    double middle() const;
+    double upper() const;
+    double lower() const;
+
+private:
+    void resum();
+    double deviation() const;
+
+private:
+    const double _k = 2.0;
+    QVector<double> _window;
+    qsizetype _pos = 0;
+    qsizetype _count = 0;
+    double _sum = 0.0;
+    double _sumSq = 0.0;
+};
+
+class ATRIndicator //средний истинный диапазон со сглаживанием Уайлдера
+{
+public:
+    explicit ATRIndicator(qsizetype period = 14);
+
+    void append(const KLine& kline);
+    void clear();
+
+    bool isReady() const;
+    double value() const;
+
+private:
+    const qsizetype _period = 0;
+    qsizetype _count = 0;
+    double _prevClose = 0.0;
+    double _value = 0.0;
+};
+
+class VWAPIndicator //средневзвешенная по объему цена с начала истории
+{
+public:
+    void append(const KLine& kline);
+    void clear();
+
+    bool isReady() const;
+    double value() const;
+
+private:
+    double _sumPriceVolume = 0.0;
+    double _sumVolume = 0.0;
+    double _lastPrice = 0.0; //используется пока объем равен 0
+    bool _isReady = false;
+};
+
+struct KLineData //событие, обнаруженное сервером или локально (SpikeDetector)
+{
+    StockExchangeID stockExchangeID;
+    double delta = 0.0;
+    double volume = 0.0;
+    KLines history;
+    KLines reviewHistory;
+    bool isLocal = false; //событие найдено клиентом, сервер о нем не сообщал
+};
+
+using ExistIntervals = QSet<QString>; //список интервалов монеты
+using ExistsKLines = QMap<QString, ExistIntervals>; //список монет биржи
+using ExistsStockExchange = QMap<QString, ExistsKLines>; //список бирж
+
 #endif // TYPES_H